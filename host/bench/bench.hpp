@@ -0,0 +1,60 @@
+#pragma once
+// A tiny benchmark harness for host builds. Results are printed as: name, threads, iterations, ns/op.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace bench {
+    /// @brief Prevents the compiler from optimizing away a computed value.
+    template<class T>
+    inline void DoNotOptimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void Report(std::string_view name, std::size_t threads, std::size_t iterations, double ns) {
+        printf("%-48.*s %3zu threads %10zu iters %12.1f ns/op\n", static_cast<int>(name.size()), name.data(), threads, iterations, ns / iterations);
+    }
+
+    /// @brief Runs fn(i) for i in [0, iterations) on the calling thread and reports the mean time per call.
+    template<class F>
+    void Run(std::string_view name, std::size_t iterations, F&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++) {
+            fn(i);
+        }
+        auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        Report(name, 1, iterations, ns);
+    }
+
+    /// @brief Runs fn(i) for i in [0, iterations) on each of the provided number of threads at once.
+    /// Reports the wall time per call, as seen by a single thread, so contention shows up as a higher ns/op.
+    template<class F>
+    void RunContended(std::string_view name, std::size_t threads, std::size_t iterations, F&& fn) {
+        std::atomic<std::size_t> ready = 0;
+        std::atomic<bool> go = false;
+        std::vector<double> times(threads);
+        std::vector<std::thread> workers;
+        for (std::size_t t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                ready++;
+                while (!go.load(std::memory_order_acquire)) {}
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < iterations; i++) {
+                    fn(i);
+                }
+                times[t] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            });
+        }
+        while (ready.load() != threads) {}
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        Report(name, threads, iterations, *std::max_element(times.begin(), times.end()));
+    }
+}
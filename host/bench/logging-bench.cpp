@@ -0,0 +1,162 @@
+// Throughput and latency benchmark for Logger, LoggerBuffer and the file consumer thread.
+// Usage: beatsaber-hook-logging-bench [--logcat]
+// Logcat output (stderr on host) is discarded unless --logcat is passed, the formatting cost is still paid.
+// For every producer count, message size and pressure level this reports:
+// - the p50/p99/max latency of a single Logger::info call, as seen by the producer
+// - the rate at which producers could enqueue messages
+// - how long the consumer took to drain everything to the log file after the producers were done
+// File logs are written under LOG_PATH, which the host build points at /tmp.
+
+#include "../../shared/utils/logging.hpp"
+#include "../../shared/utils/utils-functions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+namespace {
+    using steady = std::chrono::steady_clock;
+
+    constexpr std::size_t totalMessages = 16384;
+    constexpr auto drainTimeout = std::chrono::seconds(30);
+
+    struct Pressure {
+        const char* name;
+        // Messages logged back to back before a producer pauses, 0 for never pausing.
+        std::size_t burst;
+        std::chrono::microseconds pause;
+    };
+
+    // Light: well below the consumer's 500us poll. Bursty: a frame's worth of messages at a time. Saturated: as fast as possible.
+    constexpr Pressure pressures[] = {
+        {"light", 1, std::chrono::microseconds(200)},
+        {"bursty", 64, std::chrono::microseconds(2000)},
+        {"saturated", 0, std::chrono::microseconds(0)},
+    };
+    constexpr std::size_t threadCounts[] = {1, 2, 4, 8};
+    constexpr std::size_t messageSizes[] = {16, 128, 1024};
+
+    std::string globalLogPath() {
+        return LoggerBuffer(ModInfo{"GlobalLog", VERSION}).get_path();
+    }
+
+    off_t fileSize(std::string const& path) {
+        struct stat st;
+        return stat(path.c_str(), &st) == 0 ? st.st_size : -1;
+    }
+
+    uint64_t percentile(std::vector<uint32_t> const& sorted, double p) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        return sorted[std::min(sorted.size() - 1, static_cast<std::size_t>(p * sorted.size()))];
+    }
+
+    /// @brief Logs totalMessages messages from the provided number of threads, and reports the producer latency.
+    /// If the logger logs to file, also waits until the file contains every message, and reports the drain time.
+    void run(const char* mode, bool toFile, std::size_t threads, std::size_t size, Pressure const& pressure) {
+        static std::size_t id = 0;
+        ModInfo info{"logging-bench-" + std::to_string(id++), "1.0.0"};
+        auto& logger = *new Logger(info, LoggerOptions(false, toFile));
+        std::string payload(size, 'x');
+        auto perThread = totalMessages / threads;
+
+        std::vector<std::vector<uint32_t>> latencies(threads);
+        std::atomic<std::size_t> ready = 0;
+        std::atomic<bool> go = false;
+        std::vector<std::thread> producers;
+        for (std::size_t t = 0; t < threads; t++) {
+            latencies[t].reserve(perThread);
+            producers.emplace_back([&, t] {
+                ready++;
+                while (!go.load(std::memory_order_acquire)) {}
+                for (std::size_t i = 0; i < perThread; i++) {
+                    auto start = steady::now();
+                    logger.info("%s", payload.c_str());
+                    latencies[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(steady::now() - start).count());
+                    if (pressure.burst && (i + 1) % pressure.burst == 0) {
+                        std::this_thread::sleep_for(pressure.pause);
+                    }
+                }
+            });
+        }
+        while (ready.load() != threads) {}
+        auto start = steady::now();
+        go.store(true, std::memory_order_release);
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        auto produced = steady::now();
+
+        // Every line is "MM-DD HH:MM:SS.mmm INFO <tag>: <payload>\n".
+        auto tag = "QuestHook[" + info.id + "|v" + info.version + "]";
+        off_t expected = (18 + 1 + strlen("INFO") + 1 + tag.size() + 2 + size + 1) * perThread * threads;
+        auto drained = produced;
+        bool timedOut = false;
+        if (toFile) {
+            auto path = LoggerBuffer(info).get_path();
+            while (fileSize(path) < expected) {
+                if (steady::now() - produced > drainTimeout) {
+                    timedOut = true;
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+            drained = steady::now();
+            // Keep /tmp from filling up across configurations.
+            logger.close();
+            deletefile(path);
+            std::ofstream(globalLogPath(), std::ios::trunc);
+        }
+
+        std::vector<uint32_t> all;
+        all.reserve(perThread * threads);
+        for (auto& l : latencies) {
+            all.insert(all.end(), l.begin(), l.end());
+        }
+        std::sort(all.begin(), all.end());
+        auto produceSecs = std::chrono::duration<double>(produced - start).count();
+        auto totalSecs = std::chrono::duration<double>(drained - start).count();
+        printf("%-7s %-9s %2zu threads %5zu B | p50 %7lu ns p99 %8lu ns max %9lu ns | produce %10.0f msg/s",
+            mode, pressure.name, threads, size, percentile(all, 0.5), percentile(all, 0.99), static_cast<uint64_t>(all.back()), all.size() / produceSecs);
+        if (toFile) {
+            if (timedOut) {
+                printf(" | drain TIMED OUT");
+            } else {
+                printf(" | drain %8.2f ms, end-to-end %10.0f msg/s", std::chrono::duration<double, std::milli>(drained - produced).count(), all.size() / totalSecs);
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv) {
+    bool logcat = argc > 1 && strcmp(argv[1], "--logcat") == 0;
+    if (!logcat && !freopen("/dev/null", "w", stderr)) {
+        return 1;
+    }
+    printf("%zu messages per configuration, logs in %s\n", totalMessages, LoggerBuffer::get_logDir().c_str());
+    for (auto const& pressure : pressures) {
+        for (auto threads : threadCounts) {
+            for (auto size : messageSizes) {
+                run("logcat", false, threads, size, pressure);
+            }
+        }
+    }
+    for (auto const& pressure : pressures) {
+        for (auto threads : threadCounts) {
+            for (auto size : messageSizes) {
+                run("file", true, threads, size, pressure);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+// Microbenchmarks for the il2cpp_utils lookup, invoke and field access paths, run against the mock libil2cpp.
+// Usage: beatsaber-hook-bench [threads]
+// Cold runs hit every class exactly once, so each lookup misses the caches. Warm runs repeat the same lookup.
+// Contended runs repeat the warm lookups from several threads at once, to expose lock contention in the caches.
+// Set BS_HOOK_HOST_PROFILE=out.folded to run under SamplingProfiler, BS_HOOK_HOST_SNAPSHOT=out.bhms to write a small memory snapshot at the end,
+// and BS_HOOK_HOST_METADATA=out.bhmd to write a metadata dump of the mock classes.
+
+#include "bench.hpp"
+#include "../mock/mock-il2cpp.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include "../../shared/utils/il2cpp-utils-profiling.hpp"
+#include "../../shared/utils/il2cpp-utils-snapshot.hpp"
+#include "../../shared/utils/il2cpp-utils-metadata-dump.hpp"
+#include "../../shared/utils/il2cpp-utils-attributes.hpp"
+#include "../../shared/utils/gc-alloc.hpp"
+#include "../../shared/utils/profiler.hpp"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+    constexpr std::size_t namespaceCount = 16;
+    constexpr std::size_t classesPerNamespace = 64;
+    constexpr std::size_t classCount = namespaceCount * classesPerNamespace;
+    // Roughly the shape of a typical game class: a few dozen methods, a dozen fields and properties.
+    constexpr std::size_t methodsPerClass = 32;
+    constexpr std::size_t fieldsPerClass = 12;
+    constexpr std::size_t propertiesPerClass = 8;
+    constexpr std::size_t warmIterations = 200000;
+    constexpr std::size_t contendedIterations = 50000;
+
+    struct BenchClass {
+        std::string nameSpace;
+        std::string name;
+        Il2CppClass* klass;
+    };
+
+    std::vector<BenchClass> classes;
+    // Given to every eighth class, the way mods mark the types they discover at startup.
+    Il2CppClass* benchAttribute;
+
+    int32_t& valueField(void* obj) {
+        return *reinterpret_cast<int32_t*>(reinterpret_cast<uint8_t*>(obj) + sizeof(Il2CppObject));
+    }
+
+    void* ctorInvoker(Il2CppMethodPointer, const MethodInfo*, void* obj, void** args) {
+        valueField(obj) = *reinterpret_cast<int32_t*>(args[0]);
+        return nullptr;
+    }
+
+    void* addInvoker(Il2CppMethodPointer, const MethodInfo*, void* obj, void** args) {
+        int32_t result = valueField(obj) + *reinterpret_cast<int32_t*>(args[0]);
+        return il2cpp_functions::value_box(il2cpp_functions::defaults->int32_class, &result);
+    }
+
+    void populate() {
+        auto& defaults = mock_il2cpp::Defaults();
+        auto* int32 = defaults.int32_class;
+        auto* single = defaults.single_class;
+        auto* string = defaults.string_class;
+        auto* object = defaults.object_class;
+        benchAttribute = mock_il2cpp::AddClass("Bench", "BenchAttribute");
+        classes.reserve(classCount);
+        for (std::size_t n = 0; n < namespaceCount; n++) {
+            auto nameSpace = "Bench.Namespace" + std::to_string(n);
+            for (std::size_t c = 0; c < classesPerNamespace; c++) {
+                auto name = "BenchClass" + std::to_string(c);
+                auto* klass = mock_il2cpp::AddClass(nameSpace, name);
+                // The value field comes first, so it is right after the object header.
+                mock_il2cpp::AddField(klass, "value", int32);
+                for (std::size_t f = 1; f < fieldsPerClass; f++) {
+                    mock_il2cpp::AddField(klass, "field" + std::to_string(f), f % 2 ? single : object);
+                }
+                // Filler methods first, so the benchmarked ones are found at the end of the method list.
+                for (std::size_t m = 0; m < methodsPerClass; m++) {
+                    mock_il2cpp::AddMethod(klass, "Method" + std::to_string(m), m % 3 ? int32 : nullptr, {m % 2 ? int32 : string});
+                }
+                for (std::size_t p = 0; p < propertiesPerClass; p++) {
+                    auto* getter = mock_il2cpp::AddMethod(klass, "get_Property" + std::to_string(p), int32, {});
+                    auto* setter = mock_il2cpp::AddMethod(klass, "set_Property" + std::to_string(p), nullptr, {int32});
+                    mock_il2cpp::AddProperty(klass, "Property" + std::to_string(p), getter, setter);
+                }
+                mock_il2cpp::AddMethod(klass, "Add", int32, {int32, int32});
+                mock_il2cpp::AddMethod(klass, "Add", int32, {int32}, addInvoker);
+                mock_il2cpp::AddMethod(klass, ".ctor", nullptr, {int32}, ctorInvoker, METHOD_ATTRIBUTE_PUBLIC | METHOD_ATTRIBUTE_SPECIAL_NAME | METHOD_ATTRIBUTE_RT_SPECIAL_NAME);
+                if (c % 8 == 0) {
+                    mock_il2cpp::AddAttribute(klass, benchAttribute);
+                }
+                classes.push_back({nameSpace, name, klass});
+            }
+        }
+    }
+
+    void benchLookups(std::size_t threads) {
+        auto* argType = il2cpp_functions::class_get_type(il2cpp_functions::defaults->int32_class);
+        std::array<const Il2CppType*, 1> argTypes{argType};
+        auto& last = classes.back();
+
+        bench::Run("GetClassFromName (cold)", classCount, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::GetClassFromName(classes[i].nameSpace, classes[i].name));
+        });
+        bench::Run("GetClassFromName (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::GetClassFromName(last.nameSpace, last.name));
+        });
+        bench::RunContended("GetClassFromName (contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::GetClassFromName(last.nameSpace, last.name));
+        });
+
+        // The first call builds the name index.
+        bench::Run("FindClasses (prefix)", warmIterations / 100, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindClasses(last.name).size());
+        });
+        bench::Run("FindClasses (namespace)", warmIterations / 100, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindClasses(last.nameSpace, il2cpp_utils::ClassNameQuery::Namespace).size());
+        });
+        bench::Run("FindClasses (wildcard)", warmIterations / 100, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindClasses(last.nameSpace + ".*Class1?", il2cpp_utils::ClassNameQuery::Wildcard).size());
+        });
+
+        bench::Run("FindMethod (cold)", classCount, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::FindMethod(classes[i].klass, "Add", argTypes));
+        });
+        bench::Run("FindMethod (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindMethod(last.klass, "Add", argTypes));
+        });
+        bench::RunContended("FindMethod (contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindMethod(last.klass, "Add", argTypes));
+        });
+        bench::Run("FindMethodUnsafe (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindMethodUnsafe(last.klass, "Add", 1));
+        });
+
+        bench::Run("FindField (cold)", classCount, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::FindField(classes[i].klass, "value"));
+        });
+        bench::Run("FindField (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindField(last.klass, "value"));
+        });
+        bench::RunContended("FindField (contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindField(last.klass, "value"));
+        });
+
+        bench::Run("FindProperty (cold)", classCount, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::FindProperty(classes[i].klass, "Property7"));
+        });
+        bench::Run("FindProperty (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindProperty(last.klass, "Property7"));
+        });
+        bench::RunContended("FindProperty (contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindProperty(last.klass, "Property7"));
+        });
+
+        bench::Run("HasAttribute (cold)", classCount, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::HasAttribute(classes[i].klass, benchAttribute));
+        });
+        bench::Run("HasAttribute (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::HasAttribute(last.klass, benchAttribute));
+        });
+        bench::RunContended("HasAttribute (contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::HasAttribute(last.klass, benchAttribute));
+        });
+        bench::Run("GetAttribute (warm)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::GetAttribute(classes.front().klass, benchAttribute));
+        });
+        bench::Run("FindClassesWithAttribute", 100, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::FindClassesWithAttribute(benchAttribute, static_cast<uint32_t>(threads)).size());
+        });
+    }
+
+    void benchInvoke(std::size_t threads) {
+        auto& last = classes.back();
+        auto* instance = CRASH_UNLESS(il2cpp_utils::New(last.klass, 1));
+        auto* add = il2cpp_utils::FindMethodUnsafe(last.klass, "Add", 1);
+        auto* field = il2cpp_utils::FindField(last.klass, "value");
+        int32_t arg = 2;
+
+        bench::Run("RunMethod (checked)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::RunMethod<int32_t>(instance, add, arg));
+        });
+        bench::Run("RunMethod (unchecked)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::RunMethodUnsafe<int32_t>(instance, add, arg));
+        });
+        bench::Run("RunMethod by name", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::RunMethod<int32_t>(instance, "Add", arg));
+        });
+        bench::RunContended("RunMethod (checked, contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::RunMethod<int32_t>(instance, add, arg));
+        });
+
+        // The same calls with MethodProfiler recording them, to measure the enter/leave callback overhead.
+        il2cpp_utils::MethodProfiler::Start(il2cpp_utils::MethodProfilerFilter{{last.klass}, {}});
+        bench::Run("RunMethod (unchecked, MethodProfiler)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::RunMethodUnsafe<int32_t>(instance, add, arg));
+        });
+        bench::RunContended("RunMethod (unchecked, MethodProfiler, contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::RunMethodUnsafe<int32_t>(instance, add, arg));
+        });
+        il2cpp_utils::MethodProfiler::Stop();
+        static auto logger = Logger::get().WithContext("MethodProfiler");
+        il2cpp_utils::MethodProfiler::Log(logger, 5);
+
+        bench::Run("GetFieldValue (FieldInfo)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::GetFieldValue<int32_t>(instance, field));
+        });
+        bench::Run("GetFieldValue (by name)", warmIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::GetFieldValue<int32_t>(instance, "value"));
+        });
+        bench::RunContended("GetFieldValue (by name, contended)", threads, contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::GetFieldValue<int32_t>(instance, "value"));
+        });
+
+        // The mock never collects, so keep the allocation counts modest.
+        bench::Run("New (cold)", classCount, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::New(classes[i].klass, arg));
+        });
+        bench::Run("New (warm)", contendedIterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::New(last.klass, arg));
+        });
+        bench::RunContended("New (contended)", threads, contendedIterations / threads, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::New(last.klass, arg));
+        });
+
+        // The same allocations with GcTelemetry counting them, to measure the allocation callback overhead.
+        il2cpp_utils::GcTelemetry::Start();
+        bench::Run("New (warm, GcTelemetry)", contendedIterations, [&](std::size_t i) {
+            bench::DoNotOptimize(il2cpp_utils::New(classes[i % classCount].klass, arg));
+        });
+        bench::RunContended("New (contended, GcTelemetry)", threads, contendedIterations / threads, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::New(last.klass, arg));
+        });
+        bench::Run("gc_collect (GcTelemetry)", 1000, [&](std::size_t) {
+            il2cpp_functions::gc_collect(0);
+        });
+        il2cpp_utils::GcTelemetry::Stop();
+        static auto gcLogger = Logger::get().WithContext("GcTelemetry");
+        il2cpp_utils::GcTelemetry::Log(gcLogger, 5);
+    }
+
+    // Builds a small graph (chains of objects, each chain held by a SafePtr or a GC handle) and snapshots it.
+    void snapshot(const char* path) {
+        // Only allocations from here on are in the snapshot, so the benchmarks above are not slowed down by the tracking.
+        mock_il2cpp::TrackHeap(true);
+        gc_accounting::SetEnabled(true);
+        constexpr std::size_t chains = 16;
+        constexpr std::size_t chainLength = 32;
+        std::vector<SafePtr<Il2CppObject>> held;
+        for (std::size_t c = 0; c < chains; c++) {
+            Il2CppObject* next = nullptr;
+            for (std::size_t i = 0; i < chainLength; i++) {
+                auto* obj = CRASH_UNLESS(il2cpp_utils::New(classes[(c * chainLength + i) % classCount].klass, static_cast<int32_t>(i)));
+                il2cpp_utils::SetFieldValue(obj, "field2", next);
+                next = obj;
+            }
+            if (c % 2) {
+                held.emplace_back(next);
+            } else {
+                il2cpp_functions::gchandle_new(next, false);
+            }
+        }
+        if (il2cpp_utils::MemorySnapshot::Capture(path) && il2cpp_utils::MemorySnapshot::Wait()) {
+            printf("snapshot of %zu objects written to %s\n", chains * chainLength, path);
+        }
+        gc_accounting::SetEnabled(false);
+        mock_il2cpp::TrackHeap(false);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t threads = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : std::thread::hardware_concurrency();
+    if (threads == 0) {
+        threads = 4;
+    }
+    il2cpp_functions::Init();
+    populate();
+    printf("%zu classes, %zu methods, %zu fields and %zu properties each\n", classCount, methodsPerClass + 2 * propertiesPerClass + 3, fieldsPerClass, propertiesPerClass);
+    auto* profile = getenv("BS_HOOK_HOST_PROFILE");
+    if (profile) {
+        SamplingProfiler::Start(profile);
+    }
+    benchLookups(threads);
+    benchInvoke(threads);
+    if (profile) {
+        auto stats = SamplingProfiler::GetStats();
+        auto path = SamplingProfiler::Stop();
+        printf("profile: %lu samples (%lu dropped), %lu stacks written to %s\n", static_cast<unsigned long>(stats.samples), static_cast<unsigned long>(stats.dropped), static_cast<unsigned long>(stats.stacks), path.c_str());
+    }
+    if (auto* snapshotPath = getenv("BS_HOOK_HOST_SNAPSHOT")) {
+        snapshot(snapshotPath);
+    }
+    if (auto* metadataPath = getenv("BS_HOOK_HOST_METADATA")) {
+        if (il2cpp_utils::MetadataDump::Write(metadataPath, threads)) {
+            printf("metadata dump written to %s\n", metadataPath);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,3 @@
+#pragma once
+// Forwards the qpm capstone include path to the system capstone (4.x or 5.x), for the host xref harness only.
+#include <capstone/capstone.h>
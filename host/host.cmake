@@ -0,0 +1,116 @@
+# Host (x86-64 Linux) build of the portable parts of beatsaber-hook, against a mock libil2cpp.
+# Configure with: cmake -S . -B build-host -DHOST_BUILD=1
+# The libil2cpp, modloader and rapidjson headers are still required, point the variables below at a qpm restored tree if needed.
+
+cmake_minimum_required(VERSION 3.22)
+project(beatsaber-hook-host CXX)
+
+set(CMAKE_CXX_STANDARD 20)
+set(CMAKE_CXX_STANDARD_REQUIRED 20)
+set(CMAKE_POSITION_INDEPENDENT_CODE ON)
+set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
+if (NOT CMAKE_BUILD_TYPE)
+    set(CMAKE_BUILD_TYPE RelWithDebInfo)
+endif()
+
+set(HOST_DIR ${CMAKE_CURRENT_SOURCE_DIR}/host)
+set(SOURCE_DIR ${CMAKE_CURRENT_SOURCE_DIR}/src)
+set(SHARED_DIR ${CMAKE_CURRENT_SOURCE_DIR}/shared)
+set(EXTERN_DIR ${CMAKE_CURRENT_SOURCE_DIR}/extern)
+set(IL2CPP_INCLUDE_DIR ${EXTERN_DIR}/includes/libil2cpp/il2cpp/libil2cpp CACHE PATH "libil2cpp headers")
+
+add_compile_options(-frtti -fexceptions)
+add_compile_options(-Wall -Wextra -Werror -Wno-unused-function)
+# SamplingProfiler walks frame pointers, which x86-64 omits by default (arm64 Android keeps them).
+add_compile_options(-fno-omit-frame-pointer)
+add_compile_definitions(VERSION=\"host\")
+add_compile_definitions(ID=\"beatsaber-hook\")
+add_compile_definitions(UNITY_2019)
+add_compile_definitions(BS_HOOK_HOST_BUILD)
+# File logs go next to the host mods dir instead of /sdcard.
+add_compile_definitions(LOG_PATH=\"/tmp/bs-hook-host/%s/logs/\")
+
+# Host shims (android/log.h, modloader) come first so they shadow any restored Android headers.
+include_directories(BEFORE ${HOST_DIR}/include)
+include_directories(${CMAKE_CURRENT_SOURCE_DIR} ${SHARED_DIR} ${EXTERN_DIR}/includes ${IL2CPP_INCLUDE_DIR})
+
+# The mock runtime, named so that il2cpp_functions::Init dlopens it as libil2cpp.so.
+add_library(il2cpp SHARED ${HOST_DIR}/mock/mock-il2cpp.cpp)
+target_compile_options(il2cpp PRIVATE -fvisibility=hidden)
+
+# Everything that does not depend on capstone, inline hooking or ARM64 code.
+add_library(beatsaber-hook-host STATIC
+    ${SOURCE_DIR}/utils/gc-alloc.cpp
+    ${SOURCE_DIR}/utils/il2cpp-functions.cpp
+    ${SOURCE_DIR}/utils/il2cpp-type-check.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-attributes.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-classes.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-class-index.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-exceptions.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-fields.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-metadata-dump.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-metadata-reader.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-method-index.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-methods.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-properties.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-profiling.cpp
+    ${SOURCE_DIR}/utils/il2cpp-utils-snapshot.cpp
+    ${SOURCE_DIR}/utils/logging.cpp
+    ${SOURCE_DIR}/utils/profiler.cpp
+    ${SOURCE_DIR}/utils/typedefs-wrapper.cpp
+    ${SOURCE_DIR}/utils/utils.cpp
+    ${SOURCE_DIR}/config/config-utils.cpp
+    ${HOST_DIR}/mock/modloader-stub.cpp
+)
+target_link_libraries(beatsaber-hook-host PUBLIC il2cpp dl pthread)
+
+# Microbenchmarks for the lookup, invoke and field access paths. Run with: build-host/beatsaber-hook-bench [threads]
+# Set BS_HOOK_HOST_PROFILE=path/to/out.folded to run it under SamplingProfiler, BS_HOOK_HOST_SNAPSHOT=path/to/out.bhms to write a memory snapshot,
+# and BS_HOOK_HOST_METADATA=path/to/out.bhmd to write a metadata dump of the mock classes.
+add_executable(beatsaber-hook-bench ${HOST_DIR}/bench/lookup-bench.cpp)
+target_link_libraries(beatsaber-hook-bench PRIVATE beatsaber-hook-host)
+
+# Logger producer latency and file flush throughput. Run with: build-host/beatsaber-hook-logging-bench [--logcat]
+add_executable(beatsaber-hook-logging-bench ${HOST_DIR}/bench/logging-bench.cpp)
+target_link_libraries(beatsaber-hook-logging-bench PRIVATE beatsaber-hook-host)
+
+# Offline analysis of il2cpp_utils::MemorySnapshot files, from a device or the mock. Run with: build-host/beatsaber-hook-snapshot-analyzer snapshot.bhms [--owners] [--paths <type>]
+# Standalone, it only shares the file format header with the library.
+add_executable(beatsaber-hook-snapshot-analyzer ${HOST_DIR}/tools/snapshot-analyzer.cpp)
+
+# Searches il2cpp_utils::MetadataDump files. Run with: build-host/beatsaber-hook-metadata-query metadata.bhmd [--type <text> [--members]] [--method <text>] [--field <text>] [--rva <hex>]
+# Standalone like the snapshot analyzer.
+add_executable(beatsaber-hook-metadata-query ${HOST_DIR}/tools/metadata-query.cpp)
+
+# Checks and measures il2cpp_utils::MetadataReader on a real global-metadata.dat.
+# Run with: build-host/beatsaber-hook-metadata-index global-metadata.dat [--type <Namespace.Name>] [--method <Namespace.Name::Method>] [--field <Namespace.Name::field>] [--bench N]
+add_executable(beatsaber-hook-metadata-index ${HOST_DIR}/tools/metadata-index.cpp)
+target_link_libraries(beatsaber-hook-metadata-index PRIVATE beatsaber-hook-host)
+
+# Relocation corpus, fuzzer and benchmark for And64InlineHook. Run with: build-host/beatsaber-hook-relocation-harness [--corpus] [--fuzz N] [--bench N]
+# The relocator is linked directly (it only needs the __android_log_print shim), not through beatsaber-hook-host.
+add_executable(beatsaber-hook-relocation-harness
+    ${HOST_DIR}/tools/relocation-harness.cpp
+    ${SOURCE_DIR}/inline-hook/And64InlineHook.cpp
+    ${HOST_DIR}/mock/modloader-stub.cpp
+)
+
+# Offline xref/sigscan harness over a real libil2cpp.so, only built when a host capstone (4.x or 5.x) is installed.
+# Run with: build-host/beatsaber-hook-xref-harness path/to/libil2cpp.so [--expect offsets.txt]
+find_path(CAPSTONE_INCLUDE_DIR capstone/capstone.h)
+find_library(CAPSTONE_LIBRARY capstone)
+if (CAPSTONE_INCLUDE_DIR AND CAPSTONE_LIBRARY)
+    add_executable(beatsaber-hook-xref-harness
+        ${HOST_DIR}/tools/xref-harness.cpp
+        ${SOURCE_DIR}/utils/il2cpp-functions.cpp
+        ${SOURCE_DIR}/utils/capstone-utils.cpp
+        ${SOURCE_DIR}/utils/hook-tracker.cpp
+    )
+    # The qpm capstone include paths are forwarded to the system capstone.
+    target_include_directories(beatsaber-hook-xref-harness BEFORE PRIVATE ${HOST_DIR}/capstone/include ${CAPSTONE_INCLUDE_DIR})
+    target_compile_definitions(beatsaber-hook-xref-harness PRIVATE BS_HOOK_HOST_XREFS)
+    target_link_libraries(beatsaber-hook-xref-harness PRIVATE beatsaber-hook-host ${CAPSTONE_LIBRARY})
+else()
+    message(STATUS "Host capstone not found, not building beatsaber-hook-xref-harness")
+endif()
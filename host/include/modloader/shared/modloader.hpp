@@ -0,0 +1,20 @@
+#pragma once
+// Host stand-in for the modloader header, used by HOST_BUILD only.
+// Only the parts beatsaber-hook itself uses are provided, see host/mock/modloader-stub.cpp.
+
+#include <string>
+
+struct ModInfo {
+    std::string id;
+    std::string version;
+};
+
+class Modloader {
+public:
+    /// @brief Returns the path of the (mock) libil2cpp.so to load, BS_HOOK_HOST_IL2CPP if set.
+    static const std::string getLibIl2CppPath();
+    /// @brief Returns the application id used for data and config paths, BS_HOOK_HOST_APP_ID if set.
+    static const std::string getApplicationId();
+    /// @brief Returns the directory mods are loaded from, BS_HOOK_HOST_MODS_DIR if set.
+    static const std::string getDestinationPath();
+};
@@ -0,0 +1,1097 @@
+#include "mock-il2cpp.hpp"
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../../shared/utils/hashing.hpp"
+
+#define MOCK_API extern "C" __attribute__((visibility("default")))
+
+namespace {
+    struct MockClass {
+        Il2CppClass* klass;
+        std::vector<const MethodInfo*> methodPtrs;
+        std::vector<std::unique_ptr<MethodInfo>> methods;
+        std::vector<std::unique_ptr<ParameterInfo[]>> params;
+        std::vector<FieldInfo> fields;
+        std::vector<PropertyInfo> properties;
+        std::unique_ptr<uint8_t[]> staticFields;
+        uint32_t staticFieldsSize = 0;
+        Il2CppClass* arrayClass = nullptr;
+    };
+
+    std::recursive_mutex mockLock;
+    std::deque<std::string> strings;
+    std::vector<std::unique_ptr<MockClass>> classes;
+    std::unordered_map<std::pair<std::string, std::string>, MockClass*, il2cpp_utils::hash_pair> classesByName;
+    std::unordered_map<const Il2CppClass*, MockClass*> classData;
+    std::unordered_map<const Il2CppType*, Il2CppClass*> typeToClass;
+    // The attribute classes of each class or method, in declaration order.
+    std::unordered_map<const void*, std::vector<Il2CppClass*>> attributes;
+    std::vector<Il2CppObject*> gcHandles;
+    std::vector<uint32_t> freeHandles;
+    // Allocations il2cpp_capture_memory_snapshot reports as heap sections, only recorded while mock_il2cpp::TrackHeap is on.
+    std::atomic<bool> trackHeap = false;
+    std::mutex heapLock;
+    std::unordered_map<void*, std::size_t> heapBlocks;
+
+    Il2CppImage* corlibImage;
+    Il2CppAssembly* corlibAssembly;
+    char domainStorage[64];
+}
+
+// Exported so il2cpp_functions::Init can pick it up in place of the xref-traced il2cpp_defaults.
+extern "C" {
+    __attribute__((visibility("default"))) Il2CppDefaults il2cpp_mock_defaults;
+}
+// Il2CppDefaults has no slot for System.ValueType, so the mock keeps its own.
+static Il2CppClass* valueTypeClass;
+
+static const char* intern(std::string_view str) {
+    return strings.emplace_back(str).c_str();
+}
+
+static Il2CppTypeEnum typeEnumFor(std::string_view nameSpace, std::string_view name, bool valueType) {
+    if (nameSpace == "System") {
+        static const std::unordered_map<std::string_view, Il2CppTypeEnum> builtins = {
+            {"Void", IL2CPP_TYPE_VOID}, {"Boolean", IL2CPP_TYPE_BOOLEAN}, {"Char", IL2CPP_TYPE_CHAR},
+            {"SByte", IL2CPP_TYPE_I1}, {"Byte", IL2CPP_TYPE_U1}, {"Int16", IL2CPP_TYPE_I2}, {"UInt16", IL2CPP_TYPE_U2},
+            {"Int32", IL2CPP_TYPE_I4}, {"UInt32", IL2CPP_TYPE_U4}, {"Int64", IL2CPP_TYPE_I8}, {"UInt64", IL2CPP_TYPE_U8},
+            {"Single", IL2CPP_TYPE_R4}, {"Double", IL2CPP_TYPE_R8}, {"String", IL2CPP_TYPE_STRING},
+            {"IntPtr", IL2CPP_TYPE_I}, {"UIntPtr", IL2CPP_TYPE_U}, {"Object", IL2CPP_TYPE_OBJECT},
+        };
+        auto itr = builtins.find(name);
+        if (itr != builtins.end()) {
+            return itr->second;
+        }
+    }
+    return valueType ? IL2CPP_TYPE_VALUETYPE : IL2CPP_TYPE_CLASS;
+}
+
+// The size a value of this class occupies in a field, array element or argument.
+static uint32_t storageSize(const Il2CppClass* klass) {
+    if (klass->valuetype) {
+        return klass->instance_size - sizeof(Il2CppObject);
+    }
+    return sizeof(void*);
+}
+
+static Il2CppClass* createClass(std::string_view nameSpace, std::string_view name, Il2CppClass* parent, uint32_t fieldsSize, bool valueType) {
+    auto* klass = static_cast<Il2CppClass*>(calloc(1, sizeof(Il2CppClass)));
+    klass->image = corlibImage;
+    klass->name = intern(name);
+    klass->namespaze = intern(nameSpace);
+    klass->klass = klass;
+    klass->parent = parent;
+    klass->castClass = klass;
+    klass->element_class = klass;
+    klass->instance_size = sizeof(Il2CppObject) + fieldsSize;
+    klass->actualSize = klass->instance_size;
+    klass->genericContainerIndex = -1;
+    klass->flags = TYPE_ATTRIBUTE_PUBLIC | (valueType ? TYPE_ATTRIBUTE_SEALED : 0);
+    klass->valuetype = valueType;
+    klass->initialized = true;
+    klass->initialized_and_no_error = true;
+    klass->size_inited = true;
+    klass->is_vtable_initialized = true;
+    klass->cctor_finished = true;
+
+    auto typeEnum = typeEnumFor(nameSpace, name, valueType);
+    klass->byval_arg.data.dummy = klass;
+    klass->byval_arg.type = typeEnum;
+    klass->this_arg.data.dummy = klass;
+    klass->this_arg.type = typeEnum;
+    klass->this_arg.byref = 1;
+    typeToClass.emplace(&klass->byval_arg, klass);
+    typeToClass.emplace(&klass->this_arg, klass);
+
+    auto& data = classes.emplace_back(std::make_unique<MockClass>());
+    data->klass = klass;
+    classData.emplace(klass, data.get());
+    classesByName.insert_or_assign({std::string(nameSpace), std::string(name)}, data.get());
+    return klass;
+}
+
+static void createBuiltins() {
+    corlibImage = static_cast<Il2CppImage*>(calloc(1, sizeof(Il2CppImage)));
+    corlibAssembly = static_cast<Il2CppAssembly*>(calloc(1, sizeof(Il2CppAssembly)));
+    corlibImage->name = "mscorlib.dll";
+    corlibImage->nameNoExt = "mscorlib";
+    corlibImage->assembly = corlibAssembly;
+    corlibAssembly->image = corlibImage;
+
+    auto& d = il2cpp_mock_defaults;
+    memset(&d, 0, sizeof(d));
+    d.corlib = corlibImage;
+    d.object_class = createClass("System", "Object", nullptr, 0, false);
+    valueTypeClass = createClass("System", "ValueType", d.object_class, 0, false);
+    d.enum_class = createClass("System", "Enum", valueTypeClass, 0, false);
+    auto valueType = [&](const char* name, uint32_t size) {
+        return createClass("System", name, valueTypeClass, size, true);
+    };
+    d.void_class = valueType("Void", 0);
+    d.boolean_class = valueType("Boolean", sizeof(bool));
+    d.byte_class = valueType("Byte", sizeof(uint8_t));
+    d.sbyte_class = valueType("SByte", sizeof(int8_t));
+    d.char_class = valueType("Char", sizeof(Il2CppChar));
+    d.int16_class = valueType("Int16", sizeof(int16_t));
+    d.uint16_class = valueType("UInt16", sizeof(uint16_t));
+    d.int32_class = valueType("Int32", sizeof(int32_t));
+    d.uint32_class = valueType("UInt32", sizeof(uint32_t));
+    d.int64_class = valueType("Int64", sizeof(int64_t));
+    d.uint64_class = valueType("UInt64", sizeof(uint64_t));
+    d.single_class = valueType("Single", sizeof(float));
+    d.double_class = valueType("Double", sizeof(double));
+    d.int_class = valueType("IntPtr", sizeof(intptr_t));
+    d.uint_class = valueType("UIntPtr", sizeof(uintptr_t));
+    d.string_class = createClass("System", "String", d.object_class, sizeof(int32_t) + sizeof(Il2CppChar), false);
+    d.array_class = createClass("System", "Array", d.object_class, 0, false);
+    d.exception_class = createClass("System", "Exception", d.object_class, 0, false);
+    d.systemtype_class = createClass("System", "Type", d.object_class, 0, false);
+    d.runtimetype_class = createClass("System", "RuntimeType", d.systemtype_class, 0, false);
+    d.delegate_class = createClass("System", "Delegate", d.object_class, 0, false);
+    d.multicastdelegate_class = createClass("System", "MulticastDelegate", d.delegate_class, 0, false);
+}
+
+static void ensureInit() {
+    static bool initialized = false;
+    if (!initialized) {
+        initialized = true;
+        createBuiltins();
+    }
+}
+
+static MockClass* dataOf(const Il2CppClass* klass) {
+    ensureInit();
+    auto itr = classData.find(klass);
+    return itr != classData.end() ? itr->second : nullptr;
+}
+
+namespace mock_il2cpp {
+    Il2CppClass* AddClass(std::string_view nameSpace, std::string_view name, Il2CppClass* parent, uint32_t fieldsSize, bool valueType) {
+        std::scoped_lock lock(mockLock);
+        ensureInit();
+        if (!parent) {
+            parent = valueType ? valueTypeClass : il2cpp_mock_defaults.object_class;
+        }
+        // Instance fields of the parent come first.
+        return createClass(nameSpace, name, parent, (parent->instance_size - sizeof(Il2CppObject)) + fieldsSize, valueType);
+    }
+
+    const MethodInfo* AddMethod(Il2CppClass* klass, std::string_view name, Il2CppClass* returnType, std::vector<Il2CppClass*> const& params, InvokerMethod invoker, uint16_t flags) {
+        std::scoped_lock lock(mockLock);
+        auto* data = dataOf(klass);
+        auto& method = data->methods.emplace_back(std::make_unique<MethodInfo>());
+        memset(method.get(), 0, sizeof(MethodInfo));
+        auto& paramInfos = data->params.emplace_back(std::make_unique<ParameterInfo[]>(params.size()));
+        for (std::size_t i = 0; i < params.size(); i++) {
+            paramInfos[i].name = intern("arg" + std::to_string(i));
+            paramInfos[i].position = i;
+            paramInfos[i].parameter_type = &params[i]->byval_arg;
+        }
+        method->name = intern(name);
+        method->klass = klass;
+        method->return_type = &(returnType ? returnType : il2cpp_mock_defaults.void_class)->byval_arg;
+        method->parameters = paramInfos.get();
+        method->parameters_count = params.size();
+        method->invoker_method = invoker;
+        method->flags = flags;
+        method->slot = kInvalidIl2CppMethodSlot;
+        data->methodPtrs.push_back(method.get());
+        klass->methods = data->methodPtrs.data();
+        klass->method_count = data->methodPtrs.size();
+        return method.get();
+    }
+
+    FieldInfo* AddField(Il2CppClass* klass, std::string_view name, Il2CppClass* type, bool isStatic) {
+        std::scoped_lock lock(mockLock);
+        auto* data = dataOf(klass);
+        FieldInfo field{};
+        field.name = intern(name);
+        field.type = &type->byval_arg;
+        field.parent = klass;
+        auto size = storageSize(type);
+        if (isStatic) {
+            // Static fields are never moved, so reserve generously up front.
+            constexpr uint32_t staticCapacity = 4096;
+            if (!data->staticFields) {
+                data->staticFields = std::make_unique<uint8_t[]>(staticCapacity);
+                klass->static_fields = data->staticFields.get();
+            }
+            CRASH_UNLESS(data->staticFieldsSize + size <= staticCapacity);
+            field.offset = data->staticFieldsSize;
+            data->staticFieldsSize += size;
+            klass->static_fields_size = data->staticFieldsSize;
+            // Mark static fields the same way il2cpp does, via the type attributes.
+            auto* staticType = static_cast<Il2CppType*>(calloc(1, sizeof(Il2CppType)));
+            *staticType = type->byval_arg;
+            staticType->attrs |= FIELD_ATTRIBUTE_STATIC;
+            typeToClass.emplace(staticType, type);
+            field.type = staticType;
+        } else {
+            field.offset = klass->instance_size;
+            klass->instance_size += size;
+            klass->actualSize = klass->instance_size;
+        }
+        // NOTE: This invalidates previously returned FieldInfo*s of this class, the same as adding fields to a real class would.
+        data->fields.push_back(field);
+        klass->fields = data->fields.data();
+        klass->field_count = data->fields.size();
+        return &data->fields.back();
+    }
+
+    const PropertyInfo* AddProperty(Il2CppClass* klass, std::string_view name, const MethodInfo* getter, const MethodInfo* setter) {
+        std::scoped_lock lock(mockLock);
+        auto* data = dataOf(klass);
+        PropertyInfo prop{};
+        prop.parent = klass;
+        prop.name = intern(name);
+        prop.get = getter;
+        prop.set = setter;
+        data->properties.push_back(prop);
+        klass->properties = data->properties.data();
+        klass->property_count = data->properties.size();
+        return &data->properties.back();
+    }
+
+    void AddAttribute(const void* member, Il2CppClass* attributeClass) {
+        std::scoped_lock lock(mockLock);
+        attributes[member].push_back(attributeClass);
+    }
+
+    Il2CppDefaults& Defaults() {
+        std::scoped_lock lock(mockLock);
+        ensureInit();
+        return il2cpp_mock_defaults;
+    }
+
+    void TrackHeap(bool track) {
+        std::scoped_lock lock(heapLock);
+        trackHeap = track;
+        if (!track) {
+            heapBlocks.clear();
+        }
+    }
+
+    void Reset() {
+        std::scoped_lock lock(mockLock);
+        ensureInit();
+        for (auto const& data : classes) {
+            free(data->klass);
+        }
+        classes.clear();
+        classesByName.clear();
+        classData.clear();
+        typeToClass.clear();
+        attributes.clear();
+        gcHandles.clear();
+        freeHandles.clear();
+        free(corlibImage);
+        free(corlibAssembly);
+        createBuiltins();
+    }
+}
+
+static Il2CppClass* classOfType(const Il2CppType* type) {
+    if (!type) {
+        return nullptr;
+    }
+    std::scoped_lock lock(mockLock);
+    auto itr = typeToClass.find(type);
+    if (itr != typeToClass.end()) {
+        return itr->second;
+    }
+    // Types that were copied (ex: byref copies) still point at their class.
+    return static_cast<Il2CppClass*>(type->data.dummy);
+}
+
+// The profiler the mock reports to. Like il2cpp, only the most recently installed profiler receives events.
+static struct {
+    Il2CppProfiler* profiler;
+    Il2CppProfileFlags events;
+    Il2CppProfileMethodFunc enter;
+    Il2CppProfileMethodFunc leave;
+    Il2CppProfileAllocFunc allocation;
+    Il2CppProfileGCFunc gc;
+    Il2CppProfileGCResizeFunc heapResize;
+} profiler;
+
+static void* allocTracked(std::size_t size) {
+    auto* ptr = calloc(1, size);
+    if (trackHeap.load(std::memory_order_relaxed)) {
+        std::scoped_lock lock(heapLock);
+        heapBlocks.emplace(ptr, size);
+    }
+    return ptr;
+}
+
+static void freeTracked(void* ptr) {
+    if (trackHeap.load(std::memory_order_relaxed)) {
+        std::scoped_lock lock(heapLock);
+        heapBlocks.erase(ptr);
+    }
+    free(ptr);
+}
+
+static Il2CppObject* allocObject(const Il2CppClass* klass, std::size_t size) {
+    auto* obj = static_cast<Il2CppObject*>(allocTracked(size));
+    obj->klass = const_cast<Il2CppClass*>(klass);
+    if ((profiler.events & IL2CPP_PROFILE_ALLOCATIONS) && profiler.allocation) {
+        profiler.allocation(profiler.profiler, obj, obj->klass);
+    }
+    return obj;
+}
+
+// Non-API functions that il2cpp_functions::Init normally finds via xref tracing.
+
+MOCK_API bool il2cpp_mock_Class_Init(Il2CppClass* klass) {
+    klass->initialized = true;
+    return true;
+}
+
+MOCK_API Il2CppClass* il2cpp_mock_Class_FromIl2CppType(Il2CppType* type) {
+    return classOfType(type);
+}
+
+MOCK_API void* il2cpp_mock_GarbageCollector_AllocateFixed(size_t sz, void*) {
+    return allocTracked(sz);
+}
+
+MOCK_API void il2cpp_mock_GC_free(void* addr) {
+    freeTracked(addr);
+}
+
+MOCK_API void il2cpp_mock_GarbageCollector_SetWriteBarrier(void**) {}
+
+// Exported API
+
+MOCK_API void* il2cpp_alloc(size_t size) {
+    return malloc(size);
+}
+
+MOCK_API void il2cpp_free(void* ptr) {
+    free(ptr);
+}
+
+MOCK_API Il2CppDomain* il2cpp_domain_get() {
+    return reinterpret_cast<Il2CppDomain*>(domainStorage);
+}
+
+MOCK_API const Il2CppAssembly** il2cpp_domain_get_assemblies(const Il2CppDomain*, size_t* size) {
+    std::scoped_lock lock(mockLock);
+    ensureInit();
+    static const Il2CppAssembly* assemblies[1];
+    assemblies[0] = corlibAssembly;
+    *size = 1;
+    return assemblies;
+}
+
+MOCK_API const Il2CppImage* il2cpp_get_corlib() {
+    std::scoped_lock lock(mockLock);
+    ensureInit();
+    return corlibImage;
+}
+
+MOCK_API const Il2CppImage* il2cpp_assembly_get_image(const Il2CppAssembly* assembly) {
+    return assembly->image;
+}
+
+MOCK_API const char* il2cpp_image_get_name(const Il2CppImage* image) {
+    return image->name;
+}
+
+MOCK_API size_t il2cpp_image_get_class_count(const Il2CppImage*) {
+    std::scoped_lock lock(mockLock);
+    ensureInit();
+    return classes.size();
+}
+
+MOCK_API const Il2CppClass* il2cpp_image_get_class(const Il2CppImage*, size_t index) {
+    std::scoped_lock lock(mockLock);
+    return index < classes.size() ? classes[index]->klass : nullptr;
+}
+
+MOCK_API void il2cpp_class_for_each(void (*klassReportFunc)(Il2CppClass* klass, void* userData), void* userData) {
+    std::vector<Il2CppClass*> snapshot;
+    {
+        std::scoped_lock lock(mockLock);
+        ensureInit();
+        for (auto const& data : classes) {
+            snapshot.push_back(data->klass);
+        }
+    }
+    for (auto* klass : snapshot) {
+        klassReportFunc(klass, userData);
+    }
+}
+
+MOCK_API Il2CppClass* il2cpp_class_from_name(const Il2CppImage*, const char* namespaze, const char* name) {
+    std::scoped_lock lock(mockLock);
+    ensureInit();
+    auto itr = classesByName.find({namespaze, name});
+    return itr != classesByName.end() ? itr->second->klass : nullptr;
+}
+
+MOCK_API Il2CppClass* il2cpp_class_from_il2cpp_type(const Il2CppType* type) {
+    return classOfType(type);
+}
+
+MOCK_API Il2CppClass* il2cpp_class_from_type(const Il2CppType* type) {
+    return classOfType(type);
+}
+
+MOCK_API const Il2CppType* il2cpp_class_get_type(Il2CppClass* klass) {
+    return &klass->byval_arg;
+}
+
+MOCK_API const char* il2cpp_class_get_name(Il2CppClass* klass) {
+    return klass->name;
+}
+
+MOCK_API const char* il2cpp_class_get_namespace(Il2CppClass* klass) {
+    return klass->namespaze;
+}
+
+MOCK_API Il2CppClass* il2cpp_class_get_parent(Il2CppClass* klass) {
+    return klass->parent;
+}
+
+MOCK_API Il2CppClass* il2cpp_class_get_declaring_type(Il2CppClass* klass) {
+    return klass->declaringType;
+}
+
+MOCK_API Il2CppClass* il2cpp_class_get_element_class(Il2CppClass* klass) {
+    return klass->element_class;
+}
+
+MOCK_API const Il2CppImage* il2cpp_class_get_image(Il2CppClass* klass) {
+    return klass->image;
+}
+
+MOCK_API const char* il2cpp_class_get_assemblyname(const Il2CppClass*) {
+    return "mscorlib";
+}
+
+MOCK_API int il2cpp_class_get_rank(const Il2CppClass* klass) {
+    return klass->rank;
+}
+
+MOCK_API int il2cpp_class_get_flags(const Il2CppClass* klass) {
+    return klass->flags;
+}
+
+MOCK_API bool il2cpp_class_is_valuetype(const Il2CppClass* klass) {
+    return klass->valuetype;
+}
+
+MOCK_API bool il2cpp_class_is_enum(const Il2CppClass* klass) {
+    return klass->enumtype;
+}
+
+MOCK_API bool il2cpp_class_is_generic(const Il2CppClass* klass) {
+    return klass->is_generic;
+}
+
+MOCK_API bool il2cpp_class_is_inflated(const Il2CppClass* klass) {
+    return klass->generic_class != nullptr;
+}
+
+MOCK_API bool il2cpp_class_is_abstract(const Il2CppClass* klass) {
+    return (klass->flags & TYPE_ATTRIBUTE_ABSTRACT) != 0;
+}
+
+MOCK_API bool il2cpp_class_is_interface(const Il2CppClass* klass) {
+    return (klass->flags & TYPE_ATTRIBUTE_INTERFACE) != 0;
+}
+
+MOCK_API int32_t il2cpp_class_instance_size(Il2CppClass* klass) {
+    return klass->instance_size;
+}
+
+MOCK_API int32_t il2cpp_class_value_size(Il2CppClass* klass, uint32_t* align) {
+    if (align) {
+        *align = alignof(void*);
+    }
+    return storageSize(klass);
+}
+
+MOCK_API size_t il2cpp_class_num_fields(const Il2CppClass* klass) {
+    return klass->field_count;
+}
+
+MOCK_API bool il2cpp_class_has_parent(Il2CppClass* klass, Il2CppClass* klassc) {
+    for (auto* cur = klass; cur; cur = cur->parent) {
+        if (cur == klassc) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MOCK_API bool il2cpp_class_is_subclass_of(Il2CppClass* klass, Il2CppClass* klassc, bool) {
+    return klass != klassc && il2cpp_class_has_parent(klass, klassc);
+}
+
+MOCK_API bool il2cpp_class_is_assignable_from(Il2CppClass* klass, Il2CppClass* oklass) {
+    return il2cpp_class_has_parent(oklass, klass);
+}
+
+MOCK_API const MethodInfo* il2cpp_class_get_methods(Il2CppClass* klass, void** iter) {
+    auto idx = reinterpret_cast<uintptr_t>(*iter);
+    if (idx >= klass->method_count) {
+        return nullptr;
+    }
+    *iter = reinterpret_cast<void*>(idx + 1);
+    return klass->methods[idx];
+}
+
+MOCK_API const MethodInfo* il2cpp_class_get_method_from_name(Il2CppClass* klass, const char* name, int argsCount) {
+    for (auto* cur = klass; cur; cur = cur->parent) {
+        for (uint16_t i = 0; i < cur->method_count; i++) {
+            auto* method = cur->methods[i];
+            if ((argsCount < 0 || method->parameters_count == argsCount) && strcmp(method->name, name) == 0) {
+                return method;
+            }
+        }
+    }
+    return nullptr;
+}
+
+MOCK_API FieldInfo* il2cpp_class_get_fields(Il2CppClass* klass, void** iter) {
+    auto idx = reinterpret_cast<uintptr_t>(*iter);
+    if (idx >= klass->field_count) {
+        return nullptr;
+    }
+    *iter = reinterpret_cast<void*>(idx + 1);
+    return &klass->fields[idx];
+}
+
+MOCK_API FieldInfo* il2cpp_class_get_field_from_name(Il2CppClass* klass, const char* name) {
+    for (auto* cur = klass; cur; cur = cur->parent) {
+        for (uint16_t i = 0; i < cur->field_count; i++) {
+            if (strcmp(cur->fields[i].name, name) == 0) {
+                return &cur->fields[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+MOCK_API const PropertyInfo* il2cpp_class_get_properties(Il2CppClass* klass, void** iter) {
+    auto idx = reinterpret_cast<uintptr_t>(*iter);
+    if (idx >= klass->property_count) {
+        return nullptr;
+    }
+    *iter = reinterpret_cast<void*>(idx + 1);
+    return &klass->properties[idx];
+}
+
+MOCK_API const PropertyInfo* il2cpp_class_get_property_from_name(Il2CppClass* klass, const char* name) {
+    for (auto* cur = klass; cur; cur = cur->parent) {
+        for (uint16_t i = 0; i < cur->property_count; i++) {
+            if (strcmp(cur->properties[i].name, name) == 0) {
+                return &cur->properties[i];
+            }
+        }
+    }
+    return nullptr;
+}
+
+MOCK_API Il2CppClass* il2cpp_class_get_nested_types(Il2CppClass*, void**) {
+    return nullptr;
+}
+
+MOCK_API Il2CppClass* il2cpp_class_get_interfaces(Il2CppClass*, void**) {
+    return nullptr;
+}
+
+MOCK_API Il2CppClass* il2cpp_array_class_get(Il2CppClass* element_class, uint32_t rank) {
+    std::scoped_lock lock(mockLock);
+    auto* data = dataOf(element_class);
+    if (!data->arrayClass) {
+        auto* arr = createClass(element_class->namespaze, std::string(element_class->name) + "[]", il2cpp_mock_defaults.array_class, sizeof(Il2CppArray) - sizeof(Il2CppObject), false);
+        arr->element_class = element_class;
+        arr->rank = rank;
+        arr->byval_arg.type = IL2CPP_TYPE_SZARRAY;
+        arr->this_arg.type = IL2CPP_TYPE_SZARRAY;
+        data->arrayClass = arr;
+    }
+    return data->arrayClass;
+}
+
+MOCK_API Il2CppArray* il2cpp_array_new_specific(Il2CppClass* arrayTypeInfo, il2cpp_array_size_t length) {
+    auto elemSize = storageSize(arrayTypeInfo->element_class);
+    auto* arr = reinterpret_cast<Il2CppArray*>(allocObject(arrayTypeInfo, sizeof(Il2CppArraySize) + elemSize * length));
+    arr->max_length = length;
+    return arr;
+}
+
+MOCK_API Il2CppArray* il2cpp_array_new(Il2CppClass* elementTypeInfo, il2cpp_array_size_t length) {
+    return il2cpp_array_new_specific(il2cpp_array_class_get(elementTypeInfo, 1), length);
+}
+
+MOCK_API uint32_t il2cpp_array_length(Il2CppArray* array) {
+    return array->max_length;
+}
+
+MOCK_API int il2cpp_array_element_size(const Il2CppClass* array_class) {
+    return storageSize(array_class->element_class);
+}
+
+MOCK_API char* il2cpp_type_get_name(const Il2CppType* type) {
+    auto* klass = classOfType(type);
+    if (!klass) {
+        return nullptr;
+    }
+    auto name = (klass->namespaze[0] ? std::string(klass->namespaze) + "." : std::string()) + klass->name;
+    if (type->byref) {
+        name += "&";
+    }
+    return strdup(name.c_str());
+}
+
+MOCK_API char* il2cpp_type_get_assembly_qualified_name(const Il2CppType* type) {
+    return il2cpp_type_get_name(type);
+}
+
+MOCK_API Il2CppClass* il2cpp_type_get_class_or_element_class(const Il2CppType* type) {
+    return classOfType(type);
+}
+
+MOCK_API int il2cpp_type_get_type(const Il2CppType* type) {
+    return type->type;
+}
+
+MOCK_API bool il2cpp_type_is_byref(const Il2CppType* type) {
+    return type->byref;
+}
+
+MOCK_API uint32_t il2cpp_type_get_attrs(const Il2CppType* type) {
+    return type->attrs;
+}
+
+MOCK_API bool il2cpp_type_equals(const Il2CppType* type, const Il2CppType* otherType) {
+    return type == otherType || (classOfType(type) == classOfType(otherType) && type->byref == otherType->byref);
+}
+
+MOCK_API const Il2CppType* il2cpp_method_get_return_type(const MethodInfo* method) {
+    return method->return_type;
+}
+
+MOCK_API Il2CppClass* il2cpp_method_get_declaring_type(const MethodInfo* method) {
+    return method->klass;
+}
+
+MOCK_API Il2CppClass* il2cpp_method_get_class(const MethodInfo* method) {
+    return method->klass;
+}
+
+MOCK_API const char* il2cpp_method_get_name(const MethodInfo* method) {
+    return method->name;
+}
+
+MOCK_API bool il2cpp_method_is_generic(const MethodInfo* method) {
+    return method->is_generic;
+}
+
+MOCK_API bool il2cpp_method_is_inflated(const MethodInfo* method) {
+    return method->is_inflated;
+}
+
+MOCK_API bool il2cpp_method_is_instance(const MethodInfo* method) {
+    return (method->flags & METHOD_ATTRIBUTE_STATIC) == 0;
+}
+
+MOCK_API uint32_t il2cpp_method_get_param_count(const MethodInfo* method) {
+    return method->parameters_count;
+}
+
+MOCK_API const Il2CppType* il2cpp_method_get_param(const MethodInfo* method, uint32_t index) {
+    return index < method->parameters_count ? method->parameters[index].parameter_type : nullptr;
+}
+
+MOCK_API const char* il2cpp_method_get_param_name(const MethodInfo* method, uint32_t index) {
+    return index < method->parameters_count ? method->parameters[index].name : nullptr;
+}
+
+MOCK_API uint32_t il2cpp_method_get_flags(const MethodInfo* method, uint32_t* iflags) {
+    if (iflags) {
+        *iflags = method->iflags;
+    }
+    return method->flags;
+}
+
+MOCK_API uint32_t il2cpp_method_get_token(const MethodInfo* method) {
+    return method->token;
+}
+
+MOCK_API int il2cpp_field_get_flags(FieldInfo* field) {
+    return field->type->attrs;
+}
+
+MOCK_API const char* il2cpp_field_get_name(FieldInfo* field) {
+    return field->name;
+}
+
+MOCK_API Il2CppClass* il2cpp_field_get_parent(FieldInfo* field) {
+    return field->parent;
+}
+
+MOCK_API size_t il2cpp_field_get_offset(FieldInfo* field) {
+    return field->offset;
+}
+
+MOCK_API const Il2CppType* il2cpp_field_get_type(FieldInfo* field) {
+    return field->type;
+}
+
+MOCK_API void il2cpp_field_get_value(Il2CppObject* obj, FieldInfo* field, void* value) {
+    memcpy(value, reinterpret_cast<uint8_t*>(obj) + field->offset, storageSize(classOfType(field->type)));
+}
+
+MOCK_API void il2cpp_field_set_value(Il2CppObject* obj, FieldInfo* field, void* value) {
+    memcpy(reinterpret_cast<uint8_t*>(obj) + field->offset, value, storageSize(classOfType(field->type)));
+}
+
+MOCK_API void il2cpp_field_static_get_value(FieldInfo* field, void* value) {
+    memcpy(value, static_cast<uint8_t*>(field->parent->static_fields) + field->offset, storageSize(classOfType(field->type)));
+}
+
+MOCK_API void il2cpp_field_static_set_value(FieldInfo* field, void* value) {
+    memcpy(static_cast<uint8_t*>(field->parent->static_fields) + field->offset, value, storageSize(classOfType(field->type)));
+}
+
+MOCK_API uint32_t il2cpp_property_get_flags(PropertyInfo* prop) {
+    return prop->attrs;
+}
+
+MOCK_API const MethodInfo* il2cpp_property_get_get_method(PropertyInfo* prop) {
+    return prop->get;
+}
+
+MOCK_API const MethodInfo* il2cpp_property_get_set_method(PropertyInfo* prop) {
+    return prop->set;
+}
+
+MOCK_API const char* il2cpp_property_get_name(PropertyInfo* prop) {
+    return prop->name;
+}
+
+MOCK_API Il2CppClass* il2cpp_property_get_parent(PropertyInfo* prop) {
+    return prop->parent;
+}
+
+MOCK_API Il2CppClass* il2cpp_object_get_class(Il2CppObject* obj) {
+    return obj->klass;
+}
+
+MOCK_API uint32_t il2cpp_object_get_size(Il2CppObject* obj) {
+    return obj->klass->instance_size;
+}
+
+MOCK_API Il2CppObject* il2cpp_object_new(const Il2CppClass* klass) {
+    return allocObject(klass, klass->instance_size);
+}
+
+MOCK_API void* il2cpp_object_unbox(Il2CppObject* obj) {
+    return obj + 1;
+}
+
+MOCK_API Il2CppObject* il2cpp_value_box(Il2CppClass* klass, void* data) {
+    if (!klass->valuetype) {
+        return *static_cast<Il2CppObject**>(data);
+    }
+    auto* obj = il2cpp_object_new(klass);
+    memcpy(obj + 1, data, storageSize(klass));
+    return obj;
+}
+
+MOCK_API Il2CppObject* il2cpp_runtime_invoke(const MethodInfo* method, void* obj, void** params, Il2CppException** exc) {
+    if (exc) {
+        *exc = nullptr;
+    }
+    if (!method->invoker_method) {
+        return nullptr;
+    }
+    bool enterLeave = (profiler.events & IL2CPP_PROFILE_ENTER_LEAVE) && profiler.enter && profiler.leave;
+    if (enterLeave) {
+        profiler.enter(profiler.profiler, method);
+    }
+    auto* ret = static_cast<Il2CppObject*>(method->invoker_method(method->methodPointer, method, obj, params));
+    if (enterLeave) {
+        profiler.leave(profiler.profiler, method);
+    }
+    return ret;
+}
+
+MOCK_API void il2cpp_runtime_class_init(Il2CppClass* klass) {
+    klass->initialized = true;
+}
+
+MOCK_API void il2cpp_runtime_object_init(Il2CppObject*) {}
+
+MOCK_API Il2CppString* il2cpp_string_new_utf16(const Il2CppChar* text, int32_t len) {
+    auto* str = reinterpret_cast<Il2CppString*>(allocObject(il2cpp_mock_defaults.string_class, sizeof(Il2CppString) + (len + 1) * sizeof(Il2CppChar)));
+    str->length = len;
+    memcpy(str->chars, text, len * sizeof(Il2CppChar));
+    return str;
+}
+
+MOCK_API Il2CppString* il2cpp_string_new_len(const char* str, uint32_t length) {
+    // Only ASCII is needed by the host tests, so widen byte by byte.
+    std::u16string wide(str, str + length);
+    return il2cpp_string_new_utf16(reinterpret_cast<const Il2CppChar*>(wide.data()), length);
+}
+
+MOCK_API Il2CppString* il2cpp_string_new(const char* str) {
+    return il2cpp_string_new_len(str, strlen(str));
+}
+
+MOCK_API int32_t il2cpp_string_length(Il2CppString* str) {
+    return str->length;
+}
+
+MOCK_API Il2CppChar* il2cpp_string_chars(Il2CppString* str) {
+    return str->chars;
+}
+
+MOCK_API void il2cpp_gc_wbarrier_set_field(Il2CppObject*, void** targetAddress, void* object) {
+    *targetAddress = object;
+}
+
+MOCK_API uint32_t il2cpp_gchandle_new(Il2CppObject* obj, bool) {
+    std::scoped_lock lock(mockLock);
+    if (!freeHandles.empty()) {
+        auto handle = freeHandles.back();
+        freeHandles.pop_back();
+        gcHandles[handle - 1] = obj;
+        return handle;
+    }
+    gcHandles.push_back(obj);
+    return gcHandles.size();
+}
+
+MOCK_API uint32_t il2cpp_gchandle_new_weakref(Il2CppObject* obj, bool) {
+    return il2cpp_gchandle_new(obj, false);
+}
+
+MOCK_API Il2CppObject* il2cpp_gchandle_get_target(uint32_t gchandle) {
+    std::scoped_lock lock(mockLock);
+    return (gchandle && gchandle <= gcHandles.size()) ? gcHandles[gchandle - 1] : nullptr;
+}
+
+MOCK_API void il2cpp_gchandle_free(uint32_t gchandle) {
+    std::scoped_lock lock(mockLock);
+    if (gchandle && gchandle <= gcHandles.size()) {
+        gcHandles[gchandle - 1] = nullptr;
+        freeHandles.push_back(gchandle);
+    }
+}
+
+// Like il2cpp, each query creates a new info, released with il2cpp_custom_attrs_free. Members without attributes have none.
+static Il2CppCustomAttrInfo* attrInfoOf(const void* member) {
+    std::scoped_lock lock(mockLock);
+    auto itr = attributes.find(member);
+    if (itr == attributes.end()) {
+        return nullptr;
+    }
+    return reinterpret_cast<Il2CppCustomAttrInfo*>(new std::vector<Il2CppClass*>(itr->second));
+}
+
+static std::vector<Il2CppClass*> const& attrClassesOf(Il2CppCustomAttrInfo* ainfo) {
+    return *reinterpret_cast<std::vector<Il2CppClass*>*>(ainfo);
+}
+
+MOCK_API Il2CppCustomAttrInfo* il2cpp_custom_attrs_from_class(Il2CppClass* klass) {
+    return attrInfoOf(klass);
+}
+
+MOCK_API Il2CppCustomAttrInfo* il2cpp_custom_attrs_from_method(const MethodInfo* method) {
+    return attrInfoOf(method);
+}
+
+MOCK_API bool il2cpp_custom_attrs_has_attr(Il2CppCustomAttrInfo* ainfo, Il2CppClass* attr_klass) {
+    for (auto* klass : attrClassesOf(ainfo)) {
+        if (il2cpp_class_has_parent(klass, attr_klass)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MOCK_API Il2CppObject* il2cpp_custom_attrs_get_attr(Il2CppCustomAttrInfo* ainfo, Il2CppClass* attr_klass) {
+    for (auto* klass : attrClassesOf(ainfo)) {
+        if (il2cpp_class_has_parent(klass, attr_klass)) {
+            return il2cpp_object_new(klass);
+        }
+    }
+    return nullptr;
+}
+
+MOCK_API Il2CppArray* il2cpp_custom_attrs_construct(Il2CppCustomAttrInfo* cinfo) {
+    auto const& classes = attrClassesOf(cinfo);
+    auto* arr = il2cpp_array_new(il2cpp_mock_defaults.object_class, classes.size());
+    auto** elements = reinterpret_cast<Il2CppObject**>(reinterpret_cast<Il2CppArraySize*>(arr)->vector);
+    for (std::size_t i = 0; i < classes.size(); i++) {
+        elements[i] = il2cpp_object_new(classes[i]);
+    }
+    return arr;
+}
+
+MOCK_API void il2cpp_custom_attrs_free(Il2CppCustomAttrInfo* ainfo) {
+    delete reinterpret_cast<std::vector<Il2CppClass*>*>(ainfo);
+}
+
+MOCK_API bool il2cpp_gc_is_disabled() {
+    return true;
+}
+
+MOCK_API int64_t il2cpp_gc_get_used_size() {
+    return 0;
+}
+
+MOCK_API int64_t il2cpp_gc_get_heap_size() {
+    return 0;
+}
+
+MOCK_API Il2CppThread* il2cpp_thread_current() {
+    return nullptr;
+}
+
+MOCK_API bool il2cpp_is_vm_thread(Il2CppThread*) {
+    return true;
+}
+
+// Every thread can call into the mock, attaching does nothing.
+MOCK_API Il2CppThread* il2cpp_thread_attach(Il2CppDomain*) {
+    return nullptr;
+}
+
+MOCK_API void il2cpp_thread_detach(Il2CppThread*) {}
+
+MOCK_API void il2cpp_profiler_install(Il2CppProfiler* prof, Il2CppProfileFunc) {
+    profiler = {};
+    profiler.profiler = prof;
+}
+
+MOCK_API void il2cpp_profiler_set_events(Il2CppProfileFlags events) {
+    profiler.events = events;
+}
+
+MOCK_API void il2cpp_profiler_install_enter_leave(Il2CppProfileMethodFunc enter, Il2CppProfileMethodFunc fleave) {
+    profiler.enter = enter;
+    profiler.leave = fleave;
+}
+
+MOCK_API void il2cpp_profiler_install_allocation(Il2CppProfileAllocFunc callback) {
+    profiler.allocation = callback;
+}
+
+MOCK_API void il2cpp_profiler_install_gc(Il2CppProfileGCFunc callback, Il2CppProfileGCResizeFunc heap_resize_callback) {
+    profiler.gc = callback;
+    profiler.heapResize = heap_resize_callback;
+}
+
+// Nothing is collected, but the events of a stop the world collection are raised, in the order Boehm raises them.
+MOCK_API void il2cpp_gc_collect(int maxGenerations) {
+    if (!(profiler.events & IL2CPP_PROFILE_GC) || !profiler.gc) {
+        return;
+    }
+    for (auto event : {IL2CPP_GC_EVENT_START, IL2CPP_GC_EVENT_PRE_STOP_WORLD, IL2CPP_GC_EVENT_POST_STOP_WORLD, IL2CPP_GC_EVENT_MARK_START, IL2CPP_GC_EVENT_MARK_END,
+        IL2CPP_GC_EVENT_PRE_START_WORLD, IL2CPP_GC_EVENT_POST_START_WORLD, IL2CPP_GC_EVENT_RECLAIM_START, IL2CPP_GC_EVENT_RECLAIM_END, IL2CPP_GC_EVENT_END}) {
+        profiler.gc(profiler.profiler, event, maxGenerations);
+    }
+}
+
+// A snapshot of the classes, GC handles and (while mock_il2cpp::TrackHeap is on) allocations, with one heap section per allocation.
+MOCK_API Il2CppManagedMemorySnapshot* il2cpp_capture_memory_snapshot() {
+    std::scoped_lock lock(mockLock, heapLock);
+    ensureInit();
+    auto* snapshot = static_cast<Il2CppManagedMemorySnapshot*>(calloc(1, sizeof(Il2CppManagedMemorySnapshot)));
+    std::unordered_map<const Il2CppClass*, uint32_t> indices;
+    for (std::size_t i = 0; i < classes.size(); i++) {
+        indices.emplace(classes[i]->klass, i);
+    }
+    auto indexOf = [&](const Il2CppClass* klass) {
+        auto itr = indices.find(klass);
+        return itr != indices.end() ? itr->second : 0xFFFFFFFF;
+    };
+
+    auto& metadata = snapshot->metadata;
+    metadata.typeCount = classes.size();
+    metadata.types = static_cast<Il2CppMetadataType*>(calloc(classes.size(), sizeof(Il2CppMetadataType)));
+    for (std::size_t i = 0; i < classes.size(); i++) {
+        auto const& data = *classes[i];
+        auto* klass = data.klass;
+        auto& type = metadata.types[i];
+        bool isArray = klass->rank && klass->element_class != klass;
+        type.flags = static_cast<Il2CppMetadataTypeFlags>(klass->valuetype ? kValueType : isArray ? (kArray | (klass->rank << 16)) : kNone);
+        type.baseOrElementTypeIndex = isArray ? indexOf(klass->element_class) : indexOf(klass->parent);
+        type.size = klass->valuetype ? klass->instance_size - sizeof(Il2CppObject) : klass->instance_size;
+        type.typeInfoAddress = reinterpret_cast<uint64_t>(klass);
+        type.name = strdup((klass->namespaze[0] ? std::string(klass->namespaze) + "." : std::string()).append(klass->name).c_str());
+        type.assemblyName = corlibImage->nameNoExt;
+        type.fieldCount = data.fields.size();
+        type.fields = static_cast<Il2CppMetadataField*>(calloc(data.fields.size(), sizeof(Il2CppMetadataField)));
+        for (std::size_t f = 0; f < data.fields.size(); f++) {
+            auto const& field = data.fields[f];
+            type.fields[f].offset = field.offset;
+            type.fields[f].typeIndex = indexOf(classOfType(field.type));
+            type.fields[f].name = field.name;
+            type.fields[f].isStatic = (field.type->attrs & FIELD_ATTRIBUTE_STATIC) != 0;
+        }
+        type.staticsSize = data.staticFieldsSize;
+        type.statics = static_cast<uint8_t*>(malloc(data.staticFieldsSize));
+        if (data.staticFieldsSize) {
+            memcpy(type.statics, data.staticFields.get(), data.staticFieldsSize);
+        }
+    }
+
+    auto& heap = snapshot->heap;
+    heap.sectionCount = heapBlocks.size();
+    heap.sections = static_cast<Il2CppManagedMemorySection*>(calloc(heapBlocks.size(), sizeof(Il2CppManagedMemorySection)));
+    std::size_t section = 0;
+    for (auto const& [ptr, size] : heapBlocks) {
+        auto& copy = heap.sections[section++];
+        copy.sectionStartAddress = reinterpret_cast<uint64_t>(ptr);
+        copy.sectionSize = size;
+        copy.sectionBytes = static_cast<uint8_t*>(malloc(size));
+        memcpy(copy.sectionBytes, ptr, size);
+    }
+
+    auto& handles = snapshot->gcHandles;
+    handles.pointersToObjects = static_cast<uint64_t*>(calloc(gcHandles.size(), sizeof(uint64_t)));
+    for (auto* obj : gcHandles) {
+        if (obj) {
+            handles.pointersToObjects[handles.trackedObjectCount++] = reinterpret_cast<uint64_t>(obj);
+        }
+    }
+
+    auto& runtime = snapshot->runtimeInformation;
+    runtime.pointerSize = sizeof(void*);
+    runtime.objectHeaderSize = sizeof(Il2CppObject);
+    runtime.arrayHeaderSize = offsetof(Il2CppArraySize, vector);
+    runtime.arrayBoundsOffsetInHeader = offsetof(Il2CppArray, bounds);
+    runtime.arraySizeOffsetInHeader = offsetof(Il2CppArray, max_length);
+    runtime.allocationGranularity = 16;
+    return snapshot;
+}
+
+MOCK_API void il2cpp_free_captured_memory_snapshot(Il2CppManagedMemorySnapshot* snapshot) {
+    for (uint32_t i = 0; i < snapshot->metadata.typeCount; i++) {
+        auto& type = snapshot->metadata.types[i];
+        free(type.name);
+        free(type.fields);
+        free(type.statics);
+    }
+    free(snapshot->metadata.types);
+    for (uint32_t i = 0; i < snapshot->heap.sectionCount; i++) {
+        free(snapshot->heap.sections[i].sectionBytes);
+    }
+    free(snapshot->heap.sections);
+    free(snapshot->gcHandles.pointersToObjects);
+    free(snapshot);
+}
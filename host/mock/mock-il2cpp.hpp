@@ -0,0 +1,55 @@
+#pragma once
+// A small, in-memory stand-in for libil2cpp, used by HOST_BUILD only.
+// The mock is built as its own libil2cpp.so, exporting the il2cpp_* API over classes registered through the functions below.
+// It has no GC: objects are never collected, and manual frees are plain frees. il2cpp_gc_collect only raises the profiler's GC events.
+
+#include "../../shared/utils/typedefs.h"
+#include <string_view>
+#include <vector>
+
+namespace mock_il2cpp {
+    /// @brief Creates and registers a new reference (or value) type.
+    /// @param nameSpace The namespace of the class.
+    /// @param name The name of the class.
+    /// @param parent The parent class, or nullptr for System.Object (or System.ValueType for value types).
+    /// @param fieldsSize The size of the instance fields, excluding the object header.
+    /// @param valueType Whether the class is a value type.
+    /// @return The created class, which is initialized and lives until Reset is called.
+    Il2CppClass* AddClass(std::string_view nameSpace, std::string_view name, Il2CppClass* parent = nullptr, uint32_t fieldsSize = 0, bool valueType = false);
+    /// @brief Adds a method to the provided class.
+    /// @param klass The class to add the method to.
+    /// @param name The name of the method.
+    /// @param returnType The return type, or nullptr for System.Void.
+    /// @param params The parameter types.
+    /// @param invoker The invoker used by il2cpp_runtime_invoke, or nullptr for a method that does nothing and returns null.
+    /// @param flags The METHOD_ATTRIBUTE_* flags of the method.
+    /// @return The created method.
+    const MethodInfo* AddMethod(Il2CppClass* klass, std::string_view name, Il2CppClass* returnType, std::vector<Il2CppClass*> const& params, InvokerMethod invoker = nullptr, uint16_t flags = METHOD_ATTRIBUTE_PUBLIC);
+    /// @brief Adds a field to the provided class. Instance fields are laid out after the existing ones.
+    /// @param klass The class to add the field to.
+    /// @param name The name of the field.
+    /// @param type The type of the field.
+    /// @param isStatic Whether the field is static.
+    /// @return The created field.
+    FieldInfo* AddField(Il2CppClass* klass, std::string_view name, Il2CppClass* type, bool isStatic = false);
+    /// @brief Adds a property to the provided class.
+    /// @param klass The class to add the property to.
+    /// @param name The name of the property.
+    /// @param getter The getter, may be nullptr.
+    /// @param setter The setter, may be nullptr.
+    /// @return The created property.
+    const PropertyInfo* AddProperty(Il2CppClass* klass, std::string_view name, const MethodInfo* getter, const MethodInfo* setter);
+    /// @brief Gives a class or method an attribute, found through the il2cpp_custom_attrs_* API. Attribute instances are default constructed.
+    /// @param member The Il2CppClass* or MethodInfo* to add the attribute to.
+    /// @param attributeClass The class of the attribute.
+    void AddAttribute(const void* member, Il2CppClass* attributeClass);
+    /// @brief Returns the Il2CppDefaults the mock exposes, with the builtin System classes filled in.
+    Il2CppDefaults& Defaults();
+    /// @brief Starts (or stops, forgetting what was recorded) recording allocations, so il2cpp_capture_memory_snapshot can report them as heap sections.
+    /// Off by default, since it adds a lock to every allocation.
+    /// @param track Whether to record allocations.
+    void TrackHeap(bool track);
+    /// @brief Removes every registered class (builtins are recreated) and frees all of their metadata, and releases every GC handle.
+    /// Any pointers to classes, methods, fields or properties, and any GC handles, created before this call are invalidated.
+    void Reset();
+}
@@ -0,0 +1,43 @@
+#include "modloader/shared/modloader.hpp"
+#include <android/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::string envOr(const char* name, const char* fallback) {
+    auto* val = getenv(name);
+    return val ? val : fallback;
+}
+
+const std::string Modloader::getLibIl2CppPath() {
+    return envOr("BS_HOOK_HOST_IL2CPP", "libil2cpp.so");
+}
+
+const std::string Modloader::getApplicationId() {
+    return envOr("BS_HOOK_HOST_APP_ID", "com.beatgames.beatsaber");
+}
+
+const std::string Modloader::getDestinationPath() {
+    return envOr("BS_HOOK_HOST_MODS_DIR", "/tmp/bs-hook-host/mods/");
+}
+
+static const char priorityChars[] = "??VDIWEFS";
+
+extern "C" int __android_log_vprint(int prio, const char* tag, const char* fmt, va_list ap) {
+    char c = (prio >= 0 && prio < static_cast<int>(sizeof(priorityChars) - 1)) ? priorityChars[prio] : '?';
+    fprintf(stderr, "%c/%s: ", c, tag);
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+    return 1;
+}
+
+extern "C" int __android_log_print(int prio, const char* tag, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    auto ret = __android_log_vprint(prio, tag, fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+extern "C" int __android_log_write(int prio, const char* tag, const char* text) {
+    return __android_log_print(prio, tag, "%s", text);
+}
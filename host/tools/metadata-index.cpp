@@ -0,0 +1,133 @@
+// Builds il2cpp_utils::MetadataReader's name indices from a global-metadata.dat (pulled from a device, or from an APK) and looks names up in them,
+// to check the reader against new game versions and to measure it.
+// Usage: beatsaber-hook-metadata-index <global-metadata.dat> [options]
+//   --type <Namespace.Name>            Finds a type definition, nested types as Namespace.Outer/Inner (repeatable)
+//   --method <Namespace.Name::Method>  Finds every overload of a method (repeatable)
+//   --field <Namespace.Name::field>    Finds a field (repeatable)
+//   --bench <n>                        Reads the file n times, and runs every lookup n times, reporting the mean times
+
+#include "../bench/bench.hpp"
+#include "../../shared/utils/il2cpp-utils-metadata-reader.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    struct TypeName {
+        std::string_view namespaze;
+        std::string_view name;
+    };
+
+    // The namespace ends at the last '.' before the first '/', so that nested type names can hold dots of their own.
+    TypeName splitTypeName(std::string_view fullName) {
+        auto dot = fullName.substr(0, fullName.find('/')).rfind('.');
+        if (dot == std::string_view::npos) return {{}, fullName};
+        return {fullName.substr(0, dot), fullName.substr(dot + 1)};
+    }
+
+    // Splits "Namespace.Name::member" into the type and the member.
+    std::pair<TypeName, std::string_view> splitMemberName(std::string_view fullName) {
+        auto separator = fullName.rfind("::");
+        if (separator == std::string_view::npos) return {splitTypeName({}), fullName};
+        return {splitTypeName(fullName.substr(0, separator)), fullName.substr(separator + 2)};
+    }
+
+    TypeDefinitionIndex findType(il2cpp_utils::MetadataReader const& reader, TypeName type, std::string_view query) {
+        auto index = reader.FindType(type.namespaze, type.name);
+        if (index == kTypeDefinitionIndexInvalid) {
+            printf("%.*s: no such type\n", static_cast<int>(query.size()), query.data());
+        }
+        return index;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <global-metadata.dat> [--type <Namespace.Name>]... [--method <Namespace.Name::Method>]... [--field <Namespace.Name::field>]... [--bench <n>]\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    std::vector<std::string_view> types, methods, fields;
+    std::size_t iterations = 0;
+    for (int i = 2; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--type" && i + 1 < argc) {
+            types.emplace_back(argv[++i]);
+        } else if (arg == "--method" && i + 1 < argc) {
+            methods.emplace_back(argv[++i]);
+        } else if (arg == "--field" && i + 1 < argc) {
+            fields.emplace_back(argv[++i]);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            iterations = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    auto reader = il2cpp_utils::MetadataReader::FromFile(path);
+    if (!reader) {
+        fprintf(stderr, "Could not read %s\n", path);
+        return 1;
+    }
+    printf("%s: version %i, %i types, %i methods, %i fields\n", path, reader->Version(), reader->TypeCount(), reader->MethodCount(), reader->FieldCount());
+
+    for (auto query : types) {
+        auto index = findType(*reader, splitTypeName(query), query);
+        if (index == kTypeDefinitionIndexInvalid) continue;
+        auto* type = reader->GetTypeDefinition(index);
+        printf("%.*s: type %i, token 0x%x, %u methods from %i, %u fields from %i, %u nested types\n", static_cast<int>(query.size()), query.data(), index, type->token,
+            type->method_count, type->methodStart, type->field_count, type->fieldStart, type->nested_type_count);
+    }
+    for (auto query : methods) {
+        auto [typeName, name] = splitMemberName(query);
+        auto type = findType(*reader, typeName, query);
+        if (type == kTypeDefinitionIndexInvalid) continue;
+        auto found = reader->FindMethods(type, name);
+        printf("%.*s: %zu overloads\n", static_cast<int>(query.size()), query.data(), found.size());
+        for (auto index : found) {
+            auto* method = reader->GetMethodDefinition(index);
+            printf("  method %i, token 0x%x, %u parameters, flags 0x%x\n", index, method->token, method->parameterCount, method->flags);
+        }
+    }
+    for (auto query : fields) {
+        auto [typeName, name] = splitMemberName(query);
+        auto type = findType(*reader, typeName, query);
+        if (type == kTypeDefinitionIndexInvalid) continue;
+        auto index = reader->FindField(type, name);
+        if (index == kFieldIndexInvalid) {
+            printf("%.*s: no such field\n", static_cast<int>(query.size()), query.data());
+            continue;
+        }
+        printf("%.*s: field %i, token 0x%x\n", static_cast<int>(query.size()), query.data(), index, reader->GetFieldDefinition(index)->token);
+    }
+
+    if (iterations) {
+        bench::Run("MetadataReader::FromFile", iterations, [&](std::size_t) {
+            bench::DoNotOptimize(il2cpp_utils::MetadataReader::FromFile(path).has_value());
+        });
+        for (auto query : types) {
+            auto typeName = splitTypeName(query);
+            bench::Run(std::string("FindType ") + std::string(query), iterations, [&](std::size_t) {
+                bench::DoNotOptimize(reader->FindType(typeName.namespaze, typeName.name));
+            });
+        }
+        for (auto query : methods) {
+            auto member = splitMemberName(query);
+            auto type = reader->FindType(member.first.namespaze, member.first.name);
+            bench::Run(std::string("FindMethods ") + std::string(query), iterations, [&](std::size_t) {
+                bench::DoNotOptimize(reader->FindMethods(type, member.second).size());
+            });
+        }
+        for (auto query : fields) {
+            auto member = splitMemberName(query);
+            auto type = reader->FindType(member.first.namespaze, member.first.name);
+            bench::Run(std::string("FindField ") + std::string(query), iterations, [&](std::size_t) {
+                bench::DoNotOptimize(reader->FindField(type, member.second));
+            });
+        }
+    }
+    return 0;
+}
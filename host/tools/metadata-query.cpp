@@ -0,0 +1,303 @@
+// Searches the metadata dumps written by il2cpp_utils::MetadataDump, in place: the dump is mapped and never copied or parsed up front.
+// Usage: beatsaber-hook-metadata-query <metadata.bhmd> [options]
+//   --type <text>      Lists the types whose full name contains text (repeatable)
+//   --members          Also lists the fields, properties and methods of every type --type lists
+//   --method <text>    Lists the methods whose name contains text, with their declaring type, signature and RVA (repeatable)
+//   --field <text>     Lists the fields whose name contains text, with their declaring type, type and offset (repeatable)
+//   --rva <hex>        Names the method whose code starts closest below the provided offset into libil2cpp.so (repeatable)
+//   --limit <n>        Maximum number of results per query (default 100)
+// Without a query, prints the number of types, methods and fields in each image.
+
+#include "../../shared/utils/il2cpp-utils-metadata-dump.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+using namespace il2cpp_utils::metadata_dump_format;
+
+namespace {
+    // One block of the dump, pointing straight into the mapping.
+    struct Block {
+        const BlockHeader* header;
+        const MethodRecord* methods;
+        const TypeRecord* types;
+        const FieldRecord* fields;
+        const PropertyRecord* properties;
+        const ParameterRecord* parameters;
+        const char* strings;
+
+        std::string_view string(uint32_t offset) const {
+            return offset < header->stringsSize ? std::string_view(strings + offset) : std::string_view("<bad string>");
+        }
+
+        // The type declaring the provided method, found by binary search over the (ordered) method ranges of the types.
+        const TypeRecord* typeOf(uint32_t method) const {
+            uint32_t low = 0, high = header->typeCount;
+            while (low < high) {
+                auto mid = low + (high - low) / 2;
+                if (types[mid].firstMethod + types[mid].methodCount <= method) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low < header->typeCount ? &types[low] : nullptr;
+        }
+
+        const TypeRecord* typeOfField(uint32_t field) const {
+            uint32_t low = 0, high = header->typeCount;
+            while (low < high) {
+                auto mid = low + (high - low) / 2;
+                if (types[mid].firstField + types[mid].fieldCount <= field) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low < header->typeCount ? &types[low] : nullptr;
+        }
+
+        std::string typeName(const TypeRecord* type) const {
+            if (!type) return "<unknown>";
+            if (type->fullName) return std::string(string(type->fullName));
+            auto namespaze = string(type->namespaze);
+            return namespaze.empty() ? std::string(string(type->name)) : std::string(namespaze) + "." + std::string(string(type->name));
+        }
+
+        std::string signature(MethodRecord const& method) const {
+            std::string out(string(method.returnType));
+            out += " ";
+            out += string(method.name);
+            out += "(";
+            for (uint32_t i = 0; i < method.parameterCount && method.firstParameter + i < header->parameterCount; i++) {
+                auto const& parameter = parameters[method.firstParameter + i];
+                if (i > 0) out += ", ";
+                out += string(parameter.type);
+                out += " ";
+                out += string(parameter.name);
+            }
+            out += ")";
+            return out;
+        }
+    };
+
+    bool parse(const uint8_t* data, std::size_t size, std::vector<Block>& blocks, DumpHeader& header) {
+        if (size < sizeof(DumpHeader)) {
+            fprintf(stderr, "Not a metadata dump\n");
+            return false;
+        }
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != magic) {
+            fprintf(stderr, "Not a metadata dump\n");
+            return false;
+        }
+        if (header.version != version) {
+            fprintf(stderr, "Unsupported dump version %u (expected %u)\n", header.version, version);
+            return false;
+        }
+        if (sizeof(DumpHeader) + uint64_t(header.blockCount) * sizeof(DumpBlock) > size) {
+            fprintf(stderr, "Truncated dump\n");
+            return false;
+        }
+        auto* table = reinterpret_cast<const DumpBlock*>(data + sizeof(DumpHeader));
+        for (uint32_t i = 0; i < header.blockCount; i++) {
+            auto const& entry = table[i];
+            if (entry.offset % 8 || entry.offset + sizeof(BlockHeader) > size || entry.offset + entry.size > size) {
+                fprintf(stderr, "Block %u is out of bounds\n", i);
+                return false;
+            }
+            auto* base = data + entry.offset;
+            Block block;
+            block.header = reinterpret_cast<const BlockHeader*>(base);
+            auto const& h = *block.header;
+            uint64_t offset = sizeof(BlockHeader);
+            auto take = [&](auto*& array, uint32_t count) {
+                array = reinterpret_cast<std::remove_reference_t<decltype(array)>>(base + offset);
+                offset += uint64_t(count) * sizeof(*array);
+            };
+            take(block.methods, h.methodCount);
+            take(block.types, h.typeCount);
+            take(block.fields, h.fieldCount);
+            take(block.properties, h.propertyCount);
+            take(block.parameters, h.parameterCount);
+            block.strings = reinterpret_cast<const char*>(base + offset);
+            if (offset + h.stringsSize > entry.size || h.stringsSize == 0 || block.strings[h.stringsSize - 1] != '\0') {
+                fprintf(stderr, "Block %u is malformed\n", i);
+                return false;
+            }
+            blocks.push_back(block);
+        }
+        return true;
+    }
+
+    bool contains(std::string_view haystack, std::string_view needle) {
+        return haystack.find(needle) != std::string_view::npos;
+    }
+
+    void printMembers(Block const& block, TypeRecord const& type) {
+        for (uint32_t f = type.firstField; f < type.firstField + type.fieldCount; f++) {
+            auto const& field = block.fields[f];
+            printf("    field %s %s; // offset 0x%x, flags 0x%x\n", block.string(field.type).data(), block.string(field.name).data(), field.offset, field.flags);
+        }
+        for (uint32_t p = type.firstProperty; p < type.firstProperty + type.propertyCount; p++) {
+            auto const& property = block.properties[p];
+            printf("    property %s {%s%s}\n", block.string(property.name).data(), property.getter != noIndex ? " get;" : "", property.setter != noIndex ? " set;" : "");
+        }
+        for (uint32_t m = type.firstMethod; m < type.firstMethod + type.methodCount; m++) {
+            auto const& method = block.methods[m];
+            printf("    method %s; // RVA 0x%lx, token 0x%x, flags 0x%x\n", block.signature(method).c_str(), static_cast<unsigned long>(method.rva), method.token, method.flags);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <metadata.bhmd> [--type <text>]... [--members] [--method <text>]... [--field <text>]... [--rva <hex>]... [--limit <n>]\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    std::vector<std::string_view> typeQueries, methodQueries, fieldQueries;
+    std::vector<uint64_t> rvas;
+    bool members = false;
+    std::size_t limit = 100;
+    for (int i = 2; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--type" && i + 1 < argc) {
+            typeQueries.emplace_back(argv[++i]);
+        } else if (arg == "--members") {
+            members = true;
+        } else if (arg == "--method" && i + 1 < argc) {
+            methodQueries.emplace_back(argv[++i]);
+        } else if (arg == "--field" && i + 1 < argc) {
+            fieldQueries.emplace_back(argv[++i]);
+        } else if (arg == "--rva" && i + 1 < argc) {
+            rvas.push_back(std::strtoull(argv[++i], nullptr, 16));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    auto* data = static_cast<const uint8_t*>(mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Block> blocks;
+    DumpHeader header;
+    if (!parse(data, st.st_size, blocks, header)) {
+        return 1;
+    }
+
+    if (typeQueries.empty() && methodQueries.empty() && fieldQueries.empty() && rvas.empty()) {
+        printf("%s: %u types, %u methods and %u fields in %u blocks\n", path, header.typeCount, header.methodCount, header.fieldCount, header.blockCount);
+        // Blocks of one image are consecutive, but are summed by name anyway.
+        std::map<std::string_view, std::array<uint64_t, 3>> images;
+        for (auto const& block : blocks) {
+            auto& counts = images[block.string(block.header->image)];
+            counts[0] += block.header->typeCount;
+            counts[1] += block.header->methodCount;
+            counts[2] += block.header->fieldCount;
+        }
+        printf("%10s %10s %10s  %s\n", "types", "methods", "fields", "image");
+        for (auto const& [image, counts] : images) {
+            printf("%10lu %10lu %10lu  %.*s\n", static_cast<unsigned long>(counts[0]), static_cast<unsigned long>(counts[1]), static_cast<unsigned long>(counts[2]),
+                static_cast<int>(image.size()), image.data());
+        }
+    }
+
+    for (auto query : typeQueries) {
+        printf("types matching \"%.*s\":\n", static_cast<int>(query.size()), query.data());
+        std::size_t found = 0;
+        for (auto const& block : blocks) {
+            for (uint32_t t = 0; t < block.header->typeCount && found < limit; t++) {
+                auto const& type = block.types[t];
+                auto name = block.typeName(&type);
+                if (!contains(name, query)) continue;
+                found++;
+                printf("  %s : %s [%s], size 0x%x, token 0x%x, flags 0x%x\n", name.c_str(), type.parent ? block.string(type.parent).data() : "<none>",
+                    block.string(block.header->image).data(), type.instanceSize, type.token, type.flags);
+                if (members) {
+                    printMembers(block, type);
+                }
+            }
+        }
+        if (found == limit) printf("  (limit of %zu reached)\n", limit);
+    }
+
+    for (auto query : methodQueries) {
+        printf("methods matching \"%.*s\":\n", static_cast<int>(query.size()), query.data());
+        std::size_t found = 0;
+        for (auto const& block : blocks) {
+            for (uint32_t m = 0; m < block.header->methodCount && found < limit; m++) {
+                auto const& method = block.methods[m];
+                if (!contains(block.string(method.name), query)) continue;
+                found++;
+                printf("  %s::%s // RVA 0x%lx\n", block.typeName(block.typeOf(m)).c_str(), block.signature(method).c_str(), static_cast<unsigned long>(method.rva));
+            }
+        }
+        if (found == limit) printf("  (limit of %zu reached)\n", limit);
+    }
+
+    for (auto query : fieldQueries) {
+        printf("fields matching \"%.*s\":\n", static_cast<int>(query.size()), query.data());
+        std::size_t found = 0;
+        for (auto const& block : blocks) {
+            for (uint32_t f = 0; f < block.header->fieldCount && found < limit; f++) {
+                auto const& field = block.fields[f];
+                if (!contains(block.string(field.name), query)) continue;
+                found++;
+                printf("  %s::%s : %s // offset 0x%x\n", block.typeName(block.typeOfField(f)).c_str(), block.string(field.name).data(), block.string(field.type).data(), field.offset);
+            }
+        }
+        if (found == limit) printf("  (limit of %zu reached)\n", limit);
+    }
+
+    for (auto rva : rvas) {
+        const Block* bestBlock = nullptr;
+        uint32_t best = noIndex;
+        for (auto const& block : blocks) {
+            for (uint32_t m = 0; m < block.header->methodCount; m++) {
+                auto methodRva = block.methods[m].rva;
+                if (methodRva && methodRva <= rva && (!bestBlock || methodRva > bestBlock->methods[best].rva)) {
+                    bestBlock = &block;
+                    best = m;
+                }
+            }
+        }
+        if (!bestBlock) {
+            printf("0x%lx: no method starts at or below it\n", static_cast<unsigned long>(rva));
+            continue;
+        }
+        auto const& method = bestBlock->methods[best];
+        printf("0x%lx: %s::%s + 0x%lx\n", static_cast<unsigned long>(rva), bestBlock->typeName(bestBlock->typeOf(best)).c_str(), bestBlock->signature(method).c_str(),
+            static_cast<unsigned long>(rva - method.rva));
+    }
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "queried in %.1f ms\n", ms);
+    return 0;
+}
@@ -0,0 +1,552 @@
+// Test corpus, fuzzer and benchmark for the And64InlineHook instruction relocator (__fix_instructions, via A64FixInstructions).
+// Instruction sequences are written at a source address, relocated into a trampoline at a chosen destination address,
+// and both are then run through a small interpreter for the instruction classes the relocator rewrites
+// (B, BL, B.cond, CBZ/CBNZ, TBZ/TBNZ, ADR, ADRP, LDR/LDRSW/PRFM literal, plus BR and NOP for the trampolines themselves).
+// Every other instruction is opaque: the interpreter only records that it ran, in order.
+// The relocation is correct when both runs leave through the same address, run the same opaque instructions and calls,
+// and end with the same registers. Registers that point into the original code must point into the trampoline instead,
+// and X17 is ignored, since the trampolines use it as scratch.
+// Usage: beatsaber-hook-relocation-harness [--corpus] [--fuzz <iterations>] [--bench <iterations>] [--seed <n>] [--verbose]
+// With no arguments, runs the corpus and 20000 fuzz iterations. Exits with 1 if any case fails.
+
+#include "../../shared/inline-hook/And64InlineHook.hpp"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    // Source code lives in the middle of a mapped, randomly filled data region, so that literal loads always hit mapped memory.
+    constexpr uint64_t sourceBase = 0x100000000000ull;
+    constexpr uint64_t dataSpan = 0x200000;
+    // A hole in the data region for the near trampoline, which literal loads never target.
+    constexpr uint64_t nearOffset = 0x80000;
+    constexpr uint64_t holeSize = 0x2000;
+    // Near is within range of every branch, mid is out of range of B.cond/CBZ/TBZ/LDR/ADR but not B/BL, far is out of range of ADRP.
+    constexpr uint64_t midOffset = 0x1000000;
+    constexpr uint64_t farOffset = 0x200000000ull;
+    constexpr std::size_t trampolineWords = 5 * 10;
+    constexpr uint32_t canary = 0xdeadbeefu;
+    constexpr int stepLimit = 256;
+
+    struct Placement {
+        const char* name;
+        uint64_t offset;
+    };
+    constexpr Placement placements[] = {{"near", nearOffset}, {"mid", midOffset}, {"far", farOffset}};
+
+    bool verbose = false;
+
+    // region: [sourceBase - dataSpan, sourceBase + dataSpan) minus the hole, plus one page each at mid and far.
+    bool mapRegions(std::mt19937_64& rng) {
+        auto map = [](uint64_t addr, std::size_t size) {
+            return mmap(reinterpret_cast<void*>(addr), size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != MAP_FAILED;
+        };
+        auto low = sourceBase - dataSpan;
+        if (!map(low, 2 * dataSpan) || !map(sourceBase + midOffset, 0x2000) || !map(sourceBase + farOffset, 0x2000)) {
+            fprintf(stderr, "Could not map the source/trampoline regions!\n");
+            return false;
+        }
+        auto* words = reinterpret_cast<uint64_t*>(low);
+        for (std::size_t i = 0; i < 2 * dataSpan / sizeof(uint64_t); i++) {
+            words[i] = rng();
+        }
+        return true;
+    }
+
+    bool literalAllowed(uint64_t addr) {
+        auto hole = sourceBase + nearOffset - holeSize / 2;
+        return addr >= sourceBase - dataSpan + 16 && addr + 16 < sourceBase + dataSpan && (addr + 16 <= hole || addr >= hole + holeSize);
+    }
+
+    // ---------------------------------------------------------------- interpreter
+
+    struct State {
+        uint64_t x[32];
+        uint8_t v[32][16];
+        bool n, z, c, vf;
+    };
+
+    struct Effect {
+        enum Kind : uint32_t { Opaque, Call } kind;
+        uint64_t value;
+        bool operator==(Effect const&) const = default;
+    };
+
+    struct Outcome {
+        State state;
+        std::vector<Effect> effects;
+        uint64_t exitPc = 0;
+        bool looped = false;
+    };
+
+    int64_t signExtend(uint64_t value, int bits) {
+        return static_cast<int64_t>(value << (64 - bits)) >> (64 - bits);
+    }
+
+    bool conditionHolds(State const& s, uint32_t cond) {
+        bool result;
+        switch (cond >> 1) {
+            case 0: result = s.z; break;
+            case 1: result = s.c; break;
+            case 2: result = s.n; break;
+            case 3: result = s.vf; break;
+            case 4: result = s.c && !s.z; break;
+            case 5: result = s.n == s.vf; break;
+            case 6: result = !s.z && s.n == s.vf; break;
+            default: return true;
+        }
+        return (cond & 1) ? !result : result;
+    }
+
+    /// @brief Runs code in [begin, end) from begin until it leaves the range, or stepLimit instructions ran.
+    /// A transfer out of the range right after X30 was pointed back into the range is a call: it is recorded, and returns immediately.
+    Outcome interpret(State const& initial, uint64_t begin, uint64_t end) {
+        Outcome out{initial, {}, 0, false};
+        auto& s = out.state;
+        uint64_t pc = begin;
+        bool linkFresh = false;
+        auto setX = [&](uint32_t reg, uint64_t value) {
+            if (reg == 31) {
+                return;
+            }
+            s.x[reg] = value;
+            if (reg == 30) {
+                linkFresh = true;
+            }
+        };
+        auto readX = [&](uint32_t reg) { return reg == 31 ? 0 : s.x[reg]; };
+        // Only the first transfer after X30 was set can be a call, BL itself or the BR of a relocated BL.
+        auto branch = [&](uint64_t target) {
+            bool call = linkFresh && s.x[30] >= begin && s.x[30] <= end;
+            linkFresh = false;
+            if (target >= begin && target < end) {
+                pc = target;
+            } else if (call) {
+                out.effects.push_back({Effect::Call, target});
+                pc = s.x[30];
+            } else {
+                pc = target;
+            }
+        };
+        for (int step = 0; step < stepLimit; step++) {
+            if (pc < begin || pc >= end) {
+                out.exitPc = pc;
+                return out;
+            }
+            uint32_t ins = *reinterpret_cast<uint32_t*>(pc);
+            uint32_t rt = ins & 0x1f;
+            if ((ins & 0x7c000000u) == 0x14000000u) {
+                // B, BL
+                auto target = pc + signExtend(ins & 0x3ffffffu, 26) * 4;
+                if (ins & 0x80000000u) {
+                    setX(30, pc + 4);
+                }
+                branch(target);
+            } else if ((ins & 0xff000010u) == 0x54000000u) {
+                // B.cond
+                auto target = pc + signExtend((ins >> 5) & 0x7ffffu, 19) * 4;
+                conditionHolds(s, ins & 0xf) ? branch(target) : void(pc += 4);
+            } else if ((ins & 0x7e000000u) == 0x34000000u) {
+                // CBZ, CBNZ
+                auto value = readX(rt);
+                if (!(ins & 0x80000000u)) {
+                    value &= 0xffffffffu;
+                }
+                bool taken = (ins & 0x01000000u) ? value != 0 : value == 0;
+                auto target = pc + signExtend((ins >> 5) & 0x7ffffu, 19) * 4;
+                taken ? branch(target) : void(pc += 4);
+            } else if ((ins & 0x7e000000u) == 0x36000000u) {
+                // TBZ, TBNZ
+                auto bit = ((ins >> 26) & 0x20) | ((ins >> 19) & 0x1f);
+                bool set = (readX(rt) >> bit) & 1;
+                bool taken = (ins & 0x01000000u) ? set : !set;
+                auto target = pc + signExtend((ins >> 5) & 0x3fffu, 14) * 4;
+                taken ? branch(target) : void(pc += 4);
+            } else if ((ins & 0x1f000000u) == 0x10000000u) {
+                // ADR, ADRP
+                auto imm = signExtend((((ins >> 5) & 0x7ffffu) << 2) | ((ins >> 29) & 3), 21);
+                setX(rt, (ins & 0x80000000u) ? (pc & ~0xfffull) + (imm << 12) : pc + imm);
+                pc += 4;
+            } else if ((ins & 0x3b000000u) == 0x18000000u) {
+                // LDR (W, X, S, D, Q), LDRSW and PRFM literal
+                auto addr = pc + signExtend((ins >> 5) & 0x7ffffu, 19) * 4;
+                auto opc = ins >> 30;
+                if (ins & 0x04000000u) {
+                    std::size_t size = 4u << opc;
+                    memset(s.v[rt], 0, sizeof(s.v[rt]));
+                    memcpy(s.v[rt], reinterpret_cast<void*>(addr), std::min<std::size_t>(size, 16));
+                } else if (opc == 0) {
+                    setX(rt, *reinterpret_cast<uint32_t*>(addr));
+                } else if (opc == 1) {
+                    setX(rt, *reinterpret_cast<uint64_t*>(addr));
+                } else if (opc == 2) {
+                    setX(rt, static_cast<uint64_t>(static_cast<int64_t>(*reinterpret_cast<int32_t*>(addr))));
+                }
+                pc += 4;
+            } else if ((ins & 0xfffffc1fu) == 0xd61f0000u) {
+                // BR
+                branch(readX((ins >> 5) & 0x1f));
+            } else if (ins == 0xd503201fu) {
+                // NOP
+                pc += 4;
+            } else {
+                out.effects.push_back({Effect::Opaque, ins});
+                pc += 4;
+            }
+        }
+        out.looped = true;
+        return out;
+    }
+
+    // ---------------------------------------------------------------- cases
+
+    struct Case {
+        std::string name;
+        std::vector<uint32_t> insns;
+        // Offset of the source from sourceBase, which controls alignment and the page the code sits in.
+        uint64_t sourceOffset = 0x1004;
+    };
+
+    /// @brief Known relocator limitations, which are reported but do not fail the run.
+    /// ADRP whose target page starts inside the relocated range is copied verbatim, so it computes the trampoline's page instead.
+    const char* knownLimitation(Case const& c) {
+        auto source = sourceBase + c.sourceOffset;
+        for (std::size_t i = 0; i < c.insns.size(); i++) {
+            auto ins = c.insns[i];
+            if ((ins & 0x9f000000u) == 0x90000000u) {
+                auto pc = source + 4 * i;
+                auto imm = signExtend((((ins >> 5) & 0x7ffffu) << 2) | ((ins >> 29) & 3), 21);
+                auto page = (pc & ~0xfffull) + (imm << 12);
+                if (page >= source && page < source + 4 * c.insns.size()) {
+                    return "ADRP targeting a page inside the relocated range";
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    bool inRange(uint64_t value, uint64_t begin, uint64_t end) {
+        return value >= begin && value <= end;
+    }
+
+    /// @brief Relocates and interprets the case at every placement, with the provided initial state.
+    /// @return An empty string on success, otherwise a description of the first mismatch.
+    std::string check(Case const& c, State const& initial, uint64_t trampolineSkew) {
+        auto source = sourceBase + c.sourceOffset;
+        auto sourceEnd = source + 4 * c.insns.size();
+        memcpy(reinterpret_cast<void*>(source), c.insns.data(), 4 * c.insns.size());
+        auto original = interpret(initial, source, sourceEnd);
+        for (auto const& placement : placements) {
+            auto* trampoline = reinterpret_cast<uint32_t*>(sourceBase + placement.offset + trampolineSkew);
+            std::fill(trampoline, trampoline + trampolineWords + 4, canary);
+            auto bytes = A64FixInstructions(reinterpret_cast<uint32_t*>(source), static_cast<int32_t>(c.insns.size()), trampoline);
+            char buf[256];
+            if (bytes > trampolineWords * 4 || trampoline[bytes / 4] != canary) {
+                snprintf(buf, sizeof(buf), "%s: trampoline overflowed (%zu bytes)", placement.name, static_cast<std::size_t>(bytes));
+                return buf;
+            }
+            auto tBegin = reinterpret_cast<uint64_t>(trampoline);
+            auto tEnd = tBegin + bytes;
+            auto relocated = interpret(initial, tBegin, tEnd);
+
+            if (original.looped != relocated.looped) {
+                snprintf(buf, sizeof(buf), "%s: original %s, relocated %s", placement.name, original.looped ? "loops" : "exits", relocated.looped ? "loops" : "exits");
+                return buf;
+            }
+            if (!original.looped && original.exitPc != relocated.exitPc) {
+                snprintf(buf, sizeof(buf), "%s: exit pc 0x%" PRIx64 " != 0x%" PRIx64, placement.name, relocated.exitPc, original.exitPc);
+                return buf;
+            }
+            auto const& shorter = original.effects.size() <= relocated.effects.size() ? original.effects : relocated.effects;
+            auto const& longer = original.effects.size() <= relocated.effects.size() ? relocated.effects : original.effects;
+            bool effectsMatch = original.looped ? std::equal(shorter.begin(), shorter.end(), longer.begin()) : original.effects == relocated.effects;
+            if (!effectsMatch) {
+                snprintf(buf, sizeof(buf), "%s: executed instructions or calls differ (%zu vs %zu)", placement.name, relocated.effects.size(), original.effects.size());
+                return buf;
+            }
+            if (original.looped) {
+                continue;
+            }
+            for (uint32_t r = 0; r < 31; r++) {
+                if (r == 17) {
+                    continue;
+                }
+                auto o = original.state.x[r];
+                auto t = relocated.state.x[r];
+                bool ok = inRange(o, source, sourceEnd) ? inRange(t, tBegin, tEnd) : o == t;
+                if (!ok) {
+                    snprintf(buf, sizeof(buf), "%s: x%u is 0x%" PRIx64 ", expected 0x%" PRIx64, placement.name, r, t, o);
+                    return buf;
+                }
+            }
+            if (memcmp(original.state.v, relocated.state.v, sizeof(original.state.v)) != 0) {
+                snprintf(buf, sizeof(buf), "%s: vector registers differ", placement.name);
+                return buf;
+            }
+        }
+        return {};
+    }
+
+    State randomState(std::mt19937_64& rng) {
+        State s;
+        for (auto& x : s.x) {
+            // Registers are zero a quarter of the time, so that CBZ/CBNZ go both ways.
+            x = (rng() & 3) ? rng() : 0;
+        }
+        // Keep the initial link register out of every code range.
+        s.x[30] = 0xdead000000000000ull | (rng() & 0xfffffff0u);
+        for (auto& v : s.v) {
+            for (auto& b : v) {
+                b = static_cast<uint8_t>(rng());
+            }
+        }
+        auto flags = rng();
+        s.n = flags & 1;
+        s.z = flags & 2;
+        s.c = flags & 4;
+        s.vf = flags & 8;
+        return s;
+    }
+
+    // ---------------------------------------------------------------- encoders
+
+    uint32_t encB(int64_t off, bool link = false) { return (link ? 0x94000000u : 0x14000000u) | ((off >> 2) & 0x3ffffff); }
+    uint32_t encBCond(int64_t off, uint32_t cond) { return 0x54000000u | (((off >> 2) & 0x7ffff) << 5) | cond; }
+    uint32_t encCbz(int64_t off, uint32_t rt, bool nonZero, bool sf) { return (sf ? 0x80000000u : 0) | 0x34000000u | (nonZero ? 0x01000000u : 0) | (((off >> 2) & 0x7ffff) << 5) | rt; }
+    uint32_t encTbz(int64_t off, uint32_t rt, uint32_t bit, bool nonZero) { return ((bit & 0x20) << 26) | 0x36000000u | (nonZero ? 0x01000000u : 0) | ((bit & 0x1f) << 19) | (((off >> 2) & 0x3fff) << 5) | rt; }
+    uint32_t encAdr(int64_t imm, uint32_t rd, bool page) { return (page ? 0x90000000u : 0x10000000u) | ((imm & 3) << 29) | (((imm >> 2) & 0x7ffff) << 5) | rd; }
+    // opc: 0 = LDR W, 1 = LDR X, 2 = LDRSW, 3 = PRFM, simd adds the S/D/Q forms (opc 0-2).
+    uint32_t encLdrLit(int64_t off, uint32_t rt, uint32_t opc, bool simd) { return (opc << 30) | (simd ? 0x1c000000u : 0x18000000u) | (((off >> 2) & 0x7ffff) << 5) | rt; }
+    uint32_t encMovz(uint32_t rd, uint32_t imm) { return 0xd2800000u | ((imm & 0xffff) << 5) | rd; }
+    uint32_t encAddImm(uint32_t rd, uint32_t rn, uint32_t imm) { return 0x91000000u | ((imm & 0xfff) << 10) | (rn << 5) | rd; }
+    constexpr uint32_t stpFp = 0xa9bf7bfdu;  // stp x29, x30, [sp, #-16]!
+    constexpr uint32_t movFp = 0x910003fdu;  // mov x29, sp
+    constexpr uint32_t nop = 0xd503201fu;
+
+    std::vector<Case> corpus() {
+        std::vector<Case> cases;
+        auto add = [&](std::string name, std::vector<uint32_t> insns, uint64_t sourceOffset = 0x1004) {
+            cases.push_back({std::move(name), std::move(insns), sourceOffset});
+        };
+        add("prologue + bl", {stpFp, movFp, encB(0x1234, true), nop, nop});
+        add("prologue + bl far back", {stpFp, movFp, encB(-0x7000000, true), nop, nop});
+        add("bl as last instruction", {stpFp, movFp, nop, nop, encB(0x100, true)});
+        add("b out of range", {encB(0x7fffffc), nop, nop, nop, nop});
+        add("b backwards", {nop, encB(-0x8000000), nop, nop, nop});
+        add("b forward in range", {encB(12), encMovz(0, 1), encMovz(1, 2), encMovz(2, 3), encMovz(3, 4)});
+        add("b to end of range", {encB(20), encMovz(0, 1), encMovz(1, 2), encMovz(2, 3), encMovz(3, 4)});
+        add("b.eq forward in range", {encBCond(8, 0), encMovz(0, 1), encMovz(1, 2), nop, nop});
+        add("b.ne backward in range", {encMovz(0, 1), encBCond(-4, 1), nop, nop, nop});
+        add("b.hi near", {encBCond(0x400, 8), nop, nop, nop, nop});
+        add("b.lt edge", {encBCond(0xffffc, 11), nop, nop, nop, nop});
+        add("cbz x0 far", {encCbz(0x80000, 0, false, true), nop, nop, nop, nop});
+        add("cbnz w5 in range", {encCbz(12, 5, true, false), encMovz(1, 1), encMovz(2, 2), encMovz(3, 3), nop});
+        add("cbz xzr", {encCbz(0x100, 31, false, true), nop, nop, nop, nop});
+        add("tbz bit 0", {encTbz(0x40, 0, 0, false), nop, nop, nop, nop});
+        add("tbnz bit 63 edge", {encTbz(0x7ffc, 2, 63, true), nop, nop, nop, nop});
+        add("tbz in range", {encTbz(8, 3, 5, false), encMovz(4, 4), encMovz(5, 5), nop, nop});
+        add("adr near", {encAdr(0x123, 0, false), nop, nop, nop, nop});
+        add("adr in range", {encAdr(8, 1, false), nop, nop, nop, nop});
+        add("adr backwards odd", {encAdr(-0xfffff, 2, false), nop, nop, nop, nop});
+        add("adrp + add", {encAdr(0x10, 8, true), encAddImm(8, 8, 0x123), nop, nop, nop});
+        add("adrp far back", {encAdr(-0x100000, 9, true), nop, nop, nop, nop});
+        add("ldr x literal", {encLdrLit(0x1000, 0, 1, false), nop, nop, nop, nop});
+        add("ldr w literal backwards", {encLdrLit(-0x2000, 1, 0, false), nop, nop, nop, nop});
+        add("ldrsw literal", {encLdrLit(0x800, 2, 2, false), nop, nop, nop, nop});
+        add("ldr s literal", {encLdrLit(0x404, 3, 0, true), nop, nop, nop, nop});
+        add("ldr d literal", {encLdrLit(0x408, 4, 1, true), nop, nop, nop, nop});
+        add("ldr q literal", {encLdrLit(0x40c, 5, 2, true), nop, nop, nop, nop});
+        add("prfm literal", {encLdrLit(0x40, 0, 3, false), nop, nop, nop, nop});
+        add("ldr literal in range", {encLdrLit(8, 6, 1, false), nop, nop, nop, nop});
+        add("mixed", {encCbz(0x200, 0, false, true), encAdr(0x40, 1, true), encB(0x1000, true), encLdrLit(0x100, 2, 1, false), encB(-0x100000)});
+        add("4 instructions, aligned", {stpFp, movFp, encB(0x200, true), encBCond(0x40, 0)}, 0x1000 - 8);
+        add("page aligned adrp", {encAdr(0, 0, true), nop, nop, nop, nop}, 0x1000);
+        return cases;
+    }
+
+    // ---------------------------------------------------------------- fuzzer
+
+    int64_t pickOffset(std::mt19937_64& rng, uint64_t pc, uint64_t begin, uint64_t end, int64_t limit) {
+        switch (rng() % 4) {
+            case 0:
+                // In range, including the end of the range.
+                return static_cast<int64_t>(begin + 4 * (rng() % ((end - begin) / 4 + 1))) - static_cast<int64_t>(pc);
+            case 1: {
+                // Within 64 instructions of either limit of the encoding.
+                auto slack = static_cast<int64_t>(rng() % 64) * 4;
+                return (rng() & 1) ? limit - 4 - slack : -limit + slack;
+            }
+            case 2:
+                // Just outside the range.
+                return static_cast<int64_t>(rng() % 256) * 4 - 512;
+            default:
+                // Anywhere the encoding reaches.
+                return (static_cast<int64_t>(rng() % static_cast<uint64_t>(limit / 2)) - limit / 4) * 4;
+        }
+    }
+
+    Case randomCase(std::mt19937_64& rng) {
+        Case c;
+        // Both alignments, so that both 4 and 5 instruction relocations (and their NOP padding) are covered.
+        c.sourceOffset = 0x1000 + (rng() % 0x3000) * 4;
+        std::size_t count = ((sourceBase + c.sourceOffset + 8) & 7) ? 5 : 4;
+        auto begin = sourceBase + c.sourceOffset;
+        auto end = begin + 4 * count;
+        for (std::size_t i = 0; i < count; i++) {
+            auto pc = begin + 4 * i;
+            uint32_t reg = rng() % 32;
+            // Relocated code uses X17 as scratch, and X30 points at the trampoline after a call, so neither is tested.
+            uint32_t tested = (reg == 17 || reg == 30) ? 31 : reg;
+            switch (rng() % 12) {
+                case 0: c.insns.push_back(encB(pickOffset(rng, pc, begin, end, 1 << 27), false)); break;
+                case 1: c.insns.push_back(encB(pickOffset(rng, pc, begin, end, 1 << 27), true)); break;
+                case 2: c.insns.push_back(encBCond(pickOffset(rng, pc, begin, end, 1 << 20), rng() % 16)); break;
+                case 3: c.insns.push_back(encCbz(pickOffset(rng, pc, begin, end, 1 << 20), tested, rng() & 1, rng() & 1)); break;
+                case 4: c.insns.push_back(encTbz(pickOffset(rng, pc, begin, end, 1 << 15), tested, rng() % 64, rng() & 1)); break;
+                case 5: c.insns.push_back(encAdr(static_cast<int64_t>(rng() % (1 << 21)) - (1 << 20), reg, false)); break;
+                case 6: c.insns.push_back(encAdr(static_cast<int64_t>(rng() % (1 << 21)) - (1 << 20), reg, true)); break;
+                case 7:
+                case 8: {
+                    int64_t off;
+                    do {
+                        off = pickOffset(rng, pc, begin, end, 1 << 20);
+                    } while (!literalAllowed(pc + off));
+                    bool simd = rng() & 1;
+                    c.insns.push_back(encLdrLit(off, reg, rng() % (simd ? 3 : 4), simd));
+                    break;
+                }
+                case 9: c.insns.push_back(encMovz(reg == 31 ? 0 : reg, static_cast<uint32_t>(rng()))); break;
+                case 10: c.insns.push_back(encAddImm(rng() % 31, rng() % 31, static_cast<uint32_t>(rng()))); break;
+                default: c.insns.push_back(nop); break;
+            }
+        }
+        return c;
+    }
+
+    std::string describe(Case const& c) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), " @+0x%" PRIx64 " [", c.sourceOffset);
+        std::string s = c.name + buf;
+        for (auto ins : c.insns) {
+            snprintf(buf, sizeof(buf), " %08x", ins);
+            s += buf;
+        }
+        return s + " ]";
+    }
+
+    struct Tally {
+        std::size_t passed = 0, failed = 0, known = 0;
+    };
+
+    void runCase(Case const& c, std::mt19937_64& rng, int states, Tally& tally) {
+        auto* limitation = knownLimitation(c);
+        for (int i = 0; i < states; i++) {
+            auto initial = randomState(rng);
+            // Odd trampoline word offsets exercise the alignment padding.
+            auto error = check(c, initial, (rng() & 1) * 4);
+            if (error.empty()) {
+                continue;
+            }
+            if (limitation) {
+                tally.known++;
+                if (verbose) {
+                    printf("KNOWN %s: %s (%s)\n", describe(c).c_str(), error.c_str(), limitation);
+                }
+            } else {
+                tally.failed++;
+                printf("FAIL  %s: %s\n", describe(c).c_str(), error.c_str());
+            }
+            return;
+        }
+        tally.passed++;
+        if (verbose) {
+            printf("PASS  %s\n", describe(c).c_str());
+        }
+    }
+
+    void bench(std::mt19937_64& rng, std::size_t iterations) {
+        std::vector<Case> cases;
+        for (std::size_t i = 0; i < 1024; i++) {
+            cases.push_back(randomCase(rng));
+        }
+        for (auto& c : cases) {
+            memcpy(reinterpret_cast<void*>(sourceBase + c.sourceOffset), c.insns.data(), 4 * c.insns.size());
+        }
+        for (auto const& placement : placements) {
+            auto* trampoline = reinterpret_cast<uint32_t*>(sourceBase + placement.offset);
+            uintptr_t total = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < iterations; i++) {
+                auto& c = cases[i % cases.size()];
+                // Sources overlap, so rewrite the words being relocated. This is a 20 byte copy, small next to the relocation.
+                memcpy(reinterpret_cast<void*>(sourceBase + c.sourceOffset), c.insns.data(), 4 * c.insns.size());
+                total += A64FixInstructions(reinterpret_cast<uint32_t*>(sourceBase + c.sourceOffset), static_cast<int32_t>(c.insns.size()), trampoline);
+            }
+            auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            printf("relocate (%s): %8.1f ns/sequence, %.1f bytes/trampoline on average\n", placement.name, ns / iterations, static_cast<double>(total) / iterations);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    bool runCorpus = false;
+    std::size_t fuzzIterations = 0, benchIterations = 0;
+    uint64_t seed = 0x5eed;
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--corpus") {
+            runCorpus = true;
+        } else if (arg == "--fuzz" && i + 1 < argc) {
+            fuzzIterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--bench" && i + 1 < argc) {
+            benchIterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--corpus] [--fuzz <iterations>] [--bench <iterations>] [--seed <n>] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!runCorpus && !fuzzIterations && !benchIterations) {
+        runCorpus = true;
+        fuzzIterations = 20000;
+    }
+
+    std::mt19937_64 rng(seed);
+    if (!mapRegions(rng)) {
+        return 1;
+    }
+    Tally tally;
+    if (runCorpus) {
+        for (auto const& c : corpus()) {
+            runCase(c, rng, 16, tally);
+        }
+        printf("corpus: %zu passed, %zu failed, %zu known limitations\n", tally.passed, tally.failed, tally.known);
+    }
+    if (fuzzIterations) {
+        Tally fuzz;
+        for (std::size_t i = 0; i < fuzzIterations; i++) {
+            auto c = randomCase(rng);
+            c.name = "fuzz#" + std::to_string(i);
+            runCase(c, rng, 4, fuzz);
+        }
+        printf("fuzz (seed 0x%" PRIx64 "): %zu passed, %zu failed, %zu known limitations\n", seed, fuzz.passed, fuzz.failed, fuzz.known);
+        tally.failed += fuzz.failed;
+    }
+    if (benchIterations) {
+        bench(rng, benchIterations);
+    }
+    return tally.failed ? 1 : 0;
+}
@@ -0,0 +1,667 @@
+// Offline analysis of the memory snapshots written by il2cpp_utils::MemorySnapshot.
+// The snapshot only holds raw heap sections, so objects are found the way the GC finds them: by walking references from the roots
+// (GC handles, static fields, thread stacks and, when gc_accounting was enabled, fixed allocations such as SafePtr handles).
+// Usage: beatsaber-hook-snapshot-analyzer <snapshot.bhms> [options]
+//   --top <n>          Number of types (and owners) to list (default 30)
+//   --owners           Lists the objects only reachable through fixed allocations, by the owner that allocated them
+//   --paths <name>     Prints the path from a root to objects whose type name contains name (repeatable)
+//   --max-paths <n>    Maximum number of paths printed per --paths (default 5)
+// Unreachable objects are garbage the GC has not collected yet, and are not reported.
+
+#include "../../shared/utils/il2cpp-utils-snapshot.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace il2cpp_utils::snapshot_format;
+
+namespace {
+    struct Field {
+        uint32_t offset;
+        uint32_t typeIndex;
+        bool isStatic;
+        std::string_view name;
+    };
+
+    // A reference inside an instance (or value), relative to its start, with the field path that leads to it.
+    struct Reference {
+        uint32_t offset;
+        std::string name;
+    };
+
+    struct Type {
+        uint32_t flags = 0;
+        uint32_t baseOrElement = noType;
+        uint32_t size = 0;
+        uint64_t typeInfoAddress = 0;
+        std::string_view name;
+        std::string_view assembly;
+        std::vector<Field> fields;
+        const uint8_t* statics = nullptr;
+        uint32_t staticsSize = 0;
+
+        // Filled in lazily by referencesOf.
+        enum class State : uint8_t { None, Computing, Done } state = State::None;
+        std::vector<Reference> references;
+
+        bool IsValueType() const { return flags & typeValueType; }
+        bool IsArray() const { return flags & typeArray; }
+    };
+
+    struct Section {
+        uint64_t start;
+        uint32_t size;
+        const uint8_t* bytes;
+    };
+
+    struct FixedRoot {
+        uint64_t address;
+        uint64_t size;
+        std::string_view owner;
+    };
+
+    struct Snapshot {
+        SnapshotHeader header;
+        std::vector<Type> types;
+        std::vector<Section> heap;
+        std::vector<Section> stacks;
+        std::vector<uint64_t> handles;
+        std::vector<FixedRoot> fixed;
+        std::unordered_map<uint64_t, uint32_t> typesByAddress;
+        uint32_t stringType = noType;
+        bool complete = false;
+    };
+
+    struct Reader {
+        const uint8_t* cur;
+        const uint8_t* end;
+        bool ok = true;
+
+        template<class T>
+        T value() {
+            T result{};
+            if (end - cur < static_cast<std::ptrdiff_t>(sizeof(T))) {
+                ok = false;
+                cur = end;
+                return result;
+            }
+            memcpy(&result, cur, sizeof(T));
+            cur += sizeof(T);
+            return result;
+        }
+
+        const uint8_t* bytes(uint64_t size) {
+            if (static_cast<uint64_t>(end - cur) < size) {
+                ok = false;
+                cur = end;
+                return nullptr;
+            }
+            auto* result = cur;
+            cur += size;
+            return result;
+        }
+
+        std::string_view string() {
+            auto length = value<uint32_t>();
+            auto* data = bytes(length);
+            return data ? std::string_view(reinterpret_cast<const char*>(data), length) : std::string_view();
+        }
+    };
+
+    bool parse(const uint8_t* data, std::size_t size, Snapshot& snapshot) {
+        Reader r{data, data + size};
+        snapshot.header = r.value<SnapshotHeader>();
+        if (!r.ok || snapshot.header.magic != magic) {
+            fprintf(stderr, "Not a memory snapshot\n");
+            return false;
+        }
+        if (snapshot.header.version != version) {
+            fprintf(stderr, "Unsupported snapshot version %u (expected %u)\n", snapshot.header.version, version);
+            return false;
+        }
+        if (snapshot.header.pointerSize != sizeof(uint64_t)) {
+            fprintf(stderr, "Only 64 bit snapshots are supported\n");
+            return false;
+        }
+        while (r.ok && r.cur != r.end) {
+            auto tag = r.value<uint8_t>();
+            switch (tag) {
+                case SnapshotRecord::End:
+                    snapshot.complete = true;
+                    return true;
+                case SnapshotRecord::Type: {
+                    auto index = r.value<uint32_t>();
+                    if (index >= snapshot.types.size()) {
+                        snapshot.types.resize(index + 1);
+                    }
+                    auto& type = snapshot.types[index];
+                    type.flags = r.value<uint32_t>();
+                    type.baseOrElement = r.value<uint32_t>();
+                    type.size = r.value<uint32_t>();
+                    type.typeInfoAddress = r.value<uint64_t>();
+                    type.name = r.string();
+                    type.assembly = r.string();
+                    auto fieldCount = r.value<uint32_t>();
+                    for (uint32_t i = 0; i < fieldCount && r.ok; i++) {
+                        auto offset = r.value<uint32_t>();
+                        auto typeIndex = r.value<uint32_t>();
+                        bool isStatic = r.value<uint8_t>();
+                        type.fields.push_back({offset, typeIndex, isStatic, r.string()});
+                    }
+                    type.staticsSize = r.value<uint32_t>();
+                    type.statics = r.bytes(type.staticsSize);
+                    snapshot.typesByAddress.emplace(type.typeInfoAddress, index);
+                    if (type.name == "System.String") {
+                        snapshot.stringType = index;
+                    }
+                    break;
+                }
+                case SnapshotRecord::HeapSection:
+                case SnapshotRecord::StackSection: {
+                    Section section;
+                    section.start = r.value<uint64_t>();
+                    section.size = r.value<uint32_t>();
+                    section.bytes = r.bytes(section.size);
+                    (tag == SnapshotRecord::HeapSection ? snapshot.heap : snapshot.stacks).push_back(section);
+                    break;
+                }
+                case SnapshotRecord::GcHandles: {
+                    auto count = r.value<uint32_t>();
+                    auto* handles = r.bytes(uint64_t(count) * sizeof(uint64_t));
+                    if (handles) {
+                        auto offset = snapshot.handles.size();
+                        snapshot.handles.resize(offset + count);
+                        memcpy(snapshot.handles.data() + offset, handles, count * sizeof(uint64_t));
+                    }
+                    break;
+                }
+                case SnapshotRecord::FixedAllocation: {
+                    FixedRoot root;
+                    root.address = r.value<uint64_t>();
+                    root.size = r.value<uint64_t>();
+                    root.owner = r.string();
+                    snapshot.fixed.push_back(root);
+                    break;
+                }
+                default:
+                    fprintf(stderr, "Unknown record %u at offset 0x%lx\n", tag, static_cast<unsigned long>(r.cur - 1 - data));
+                    return false;
+            }
+        }
+        // A snapshot the game was killed while writing still has everything up to the truncation.
+        fprintf(stderr, "Warning: the snapshot is truncated, results are partial\n");
+        return true;
+    }
+
+    class Analyzer {
+        public:
+        struct Object {
+            uint64_t address;
+            uint32_t type;
+            uint32_t size;
+            // Index of the object that first referenced this one, or a root index with the top bit set.
+            uint32_t parent;
+        };
+
+        enum class RootKind { Handle, Static, Stack, Fixed };
+        struct Root {
+            RootKind kind;
+            // The handle index, the type of the static field, the stack index, or the fixed allocation index.
+            uint32_t index;
+            std::string name;
+        };
+
+        static constexpr uint32_t rootBit = 0x80000000;
+
+        explicit Analyzer(Snapshot& snapshot) : s(snapshot) {
+            std::sort(s.heap.begin(), s.heap.end(), [](auto const& a, auto const& b) { return a.start < b.start; });
+        }
+
+        std::vector<Object> objects;
+        std::vector<Root> roots;
+        // The first object (in discovery order) reached from each kind of root, objects before the fixed roots' first object are reachable without them.
+        uint32_t firstFromFixed = 0;
+        uint64_t conservativeMisses = 0;
+
+        void Run() {
+            for (uint32_t i = 0; i < s.handles.size(); i++) {
+                auto root = addRoot(RootKind::Handle, i, "GC handle #" + std::to_string(i));
+                visit(s.handles[i], root);
+            }
+            for (uint32_t t = 0; t < s.types.size(); t++) {
+                auto& type = s.types[t];
+                if (!type.statics) {
+                    continue;
+                }
+                for (auto const& field : type.fields) {
+                    if (!field.isStatic || field.typeIndex >= s.types.size()) {
+                        continue;
+                    }
+                    uint32_t root = noType;
+                    scanField(type.statics, type.staticsSize, field.offset, field.typeIndex, [&](uint64_t target, std::string const&) {
+                        if (root == noType) {
+                            root = addRoot(RootKind::Static, t, "static " + std::string(type.name) + "::" + std::string(field.name));
+                        }
+                        visit(target, root);
+                    });
+                }
+            }
+            for (uint32_t i = 0; i < s.stacks.size(); i++) {
+                auto root = addRoot(RootKind::Stack, i, "stack #" + std::to_string(i));
+                scanConservative(s.stacks[i].bytes, s.stacks[i].size, root);
+            }
+            drain();
+            firstFromFixed = objects.size();
+            for (uint32_t i = 0; i < s.fixed.size(); i++) {
+                auto const& fixed = s.fixed[i];
+                auto root = addRoot(RootKind::Fixed, i, "fixed allocation 0x" + hex(fixed.address) + " from " + std::string(fixed.owner));
+                auto* bytes = heapBytes(fixed.address, fixed.size);
+                if (!bytes) {
+                    conservativeMisses++;
+                    continue;
+                }
+                scanConservative(bytes, fixed.size, root);
+                drain();
+            }
+        }
+
+        // Returns the root that (transitively) keeps the provided object alive.
+        uint32_t RootOf(uint32_t object) const {
+            while (!(objects[object].parent & rootBit)) {
+                object = objects[object].parent;
+            }
+            return objects[object].parent & ~rootBit;
+        }
+
+        std::string Describe(Object const& object) const {
+            return std::string(s.types[object.type].name) + " @ 0x" + hex(object.address);
+        }
+
+        // The name of the field (or array element) of parent that references child.
+        std::string EdgeName(Object const& parent, Object const& child) {
+            std::string name;
+            forEachReference(parent, [&](uint64_t target, std::string const& path) {
+                if (name.empty() && target == child.address) {
+                    name = path;
+                }
+            });
+            return name.empty() ? "?" : name;
+        }
+
+        private:
+        Snapshot& s;
+        std::unordered_map<uint64_t, uint32_t> objectsByAddress;
+        std::deque<uint32_t> pending;
+
+        static std::string hex(uint64_t value) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "%lx", static_cast<unsigned long>(value));
+            return buffer;
+        }
+
+        uint32_t addRoot(RootKind kind, uint32_t index, std::string name) {
+            roots.push_back({kind, index, std::move(name)});
+            return roots.size() - 1;
+        }
+
+        // The snapshot's copy of size bytes at address, if they are all within one heap section.
+        const uint8_t* heapBytes(uint64_t address, uint64_t size) const {
+            auto itr = std::upper_bound(s.heap.begin(), s.heap.end(), address, [](uint64_t addr, Section const& section) { return addr < section.start; });
+            if (itr == s.heap.begin()) {
+                return nullptr;
+            }
+            --itr;
+            if (!itr->bytes || address + size > itr->start + itr->size || address + size < address) {
+                return nullptr;
+            }
+            return itr->bytes + (address - itr->start);
+        }
+
+        template<class T>
+        static T load(const uint8_t* bytes) {
+            T value;
+            memcpy(&value, bytes, sizeof(T));
+            return value;
+        }
+
+        // The type and size of the object at address, or false if there is no object there.
+        bool identify(uint64_t address, uint32_t& typeIndex, uint32_t& size) const {
+            auto const& h = s.header;
+            auto* header = heapBytes(address, h.objectHeaderSize);
+            if (!header) {
+                return false;
+            }
+            auto itr = s.typesByAddress.find(load<uint64_t>(header));
+            if (itr == s.typesByAddress.end()) {
+                return false;
+            }
+            typeIndex = itr->second;
+            auto const& type = s.types[typeIndex];
+            if (type.IsValueType()) {
+                return false;
+            }
+            uint64_t total = type.size;
+            if (type.IsArray()) {
+                auto* arrayHeader = heapBytes(address, h.arrayHeaderSize);
+                if (!arrayHeader || type.baseOrElement >= s.types.size()) {
+                    return false;
+                }
+                auto length = load<uint64_t>(arrayHeader + h.arraySizeOffsetInHeader);
+                total = h.arrayHeaderSize + length * elementSize(type);
+            } else if (typeIndex == s.stringType) {
+                auto* stringHeader = heapBytes(address, h.objectHeaderSize + sizeof(int32_t));
+                if (!stringHeader) {
+                    return false;
+                }
+                auto length = load<int32_t>(stringHeader + h.objectHeaderSize);
+                total = h.objectHeaderSize + sizeof(int32_t) + (static_cast<uint64_t>(std::max(length, 0)) + 1) * sizeof(char16_t);
+            }
+            if (total > UINT32_MAX || !heapBytes(address, total)) {
+                return false;
+            }
+            size = total;
+            return true;
+        }
+
+        uint32_t elementSize(Type const& array) const {
+            auto const& element = s.types[array.baseOrElement];
+            return element.IsValueType() ? element.size : s.header.pointerSize;
+        }
+
+        // Every reference in an instance (or, for value types, a boxed-less value) of the type, flattened through value type fields.
+        std::vector<Reference> const& referencesOf(uint32_t typeIndex) {
+            auto& type = s.types[typeIndex];
+            if (type.state == Type::State::Done) {
+                return type.references;
+            }
+            if (type.state == Type::State::Computing) {
+                // Primitive value types contain a field of their own type, which holds no references.
+                static const std::vector<Reference> none;
+                return none;
+            }
+            type.state = Type::State::Computing;
+            std::vector<Reference> references;
+            // Value type field offsets still count the object header, values in fields and arrays are stored without it.
+            uint32_t adjust = type.IsValueType() ? s.header.objectHeaderSize : 0;
+            for (auto t = typeIndex; t < s.types.size() && !s.types[t].IsArray(); t = s.types[t].baseOrElement) {
+                for (auto const& field : s.types[t].fields) {
+                    if (field.isStatic || field.typeIndex >= s.types.size() || field.offset < adjust) {
+                        continue;
+                    }
+                    auto offset = field.offset - adjust;
+                    if (!s.types[field.typeIndex].IsValueType()) {
+                        references.push_back({offset, std::string(field.name)});
+                        continue;
+                    }
+                    for (auto const& inner : referencesOf(field.typeIndex)) {
+                        references.push_back({offset + inner.offset, std::string(field.name) + "." + inner.name});
+                    }
+                }
+                if (type.IsValueType()) {
+                    break;
+                }
+            }
+            type.references = std::move(references);
+            type.state = Type::State::Done;
+            return type.references;
+        }
+
+        template<class F>
+        void scanField(const uint8_t* base, uint64_t available, uint32_t offset, uint32_t typeIndex, F&& callback) {
+            if (!s.types[typeIndex].IsValueType()) {
+                if (offset + sizeof(uint64_t) <= available) {
+                    callback(load<uint64_t>(base + offset), std::string());
+                }
+                return;
+            }
+            for (auto const& reference : referencesOf(typeIndex)) {
+                if (offset + reference.offset + sizeof(uint64_t) <= available) {
+                    callback(load<uint64_t>(base + offset + reference.offset), reference.name);
+                }
+            }
+        }
+
+        template<class F>
+        void forEachReference(Object const& object, F&& callback) {
+            auto* bytes = heapBytes(object.address, object.size);
+            auto const& type = s.types[object.type];
+            if (!type.IsArray()) {
+                for (auto const& reference : referencesOf(object.type)) {
+                    if (reference.offset + sizeof(uint64_t) <= object.size) {
+                        callback(load<uint64_t>(bytes + reference.offset), reference.name);
+                    }
+                }
+                return;
+            }
+            auto stride = elementSize(type);
+            auto length = (object.size - s.header.arrayHeaderSize) / std::max<uint32_t>(stride, 1);
+            auto const& element = s.types[type.baseOrElement];
+            for (uint64_t i = 0; i < length; i++) {
+                auto* elementBytes = bytes + s.header.arrayHeaderSize + i * stride;
+                if (!element.IsValueType()) {
+                    callback(load<uint64_t>(elementBytes), "[" + std::to_string(i) + "]");
+                    continue;
+                }
+                for (auto const& reference : referencesOf(type.baseOrElement)) {
+                    callback(load<uint64_t>(elementBytes + reference.offset), "[" + std::to_string(i) + "]." + reference.name);
+                }
+            }
+        }
+
+        void visit(uint64_t address, uint32_t parent, bool isRoot = true) {
+            if (!address || objectsByAddress.contains(address)) {
+                return;
+            }
+            uint32_t type, size;
+            if (!identify(address, type, size)) {
+                return;
+            }
+            uint32_t index = objects.size();
+            objects.push_back({address, type, size, isRoot ? (parent | rootBit) : parent});
+            objectsByAddress.emplace(address, index);
+            pending.push_back(index);
+        }
+
+        // Treats every aligned word as a possible reference, like the GC does for stacks and uncollectable memory.
+        void scanConservative(const uint8_t* bytes, uint64_t size, uint32_t root) {
+            for (uint64_t offset = 0; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+                visit(load<uint64_t>(bytes + offset), root);
+            }
+        }
+
+        // Breadth first, so the recorded parents form the shortest path from a root.
+        void drain() {
+            while (!pending.empty()) {
+                auto index = pending.front();
+                pending.pop_front();
+                auto object = objects[index];
+                forEachReference(object, [&](uint64_t target, std::string const&) {
+                    visit(target, index, false);
+                });
+            }
+        }
+    };
+
+    void printHistogram(Snapshot const& snapshot, Analyzer const& analyzer, std::size_t top) {
+        std::vector<std::pair<uint64_t, uint64_t>> perType(snapshot.types.size());
+        for (auto const& object : analyzer.objects) {
+            perType[object.type].first++;
+            perType[object.type].second += object.size;
+        }
+        std::vector<uint32_t> order;
+        for (uint32_t t = 0; t < perType.size(); t++) {
+            if (perType[t].first) {
+                order.push_back(t);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&](auto a, auto b) { return perType[a].second > perType[b].second; });
+        printf("\n%12s %14s %10s  %s\n", "objects", "bytes", "avg", "type");
+        for (std::size_t i = 0; i < std::min(top, order.size()); i++) {
+            auto const& [count, bytes] = perType[order[i]];
+            auto const& type = snapshot.types[order[i]];
+            printf("%12lu %14lu %10lu  %.*s (%.*s)\n", static_cast<unsigned long>(count), static_cast<unsigned long>(bytes), static_cast<unsigned long>(bytes / count),
+                static_cast<int>(type.name.size()), type.name.data(), static_cast<int>(type.assembly.size()), type.assembly.data());
+        }
+    }
+
+    void printOwners(Snapshot const& snapshot, Analyzer const& analyzer, std::size_t top) {
+        struct OwnerTotals {
+            uint64_t roots = 0;
+            uint64_t objects = 0;
+            uint64_t bytes = 0;
+            std::map<uint32_t, std::pair<uint64_t, uint64_t>> types;
+        };
+        std::map<std::string_view, OwnerTotals> owners;
+        for (auto const& fixed : snapshot.fixed) {
+            owners[fixed.owner].roots++;
+        }
+        for (uint32_t i = analyzer.firstFromFixed; i < analyzer.objects.size(); i++) {
+            auto const& object = analyzer.objects[i];
+            auto const& root = analyzer.roots[analyzer.RootOf(i)];
+            auto& totals = owners[snapshot.fixed[root.index].owner];
+            totals.objects++;
+            totals.bytes += object.size;
+            auto& type = totals.types[object.type];
+            type.first++;
+            type.second += object.size;
+        }
+        std::vector<std::pair<std::string_view, OwnerTotals*>> sorted;
+        for (auto& [owner, totals] : owners) {
+            sorted.emplace_back(owner, &totals);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](auto const& a, auto const& b) { return a.second->bytes > b.second->bytes; });
+        printf("\nObjects only reachable through fixed allocations, by owner (%zu fixed allocations, %lu outside the captured heap):\n",
+            snapshot.fixed.size(), static_cast<unsigned long>(analyzer.conservativeMisses));
+        printf("%10s %12s %14s  %s\n", "roots", "objects", "bytes", "owner");
+        for (std::size_t i = 0; i < std::min(top, sorted.size()); i++) {
+            auto const& [owner, totals] = sorted[i];
+            printf("%10lu %12lu %14lu  %.*s\n", static_cast<unsigned long>(totals->roots), static_cast<unsigned long>(totals->objects),
+                static_cast<unsigned long>(totals->bytes), static_cast<int>(owner.size()), owner.data());
+            std::vector<std::pair<uint32_t, std::pair<uint64_t, uint64_t>>> types(totals->types.begin(), totals->types.end());
+            std::sort(types.begin(), types.end(), [](auto const& a, auto const& b) { return a.second.second > b.second.second; });
+            for (std::size_t t = 0; t < std::min<std::size_t>(5, types.size()); t++) {
+                auto const& name = snapshot.types[types[t].first].name;
+                printf("%10s %12lu %14lu    %.*s\n", "", static_cast<unsigned long>(types[t].second.first), static_cast<unsigned long>(types[t].second.second),
+                    static_cast<int>(name.size()), name.data());
+            }
+        }
+    }
+
+    void printPaths(Snapshot const& snapshot, Analyzer& analyzer, std::string_view typeName, std::size_t maxPaths) {
+        printf("\nPaths to %.*s:\n", static_cast<int>(typeName.size()), typeName.data());
+        std::size_t printed = 0, matched = 0;
+        for (uint32_t i = 0; i < analyzer.objects.size(); i++) {
+            auto const& object = analyzer.objects[i];
+            if (snapshot.types[object.type].name.find(typeName) == std::string_view::npos) {
+                continue;
+            }
+            matched++;
+            if (printed >= maxPaths) {
+                continue;
+            }
+            printed++;
+            std::vector<uint32_t> chain{i};
+            while (!(analyzer.objects[chain.back()].parent & Analyzer::rootBit)) {
+                chain.push_back(analyzer.objects[chain.back()].parent);
+            }
+            auto const& root = analyzer.roots[analyzer.objects[chain.back()].parent & ~Analyzer::rootBit];
+            printf("  %s\n", root.name.c_str());
+            for (auto itr = chain.rbegin(); itr != chain.rend(); ++itr) {
+                auto const& current = analyzer.objects[*itr];
+                if (itr == chain.rbegin()) {
+                    printf("    -> %s\n", analyzer.Describe(current).c_str());
+                } else {
+                    auto const& parent = analyzer.objects[*(itr - 1)];
+                    printf("    -> .%s %s\n", analyzer.EdgeName(parent, current).c_str(), analyzer.Describe(current).c_str());
+                }
+            }
+        }
+        printf("  %zu reachable objects matched, %zu paths printed\n", matched, printed);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <snapshot.bhms> [--top <n>] [--owners] [--paths <type name>]... [--max-paths <n>]\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    std::size_t top = 30;
+    std::size_t maxPaths = 5;
+    bool owners = false;
+    std::vector<std::string_view> paths;
+    for (int i = 2; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--top" && i + 1 < argc) {
+            top = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--owners") {
+            owners = true;
+        } else if (arg == "--paths" && i + 1 < argc) {
+            paths.emplace_back(argv[++i]);
+        } else if (arg == "--max-paths" && i + 1 < argc) {
+            maxPaths = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    // Heap sections are read in place, the file is never copied into memory.
+    auto* data = static_cast<const uint8_t*>(mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Could not map %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Snapshot snapshot;
+    if (!parse(data, st.st_size, snapshot)) {
+        return 1;
+    }
+    uint64_t heapBytes = 0;
+    for (auto const& section : snapshot.heap) {
+        heapBytes += section.size;
+    }
+    Analyzer analyzer(snapshot);
+    analyzer.Run();
+    uint64_t reachableBytes = 0;
+    for (auto const& object : analyzer.objects) {
+        reachableBytes += object.size;
+    }
+    auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    printf("%s: %zu types, %zu heap sections (%lu bytes), %zu GC handles, %zu fixed allocations\n", path, snapshot.types.size(), snapshot.heap.size(),
+        static_cast<unsigned long>(heapBytes), snapshot.handles.size(), snapshot.fixed.size());
+    printf("%zu reachable objects (%lu bytes) from %zu roots, %zu only through fixed allocations, analyzed in %.1f ms\n", analyzer.objects.size(),
+        static_cast<unsigned long>(reachableBytes), analyzer.roots.size(), analyzer.objects.size() - analyzer.firstFromFixed, ms);
+
+    printHistogram(snapshot, analyzer, top);
+    if (owners) {
+        printOwners(snapshot, analyzer, top);
+    }
+    for (auto typeName : paths) {
+        printPaths(snapshot, analyzer, typeName, maxPaths);
+    }
+    return 0;
+}
@@ -0,0 +1,312 @@
+// Offline harness for the xref traces and signature scans done by il2cpp_functions::Init.
+// Maps an ARM64 libil2cpp.so from disk at a fake base, resolves its exports from .dynsym and runs the exact traces Init runs in game,
+// reporting every traced function as an offset into the image, along with how long the traces took.
+// Usage: beatsaber-hook-xref-harness <libil2cpp.so> [options]
+//   --base <hex>         Address to map the image at (default 0x7000000000)
+//   --repeat <n>         Runs the traces n times and reports the mean time
+//   --sig <label> <pat>  Also scans the executable segments for the pattern, using findUniquePattern (repeatable)
+//   --expect <file>      Compares the results against "<name> <hex offset>" lines, exiting with 1 on any mismatch
+//   --verbose            Keeps the library's (very chatty) logging
+// A trace that fails aborts, exactly like it would in game. The log on stderr names the trace that failed.
+// Keep the file named libil2cpp.so: the signature fallbacks in Init look for that name in /proc/self/maps.
+
+#include "../../shared/utils/il2cpp-functions.hpp"
+#include "../../shared/utils/utils.h"
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+    struct Segment {
+        uintptr_t start;
+        size_t size;
+        bool executable;
+    };
+
+    struct Image {
+        uintptr_t base = 0;
+        size_t size = 0;
+        std::vector<Segment> segments;
+        std::unordered_map<std::string, uintptr_t> exports;
+    };
+
+    template<class T>
+    bool readAt(int fd, off_t offset, T* out, std::size_t count = 1) {
+        return pread(fd, out, sizeof(T) * count, offset) == static_cast<ssize_t>(sizeof(T) * count);
+    }
+
+    /// @brief Maps every PT_LOAD segment at base + p_vaddr, the layout the dynamic linker would produce.
+    /// Relocations are not applied: the traces only decode instructions and read switch tables, which are position independent.
+    bool mapImage(int fd, uintptr_t base, Image& image) {
+        Elf64_Ehdr ehdr;
+        if (!readAt(fd, 0, &ehdr) || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_ident[EI_CLASS] != ELFCLASS64 || ehdr.e_machine != EM_AARCH64) {
+            fprintf(stderr, "Not an ARM64 ELF image!\n");
+            return false;
+        }
+        std::vector<Elf64_Phdr> phdrs(ehdr.e_phnum);
+        if (!readAt(fd, ehdr.e_phoff, phdrs.data(), phdrs.size())) {
+            fprintf(stderr, "Could not read the program headers!\n");
+            return false;
+        }
+        auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto pageDown = [pageSize](uintptr_t addr) { return addr & ~(pageSize - 1); };
+        auto pageUp = [pageSize](uintptr_t addr) { return (addr + pageSize - 1) & ~(pageSize - 1); };
+        uintptr_t end = 0;
+        for (auto const& ph : phdrs) {
+            if (ph.p_type == PT_LOAD) {
+                end = std::max<uintptr_t>(end, ph.p_vaddr + ph.p_memsz);
+            }
+        }
+        image.size = pageUp(end);
+        // Reserve the whole span zero filled first, which also backs .bss and any gaps between segments.
+        auto* reserved = mmap(reinterpret_cast<void*>(base), image.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (reserved == MAP_FAILED) {
+            fprintf(stderr, "Could not reserve 0x%zx bytes at 0x%lx: %s\n", image.size, base, strerror(errno));
+            return false;
+        }
+        image.base = reinterpret_cast<uintptr_t>(reserved);
+        uintptr_t mappedEnd = image.base;
+        for (auto const& ph : phdrs) {
+            if (ph.p_type != PT_LOAD) {
+                continue;
+            }
+            auto start = image.base + ph.p_vaddr;
+            if (ph.p_filesz > 0) {
+                auto pageStart = pageDown(start);
+                if (pageStart >= mappedEnd && (ph.p_offset & (pageSize - 1)) == (start & (pageSize - 1))) {
+                    // Map the file itself, so the image shows up by name in /proc/self/maps.
+                    auto length = ph.p_filesz + (start - pageStart);
+                    if (mmap(reinterpret_cast<void*>(pageStart), length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, pageDown(ph.p_offset)) == MAP_FAILED) {
+                        fprintf(stderr, "Could not map segment at 0x%lx: %s\n", ph.p_vaddr, strerror(errno));
+                        return false;
+                    }
+                    // The rest of the last file page belongs to .bss, or to nothing at all.
+                    auto fileEnd = start + ph.p_filesz;
+                    memset(reinterpret_cast<void*>(fileEnd), 0, pageUp(fileEnd) - fileEnd);
+                } else if (!readAt(fd, ph.p_offset, reinterpret_cast<uint8_t*>(start), ph.p_filesz)) {
+                    // Segments sharing a page with the previous one are copied instead.
+                    fprintf(stderr, "Could not read segment at 0x%lx!\n", ph.p_vaddr);
+                    return false;
+                }
+            }
+            mappedEnd = pageUp(start + ph.p_memsz);
+            image.segments.push_back({start, ph.p_memsz, (ph.p_flags & PF_X) != 0});
+        }
+        return true;
+    }
+
+    /// @brief Collects every defined symbol in .dynsym.
+    bool readExports(int fd, Image& image) {
+        Elf64_Ehdr ehdr;
+        readAt(fd, 0, &ehdr);
+        std::vector<Elf64_Shdr> shdrs(ehdr.e_shnum);
+        if (shdrs.empty() || !readAt(fd, ehdr.e_shoff, shdrs.data(), shdrs.size())) {
+            fprintf(stderr, "The image has no section headers, cannot find .dynsym!\n");
+            return false;
+        }
+        for (auto const& sh : shdrs) {
+            if (sh.sh_type != SHT_DYNSYM || sh.sh_link >= shdrs.size()) {
+                continue;
+            }
+            auto const& strSh = shdrs[sh.sh_link];
+            std::vector<Elf64_Sym> syms(sh.sh_size / sizeof(Elf64_Sym));
+            std::vector<char> strings(strSh.sh_size + 1);
+            if (!readAt(fd, sh.sh_offset, syms.data(), syms.size()) || !readAt(fd, strSh.sh_offset, strings.data(), strSh.sh_size)) {
+                fprintf(stderr, "Could not read .dynsym!\n");
+                return false;
+            }
+            for (auto const& sym : syms) {
+                if (sym.st_shndx != SHN_UNDEF && sym.st_name < strSh.sh_size) {
+                    image.exports.emplace(&strings[sym.st_name], image.base + sym.st_value);
+                }
+            }
+            return true;
+        }
+        fprintf(stderr, "The image has no .dynsym!\n");
+        return false;
+    }
+
+    void* resolveExport(void* ctx, const char* symbol) {
+        auto& exports = static_cast<Image*>(ctx)->exports;
+        auto itr = exports.find(symbol);
+        return itr == exports.end() ? nullptr : reinterpret_cast<void*>(itr->second);
+    }
+
+    struct Result {
+        std::string name;
+        // Offset into the image, or -1 if not found (or found outside of the image)
+        int64_t offset;
+        bool multiple = false;
+    };
+
+    int64_t offsetOf(Image const& image, const void* ptr) {
+        auto addr = reinterpret_cast<uintptr_t>(ptr);
+        return (addr >= image.base && addr < image.base + image.size) ? static_cast<int64_t>(addr - image.base) : -1;
+    }
+
+    std::vector<Result> tracedResults(Image const& image) {
+        #define TRACED(name) {#name, offsetOf(image, reinterpret_cast<const void*>(il2cpp_functions::il2cpp_##name))}
+        return {
+            TRACED(Class_Init),
+            TRACED(MetadataCache_GetTypeInfoFromTypeDefinitionIndex),
+            TRACED(MetadataCache_GetTypeInfoFromTypeIndex),
+            TRACED(_Type_GetName_),
+            TRACED(Class_FromIl2CppType),
+            TRACED(GenericClass_GetClass),
+            TRACED(Class_GetPtrClass),
+            TRACED(Assembly_GetAllAssemblies),
+            TRACED(GC_free),
+            TRACED(GarbageCollector_SetWriteBarrier),
+            TRACED(GarbageCollector_AllocateFixed),
+            {"il2cpp_defaults", offsetOf(image, il2cpp_functions::defaults)},
+        };
+        #undef TRACED
+    }
+
+    void printResult(Result const& result) {
+        if (result.offset < 0) {
+            printf("  %-52s not found\n", result.name.c_str());
+        } else {
+            printf("  %-52s 0x%08lX%s\n", result.name.c_str(), result.offset, result.multiple ? " (MULTIPLE MATCHES)" : "");
+        }
+    }
+
+    /// @brief Compares the results against the expectations file, which holds "<name> <hex offset>" lines and # comments.
+    /// @return The number of mismatches, or -1 if the file could not be read.
+    int checkExpectations(const char* path, std::vector<Result> const& results) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            fprintf(stderr, "Could not open expectations file: %s\n", path);
+            return -1;
+        }
+        int mismatches = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream ss(line);
+            std::string name, offset;
+            if (!(ss >> name >> offset) || name.starts_with('#')) {
+                continue;
+            }
+            auto expected = static_cast<int64_t>(std::stoull(offset, nullptr, 16));
+            auto itr = std::find_if(results.begin(), results.end(), [&](auto const& r) { return r.name == name; });
+            if (itr == results.end()) {
+                printf("MISMATCH %s: expected 0x%lX, but it was never resolved\n", name.c_str(), expected);
+                mismatches++;
+            } else if (itr->offset != expected || itr->multiple) {
+                printf("MISMATCH %s: expected 0x%lX, got 0x%lX%s\n", name.c_str(), expected, itr->offset, itr->multiple ? " (multiple matches)" : "");
+                mismatches++;
+            }
+        }
+        return mismatches;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <libil2cpp.so> [--base <hex>] [--repeat <n>] [--sig <label> <pattern>]... [--expect <file>] [--verbose]\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    uintptr_t base = 0x7000000000;
+    int repeat = 1;
+    const char* expectPath = nullptr;
+    bool verbose = false;
+    std::vector<std::pair<std::string, std::string>> sigs;
+    for (int i = 2; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if (arg == "--base" && i + 1 < argc) {
+            base = std::stoull(argv[++i], nullptr, 16);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--sig" && i + 2 < argc) {
+            sigs.emplace_back(argv[i + 1], argv[i + 2]);
+            i += 2;
+        } else if (arg == "--expect" && i + 1 < argc) {
+            expectPath = argv[++i];
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (!verbose) {
+        Logger::get().disable();
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    Image image;
+    auto mapStart = std::chrono::steady_clock::now();
+    if (!mapImage(fd, base, image) || !readExports(fd, image)) {
+        return 1;
+    }
+    close(fd);
+    auto mapMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mapStart).count();
+    printf("Mapped %s at 0x%lx (0x%zx bytes, %zu exports) in %.2f ms\n", path, image.base, image.size, image.exports.size(), mapMs);
+
+    auto traceStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        il2cpp_functions::initialized = false;
+        il2cpp_functions::Init(&resolveExport, &image);
+    }
+    auto traceMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - traceStart).count() / repeat;
+    printf("Init xref traces: %.3f ms (mean of %d)\n", traceMs, repeat);
+    auto results = tracedResults(image);
+    for (auto const& result : results) {
+        printResult(result);
+    }
+
+    for (auto const& [label, pattern] : sigs) {
+        Result result{label, -1};
+        auto sigStart = std::chrono::steady_clock::now();
+        for (auto const& segment : image.segments) {
+            if (!segment.executable) {
+                continue;
+            }
+            bool multiple = false;
+            auto match = findUniquePattern(multiple, segment.start, pattern.c_str(), label.c_str(), segment.size);
+            if (match) {
+                result.multiple |= multiple || result.offset >= 0;
+                if (result.offset < 0) {
+                    result.offset = offsetOf(image, reinterpret_cast<const void*>(match));
+                }
+            }
+        }
+        auto sigMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sigStart).count();
+        printf("Sigscan %s: %.3f ms\n", label.c_str(), sigMs);
+        printResult(result);
+        results.push_back(result);
+    }
+
+    if (expectPath) {
+        auto mismatches = checkExpectations(expectPath, results);
+        if (mismatches < 0) {
+            return 1;
+        }
+        if (mismatches > 0) {
+            printf("%d mismatch(es) against %s\n", mismatches, expectPath);
+            return 1;
+        }
+        printf("All results match %s\n", expectPath);
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+#ifndef CONFIG_BINDING_H
+#define CONFIG_BINDING_H
+// Provides a typed binding between a plain C++ struct and a Configuration.
+
+#include <bitset>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "config-utils.hpp"
+
+namespace config_binding {
+    /// @brief Maps a single member of T to a JSON member name.
+    /// @tparam T The bound struct.
+    /// @tparam V The type of the member.
+    template<class T, class V>
+    struct FieldBinding {
+        std::string_view name;
+        V T::* member;
+    };
+
+    /// @brief Creates a FieldBinding. The name must outlive the binding, which is always the case for string literals.
+    /// @param name The JSON member name.
+    /// @param member The pointer to the member of T.
+    /// @return The created binding.
+    template<class T, class V>
+    constexpr FieldBinding<T, V> BindField(std::string_view name, V T::* member) {
+        return {name, member};
+    }
+
+    /// @brief The fields of T that are bound to JSON members, as a tuple of FieldBinding.
+    /// Defaults to T::config_fields, specialize this to bind a type you cannot modify.
+    /// Example:
+    ///     struct MyConfig {
+    ///         bool enabled = true;
+    ///         float speed = 1.0f;
+    ///         static constexpr auto config_fields = std::make_tuple(
+    ///             config_binding::BindField("enabled", &MyConfig::enabled),
+    ///             config_binding::BindField("speed", &MyConfig::speed)
+    ///         );
+    ///     };
+    template<class T>
+    struct Fields {
+        static constexpr auto value = T::config_fields;
+    };
+
+    template<class V>
+    constexpr bool is_bindable_v = std::is_same_v<V, bool> || std::is_arithmetic_v<V> || std::is_enum_v<V> || std::is_same_v<V, std::string>;
+
+    /// @brief Reads a JSON value into the provided field.
+    /// @return True if the JSON value had a compatible type, false (leaving out untouched) otherwise.
+    template<class V>
+    bool ReadValue(ConfigValue const& value, V& out) {
+        static_assert(is_bindable_v<V>, "Config bindings only support bool, arithmetic, enum and std::string fields!");
+        if constexpr (std::is_same_v<V, bool>) {
+            if (!value.IsBool()) return false;
+            out = value.GetBool();
+        } else if constexpr (std::is_enum_v<V>) {
+            if (!value.IsInt64()) return false;
+            out = static_cast<V>(value.GetInt64());
+        } else if constexpr (std::is_floating_point_v<V>) {
+            if (!value.IsNumber()) return false;
+            out = static_cast<V>(value.GetDouble());
+        } else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>) {
+            if (!value.IsInt64()) return false;
+            out = static_cast<V>(value.GetInt64());
+        } else if constexpr (std::is_integral_v<V>) {
+            if (!value.IsUint64()) return false;
+            out = static_cast<V>(value.GetUint64());
+        } else {
+            if (!value.IsString()) return false;
+            out.assign(value.GetString(), value.GetStringLength());
+        }
+        return true;
+    }
+
+    /// @brief Writes the provided field into a JSON value.
+    template<class V>
+    void WriteValue(ConfigValue& value, V const& in, ConfigDocument::AllocatorType& allocator) {
+        static_assert(is_bindable_v<V>, "Config bindings only support bool, arithmetic, enum and std::string fields!");
+        if constexpr (std::is_same_v<V, bool>) {
+            value.SetBool(in);
+        } else if constexpr (std::is_enum_v<V>) {
+            value.SetInt64(static_cast<int64_t>(in));
+        } else if constexpr (std::is_floating_point_v<V>) {
+            value.SetDouble(in);
+        } else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>) {
+            value.SetInt64(in);
+        } else if constexpr (std::is_integral_v<V>) {
+            value.SetUint64(in);
+        } else {
+            value.SetString(in.data(), in.size(), allocator);
+        }
+    }
+}
+
+/// @brief Binds a plain struct T to a Configuration.
+/// The JSON document is only walked on Load/Reload and on Write, reads in between are plain member loads.
+/// Fields changed via set are tracked, and Write only reserializes when at least one field changed.
+/// @tparam T The struct to bind. See config_binding::Fields for how to declare its fields.
+template<class T>
+class BoundConfig {
+    static constexpr auto& fields = config_binding::Fields<T>::value;
+    static constexpr std::size_t fieldCount = std::tuple_size_v<std::remove_cvref_t<decltype(fields)>>;
+
+    template<auto Member, std::size_t I = 0>
+    static constexpr std::size_t indexOf() {
+        if constexpr (I >= fieldCount) {
+            return fieldCount;
+        } else if constexpr (std::is_same_v<decltype(std::get<I>(fields).member), decltype(Member)>) {
+            if (std::get<I>(fields).member == Member) {
+                return I;
+            }
+            return indexOf<Member, I + 1>();
+        } else {
+            return indexOf<Member, I + 1>();
+        }
+    }
+
+public:
+    /// @brief Creates a binding over the provided Configuration, which must outlive this instance.
+    /// The bound values start out as a default constructed T, until Load is called.
+    explicit BoundConfig(Configuration& config) : config(config) {}
+
+    /// @brief Loads the Configuration (if not yet loaded) and deserializes every bound field.
+    /// Fields that are missing or hold an incompatible type keep their default value, and are written out on the next Write.
+    void Load() {
+        config.Load();
+        deserialize();
+    }
+    /// @brief Reloads the Configuration from disk and deserializes every bound field, discarding unwritten changes.
+    void Reload() {
+        config.Reload();
+        deserialize();
+    }
+
+    /// @brief Returns the bound values.
+    const T& get() const noexcept {
+        return values;
+    }
+    const T* operator->() const noexcept {
+        return &values;
+    }
+
+    /// @brief Sets a bound field, marking it dirty if the value changed.
+    /// @tparam Member The pointer to the member of T to set. Must be one of the bound fields.
+    /// @param value The value to set.
+    template<auto Member, class V>
+    void set(V&& value) {
+        constexpr auto idx = indexOf<Member>();
+        static_assert(idx < fieldCount, "The provided member is not a bound config field!");
+        auto& field = values.*Member;
+        if (!(field == value)) {
+            field = std::forward<V>(value);
+            dirty.set(idx);
+        }
+    }
+
+    /// @brief Marks every field as dirty, for when values were changed outside of set.
+    void markAllDirty() noexcept {
+        dirty.set();
+    }
+    /// @brief Returns whether any field changed since the last Load, Reload or Write.
+    bool isDirty() const noexcept {
+        return dirty.any();
+    }
+
+    /// @brief Serializes the dirty fields into the JSON document and writes it.
+    /// Does nothing if no field changed.
+    /// @return True if a write was issued, false otherwise.
+    bool Write() {
+        if (dirty.none()) {
+            return false;
+        }
+        if (!config.config.IsObject()) {
+            config.config.SetObject();
+            dirty.set();
+        }
+        serializeDirty(std::make_index_sequence<fieldCount>{});
+        dirty.reset();
+        config.Write();
+        return true;
+    }
+
+private:
+    void deserialize() {
+        dirty.reset();
+        deserializeAll(std::make_index_sequence<fieldCount>{});
+    }
+
+    template<std::size_t... I>
+    void deserializeAll(std::index_sequence<I...>) {
+        (deserializeField<I>(), ...);
+    }
+
+    template<std::size_t I>
+    void deserializeField() {
+        auto const& binding = std::get<I>(fields);
+        auto& doc = config.config;
+        if (doc.IsObject()) {
+            auto itr = doc.FindMember(ConfigValue::StringRefType(binding.name.data(), binding.name.size()));
+            if (itr != doc.MemberEnd() && config_binding::ReadValue(itr->value, values.*(binding.member))) {
+                return;
+            }
+        }
+        dirty.set(I);
+    }
+
+    template<std::size_t... I>
+    void serializeDirty(std::index_sequence<I...>) {
+        (serializeField<I>(), ...);
+    }
+
+    template<std::size_t I>
+    void serializeField() {
+        if (!dirty.test(I)) {
+            return;
+        }
+        auto const& binding = std::get<I>(fields);
+        auto& doc = config.config;
+        auto& allocator = doc.GetAllocator();
+        auto name = ConfigValue::StringRefType(binding.name.data(), binding.name.size());
+        auto itr = doc.FindMember(name);
+        if (itr != doc.MemberEnd()) {
+            config_binding::WriteValue(itr->value, values.*(binding.member), allocator);
+        } else {
+            ConfigValue value;
+            config_binding::WriteValue(value, values.*(binding.member), allocator);
+            doc.AddMember(ConfigValue(binding.name.data(), binding.name.size(), allocator), value, allocator);
+        }
+    }
+
+    Configuration& config;
+    T values{};
+    std::bitset<fieldCount> dirty;
+};
+
+#endif /* CONFIG_BINDING_H */
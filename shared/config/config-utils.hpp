@@ -10,6 +10,7 @@
 #include "modloader/shared/modloader.hpp"
 #include <string>
 #include <string_view>
+#include <functional>
 
 // typedef rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::CrtAllocator> ConfigDocument;
 // typedef rapidjson::GenericValue<rapidjson::UTF8<>, rapidjson::CrtAllocator> ConfigValue;
@@ -34,28 +35,58 @@ public:
     Configuration(const ModInfo& info_) : info(info_) {
         filePath = Configuration::getConfigFilePath(info_);
     }
+    // Moving a watched config moves its watch (and callback) to the new config. A copy is not watched.
     Configuration(Configuration&& other) :
         info(std::move(other.info)),
         filePath(std::move(other.filePath))
     {
         config.Swap(other.config);
+        moveState(other);
     }
     Configuration(const Configuration& other) :
         info(other.info),
         filePath(other.filePath)
     {
-        config.CopyFrom(other.config, config.GetAllocator());
+        // Strings parsed in place point into other's allocator, so they are copied too.
+        config.CopyFrom(other.config, config.GetAllocator(), true);
+        copyState(other);
     }
+    // Sets whether Load should use (and Write maintain) a binary snapshot next to the JSON file, to skip parsing text when the JSON did not change.
+    void UseSnapshot(bool use = true);
     // Loads JSON config
+    // The config is always parsed into config's own allocator, so a reference to it stays valid across Load, Reload and ApplyPendingReload.
+    // Like rapidjson's Parse, the memory of replaced values is only released with the Configuration.
     void Load();
     // Reloads JSON config
     void Reload();
-    // Writes JSON config
+    // Writes JSON config asynchronously.
+    // The document is serialized on the calling thread, and the file is written on a background thread.
+    // Writes to the same config within a short window are coalesced, only the last one is written.
+    // Pending writes are flushed when the process exits normally, but not if it is killed: use WriteSync (or FlushWrites) for changes that must not be lost.
     void Write();
+    // Writes JSON config on the calling thread, replacing any pending asynchronous write.
+    void WriteSync();
+    // Blocks until all pending asynchronous config writes have been written.
+    static void FlushWrites();
+    // Starts watching the JSON file for external changes, on a single watcher thread shared by all configs.
+    // Changes are debounced and parsed on the watcher thread, then published for ApplyPendingReload, after which callback is invoked (on the watcher thread).
+    // Writes made by this process are not reported.
+    void WatchForChanges(std::function<void(Configuration&)> callback);
+    // Stops watching the JSON file. Once this returns, the callback will not be invoked again.
+    void StopWatching();
+    // Swaps in the document parsed by the watcher, if there is one. Call this from the thread that reads config.
+    // This is a single atomic load while no watched config has a pending reload, so it is cheap to call every frame.
+    // Returns true if the config was replaced.
+    bool ApplyPendingReload();
+    ~Configuration();
 private:
     static std::optional<std::string> configDir;
     bool ensureObject();
+    bool loadSnapshot();
+    void moveState(Configuration& other);
+    void copyState(const Configuration& other);
     std::string filePath;
+    friend struct ConfigWatcher;
 };
 
 // SETTINGS
@@ -76,8 +107,10 @@ typedef enum JsonParseError {
 
 // CONFIG
 // Parses the JSON of the filename, and returns whether it succeeded or not
+// Parsed in place from a copy in doc's own allocator. doc is left untouched on failure.
 bool parsejsonfile(rapidjson::Document& doc, std::string_view filename);
 // Parses a JSON string, and returns whether it succeeded or not
+// Parsed in place from a copy in doc's own allocator. doc is left untouched on failure.
 bool parsejson(ConfigDocument& doc, std::string_view js);
 
 /// @brief Returns a path to the persistent data directory for the provided const ModInfo&.
@@ -90,4 +123,11 @@ std::string getDataDir(const ModInfo& info);
 /// @return The path to the directory.
 std::string getDataDir(std::string_view id);
 
+/// @brief Returns a path for a new file in the persistent data directory for the provided const ModInfo&, creating the directory if it does not exist.
+/// @param info The const ModInfo& to find a path for.
+/// @param kind What the file holds, which starts its name.
+/// @param extension The extension of the file, without the dot.
+/// @return The path to the file, named "<kind>-<unix time>.<extension>".
+std::string getDataFilePath(const ModInfo& info, std::string_view kind, std::string_view extension);
+
 #endif /* CONFIG_UTILS_H */
@@ -9,6 +9,17 @@
 #define RAPIDJSON_HAS_STDSTRING 1
 #endif
 
+// Enable rapidjson's SIMD whitespace skipping and string scanning where the target supports it.
+#if !defined(RAPIDJSON_NEON) && !defined(RAPIDJSON_SSE42) && !defined(RAPIDJSON_SSE2)
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RAPIDJSON_NEON
+#elif defined(__SSE4_2__)
+#define RAPIDJSON_SSE42
+#elif defined(__SSE2__)
+#define RAPIDJSON_SSE2
+#endif
+#endif
+
 #include <type_traits>
 #include "../rapidjson/include/rapidjson/rapidjson.h"
 #include "../rapidjson/include/rapidjson/document.h"
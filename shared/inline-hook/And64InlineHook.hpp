@@ -30,16 +30,21 @@
 #pragma once
 #include <stdint.h>
 #define A64_MAX_BACKUPS 1024
-#ifdef __aarch64__
+#if defined(__aarch64__) || defined(BS_HOOK_HOST_BUILD)
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 
-
+#ifdef __aarch64__
     void A64HookFunction(void *const symbol, void *const replace, void **result);
     void *A64HookFunctionV(void *const symbol, void *const replace,
                            void *const rwx, const uintptr_t rwx_size);
+#endif
+
+    // Relocates count (at most 5) instructions from original into trampoline, followed by a branch back to original + count.
+    // This is what A64HookFunctionV does to build its trampoline, exposed for testing. Returns the number of bytes written.
+    uintptr_t A64FixInstructions(uint32_t *const original, const int32_t count, uint32_t *const trampoline);
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,9 @@
 #include <cstddef>
 #include <new> // bad_alloc, bad_array_new_length
 #include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
 
 // Okay, so because we know that GC isn't overwriting heap (since it just calls the same shared calloc/malloc impls)
 // we are confident that a new operator here isn't necessary or useful.
@@ -15,6 +18,13 @@
 /// @return The allocated instance.
 [[nodiscard]] void *gc_alloc_specific(size_t sz);
 
+/// @brief Same as gc_alloc_specific, but attributes the allocation to the provided call site for allocation accounting.
+/// Used by wrappers (such as il2cpp_utils::createManual) so that allocations are charged to their caller rather than to this library.
+/// @param sz The size to allocate an instance of.
+/// @param site An address within the code that requested this allocation.
+/// @return The allocated instance.
+[[nodiscard]] void *gc_alloc_specific_from(size_t sz, const void *site);
+
 /// @brief Deletes the provided allocated instance from the gc_alloc_specific function defined here.
 /// Other pointers will cause undefined behavior.
 /// This function will call GC_free if there is both a GC_Alloc and GC_Free implementation available, free otherwise.
@@ -22,6 +32,56 @@
 /// @return The allocated instance.
 void gc_free_specific(void *ptr) noexcept;
 
+namespace gc_accounting {
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    }
+
+    /// @brief Per-module allocation statistics, aggregated over every thread.
+    struct ModuleStats {
+        /// @brief The path of the module the allocations were attributed to, or "<unknown>".
+        std::string module;
+        /// @brief The number of allocations made from this module, managed and fixed.
+        std::size_t allocCount;
+        /// @brief The number of bytes allocated from this module, managed and fixed.
+        std::size_t allocBytes;
+        /// @brief The number of bytes in fixed allocations (gc_alloc_specific) made from this module that have not been freed yet.
+        std::size_t liveFixedBytes;
+    };
+
+    /// @brief A fixed allocation (gc_alloc_specific) that has not been freed yet.
+    struct FixedAllocation {
+        void* ptr;
+        std::size_t size;
+        /// @brief An address within the code that requested the allocation.
+        const void* site;
+    };
+
+    /// @brief Enables or disables allocation accounting. Disabled by default.
+    /// While disabled, recording an allocation costs a single relaxed atomic load.
+    void SetEnabled(bool value) noexcept;
+    /// @brief Returns whether allocation accounting is currently enabled.
+    inline bool IsEnabled() noexcept {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+    /// @brief Records an allocation of the provided size from the provided call site.
+    /// Counters are kept per thread and are lock free, except for the first allocation on a new thread.
+    /// @param site An address within the code that requested this allocation.
+    /// @param sz The size of the allocation.
+    void RecordAlloc(const void* site, std::size_t sz) noexcept;
+    /// @brief Collects the statistics for every module that allocated since accounting was enabled or last reset.
+    /// @return The statistics, sorted by allocated bytes, descending.
+    std::vector<ModuleStats> GetModuleStats();
+    /// @brief Returns every fixed allocation made (and not freed) while accounting was enabled.
+    /// These are GC roots: il2cpp_utils::MemorySnapshot uses them to attribute objects kept alive by SafePtr (and the like) to their owners.
+    std::vector<FixedAllocation> GetLiveFixedAllocations();
+    /// @brief Logs the per-module statistics, along with allocation rates since the last report, and the top allocating call sites.
+    /// @param topN The number of call sites to log.
+    void LogReport(std::size_t topN = 10);
+    /// @brief Resets all counters. Live fixed allocations remain tracked.
+    void Reset() noexcept;
+}
+
 /// @brief Reallocation implementation is equivalent to: alloc + free
 /// @param ptr The pointer to resize.
 /// @param new_size The new size of the memory.
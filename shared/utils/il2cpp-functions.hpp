@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include "logging.hpp"
 #include "utils.h"
 
@@ -288,11 +289,11 @@ class il2cpp_functions {
     API_FUNC(const char*, method_get_param_name, (const MethodInfo * method, uint32_t index));
 
     // ONLY IF THE PROFILER EXISTS FOR UNITY_2019
-    API_FUNC(void, profiler_install, (Il2CppProfiler * prof, Il2CppProfileFunc shutdown_callback));
-    API_FUNC(void, profiler_set_events, (Il2CppProfileFlags events));
-    API_FUNC(void, profiler_install_enter_leave, (Il2CppProfileMethodFunc enter, Il2CppProfileMethodFunc fleave));
-    API_FUNC(void, profiler_install_allocation, (Il2CppProfileAllocFunc callback));
-    API_FUNC(void, profiler_install_gc, (Il2CppProfileGCFunc callback, Il2CppProfileGCResizeFunc heap_resize_callback));
+    API_FUNC_VISIBLE(void, profiler_install, (Il2CppProfiler * prof, Il2CppProfileFunc shutdown_callback));
+    API_FUNC_VISIBLE(void, profiler_set_events, (Il2CppProfileFlags events));
+    API_FUNC_VISIBLE(void, profiler_install_enter_leave, (Il2CppProfileMethodFunc enter, Il2CppProfileMethodFunc fleave));
+    API_FUNC_VISIBLE(void, profiler_install_allocation, (Il2CppProfileAllocFunc callback));
+    API_FUNC_VISIBLE(void, profiler_install_gc, (Il2CppProfileGCFunc callback, Il2CppProfileGCResizeFunc heap_resize_callback));
     API_FUNC(void, profiler_install_fileio, (Il2CppProfileFileIOFunc callback));
     API_FUNC(void, profiler_install_thread, (Il2CppProfileThreadFunc start, Il2CppProfileThreadFunc end));
 
@@ -364,8 +365,8 @@ class il2cpp_functions {
     API_FUNC(const MethodInfo*, image_get_entry_point, (const Il2CppImage * image));
     API_FUNC(size_t, image_get_class_count, (const Il2CppImage * image));
     API_FUNC(const Il2CppClass*, image_get_class, (const Il2CppImage * image, size_t index));
-    API_FUNC(Il2CppManagedMemorySnapshot*, capture_memory_snapshot, ());
-    API_FUNC(void, free_captured_memory_snapshot, (Il2CppManagedMemorySnapshot * snapshot));
+    API_FUNC_VISIBLE(Il2CppManagedMemorySnapshot*, capture_memory_snapshot, ());
+    API_FUNC_VISIBLE(void, free_captured_memory_snapshot, (Il2CppManagedMemorySnapshot * snapshot));
     API_FUNC(void, set_find_plugin_callback, (Il2CppSetFindPlugInCallback method));
     API_FUNC(void, register_log_callback, (Il2CppLogCallback method));
     API_FUNC(void, debugger_set_agent_options, (const char* options));
@@ -430,6 +431,8 @@ class il2cpp_functions {
     static std::remove_pointer_t<decltype(s_Il2CppMetadataRegistrationPtr)> s_Il2CppMetadataRegistration;
 
     static const Il2CppDefaults* defaults;
+    // The mutex Image::ClassFromName creates each image's nameToClassHashTable under (s_ClassFromNameMutex), or nullptr if it was not found.
+    static pthread_mutex_t* s_ClassFromNameMutex;
 
     // must be done on-demand because the pointers aren't necessarily correct at the time of il2cpp_functions::Init
     static void CheckS_GlobalMetadata() {
@@ -455,12 +458,19 @@ class il2cpp_functions {
     static const Il2CppGenericContainer* MetadataCache_GetGenericContainerFromIndex(GenericContainerIndex index);
     static const Il2CppGenericParameter* MetadataCache_GetGenericParameterFromIndex(GenericParameterIndex index);
     static Il2CppClass* MetadataCache_GetNestedTypeFromIndex(NestedTypeIndex index);
+    // Same as MetadataCache_GetNestedTypeFromIndex, without creating the class.
+    static TypeDefinitionIndex MetadataCache_GetNestedTypeDefinitionIndexFromIndex(NestedTypeIndex index);
     static TypeDefinitionIndex MetadataCache_GetIndexForTypeDefinition(const Il2CppClass* typeDefinition);
 
     // Whether all of the il2cpp functions have been initialized or not
     static bool initialized;
     // Initializes all of the IL2CPP functions via dlopen and dlsym for use.
     static void Init();
+    // Looks up an exported symbol by name, returning nullptr if it does not exist.
+    using SymbolResolver = void* (*)(void* ctx, const char* symbol);
+    // Initializes all of the IL2CPP functions, resolving the exports with the provided resolver instead of dlsym.
+    // Used by tools that map a libil2cpp.so image themselves, such as the offline xref harness.
+    static void Init(SymbolResolver resolve, void* ctx);
 
     static LoggerContextObject& getFuncLogger();
 };
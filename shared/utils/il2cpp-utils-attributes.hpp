@@ -0,0 +1,37 @@
+#pragma once
+#include "il2cpp-functions.hpp"
+#include <vector>
+
+namespace il2cpp_utils {
+    // Custom attribute queries over the il2cpp_custom_attrs_* API, cached per (member, attribute class).
+    // il2cpp creates a new Il2CppCustomAttrInfo for each query and constructs attribute objects each time they are asked for:
+    // here, each answer is computed once, and constructed attributes are kept alive by a GC handle for the lifetime of the process.
+    // An attribute class matches attributes of that class or of any class derived from it, as il2cpp_custom_attrs_has_attr does.
+    // All of these are safe to call from several threads at once.
+
+    /// @brief Returns whether a class has an attribute of the provided class.
+    bool HasAttribute(Il2CppClass* klass, Il2CppClass* attributeClass) noexcept;
+    /// @brief Returns whether a method has an attribute of the provided class.
+    bool HasAttribute(const MethodInfo* method, Il2CppClass* attributeClass) noexcept;
+
+    /// @brief Returns the attribute of the provided class on a class, constructing it on first use.
+    /// @returns The attribute, or nullptr if the class does not have one.
+    Il2CppObject* GetAttribute(Il2CppClass* klass, Il2CppClass* attributeClass) noexcept;
+    /// @brief Returns the attribute of the provided class on a method, constructing it on first use.
+    /// @returns The attribute, or nullptr if the method does not have one.
+    Il2CppObject* GetAttribute(const MethodInfo* method, Il2CppClass* attributeClass) noexcept;
+
+    /// @brief Returns every attribute of a class, as il2cpp_custom_attrs_construct constructs them, on first use.
+    /// @returns The array of attributes, or nullptr if the class has none.
+    Il2CppArray* GetAttributes(Il2CppClass* klass) noexcept;
+    /// @brief Returns every attribute of a method, as il2cpp_custom_attrs_construct constructs them, on first use.
+    /// @returns The array of attributes, or nullptr if the method has none.
+    Il2CppArray* GetAttributes(const MethodInfo* method) noexcept;
+
+    /// @brief Finds every class (from every assembly) with an attribute of the provided class, for discovering types at startup.
+    /// Images are scanned in parallel (large ones in slices), and every answer is added to the HasAttribute cache.
+    /// @param attributeClass The attribute class to look for.
+    /// @param threads The number of threads to scan with, 0 for one per core.
+    /// @returns The classes, grouped by image in assembly order, then in the order of their image.
+    ::std::vector<Il2CppClass*> FindClassesWithAttribute(Il2CppClass* attributeClass, uint32_t threads = 0) noexcept;
+}
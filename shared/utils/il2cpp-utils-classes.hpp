@@ -7,6 +7,7 @@
 #include "il2cpp-functions.hpp"
 #include "il2cpp-utils-methods.hpp"
 #include "base-wrapper-type.hpp"
+#include <functional>
 #include <optional>
 #include <vector>
 
@@ -65,8 +66,35 @@ namespace il2cpp_utils {
     // Logs information about the given Il2CppClass* as log(DEBUG)
     void LogClass(LoggerContextObject& logger, Il2CppClass* klass, bool logParents = false) noexcept;
 
+    /// @brief Returns the instances of a generic class the game was compiled with, such as every List<T> for List<T> (or for any List<T>).
+    /// The definition -> instances map is built on first use and only extended afterwards, lookups from several threads share it.
+    /// @param klass The generic type definition, or any instance of it.
+    /// @param onlyCreated Whether to only return instances il2cpp has already created classes for, instead of creating the rest.
+    /// @returns The instances, or an empty vector if klass is not generic.
+    ::std::vector<Il2CppClass*> GetGenericInstances(const Il2CppClass* klass, bool onlyCreated = false) noexcept;
+
+    /// @brief How FindClasses matches the query against class names.
+    enum struct ClassNameQuery {
+        /// @brief Classes whose name (without namespace) starts with the query. Nested classes are named "Outer/Inner".
+        Prefix,
+        /// @brief Classes directly in the namespace the query names, the empty query being the global namespace.
+        Namespace,
+        /// @brief Classes whose "Namespace.Name" matches the query, where '*' matches any run of characters and '?' any one character.
+        Wildcard
+    };
+
+    /// @brief Finds every class (from every assembly) whose name matches the query.
+    /// The name index is built from the metadata on first use, without creating any class, along with the names registered in il2cpp's class hash tables
+    /// (such as by custom type libraries). It is rebuilt on the next lookup after names are registered through AddType(s)ToNametoClassHashTable.
+    /// Lookups cost the length of the query plus the matches,
+    /// except wildcard queries, which scan every name starting with the part of the query before its first wildcard.
+    /// @param query The prefix, namespace or pattern to match.
+    /// @param kind How to match the query.
+    /// @returns The matching classes, in natural order of their full names (BenchClass2 before BenchClass10).
+    ::std::vector<Il2CppClass*> FindClasses(::std::string_view query, ClassNameQuery kind = ClassNameQuery::Prefix) noexcept;
+
     // Logs all classes (from every namespace) that start with the given prefix
-    // WARNING: THIS FUNCTION IS VERY SLOW. ONLY USE THIS FUNCTION ONCE AND WITH A FAIRLY SPECIFIC PREFIX!
+    // Matches are found with FindClasses, but logging each of them is slow, so use a fairly specific prefix!
     void LogClasses(LoggerContextObject& logger, ::std::string_view classPrefix, bool logParents = false) noexcept;
 
     // Gets the System.Type Il2CppObject* (actually an Il2CppReflectionType*) for an Il2CppClass*
@@ -149,8 +177,14 @@ namespace il2cpp_utils {
         return tOthers;
     }
 
+    /// @brief Adds every type of an image (nested types as "Outer/Inner") to its class hash table, skipping names already in it.
+    /// Nested names are joined into a single allocation, and inserted under the lock il2cpp creates the table under (when it was found by xref).
+    /// @param img The image to register the types of.
+    /// @returns The number of names added.
+    size_t AddTypesToNametoClassHashTable(const Il2CppImage* img);
+
     // Adds the given TypeDefinitionIndex to the class hash table of a given image
-    // Mainly used in LogClasses
+    // Unsynchronized, and allocates each nested name: prefer AddTypesToNametoClassHashTable for whole images
     void AddTypeToNametoClassHashTable(const Il2CppImage* img, TypeDefinitionIndex index);
 
     // Adds the given nested types of the namespaze, parentName, and klass to the hastable
@@ -228,6 +262,32 @@ namespace il2cpp_utils {
         }
         return std::nullopt;
     }
+
+    namespace detail {
+        // A slice of the classes of an image (as indexed by il2cpp_image_get_class), or of a caller provided list when image is nullptr.
+        struct ClassSlice {
+            const Il2CppImage* image;
+            std::size_t first;
+            std::size_t count;
+        };
+
+        // Slices the classes of every assembly's image, in assembly order, followed by slices of extraCount classes of the caller's own with a null image.
+        // Slices are small enough that the largest image (the game's own assembly) is spread across every thread.
+        std::vector<ClassSlice> SliceClasses(std::size_t extraCount = 0);
+
+        // Runs work on every slice index, from threads threads (0 for one per core) including the calling thread, and returns once every slice is done.
+        // The other threads are attached to the domain, so work may create and initialize classes. Slices are claimed in order:
+        // results stored by slice index do not depend on which thread did what.
+        // Returns the number of threads used.
+        uint32_t ParallelForSlices(std::size_t sliceCount, uint32_t threads, std::function<void(std::size_t slice)> const& work);
+
+        // Changes whenever names are registered through AddTypesToNametoClassHashTable, AddTypeToNametoClassHashTable or AddNestedTypesToNametoClassHashTable.
+        uint32_t RegisteredNamesGeneration() noexcept;
+
+        // Calls visit with every name in the class hash table of every assembly's image, under the lock registrations take.
+        // Nested names are "Outer/Inner", in the namespace of the outermost class. visit must not call into il2cpp.
+        void ForEachRegisteredName(std::function<void(const char* namespaze, const char* name, TypeDefinitionIndex index)> const& visit);
+    }
 }
 
 #pragma pack(pop)
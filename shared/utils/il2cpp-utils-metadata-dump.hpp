@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+struct ModInfo;
+
+namespace il2cpp_utils {
+    /// @brief The layout of the files MetadataDump writes, shared with the host metadata query tool.
+    /// Everything is stored in native byte order, and is meant to be mapped and read in place.
+    /// A file is a DumpHeader, blockCount DumpBlock entries, then the blocks themselves, each starting on an 8 byte boundary.
+    /// A block holds a slice of the types of one image (or of the generic instances) and is self contained:
+    /// a BlockHeader, then its MethodRecord, TypeRecord, FieldRecord, PropertyRecord and ParameterRecord arrays, then its string table.
+    /// Strings are offsets into the string table of their block, and are NUL terminated. Type names are as il2cpp_type_get_name formats them.
+    /// Indices (firstMethod, getter, ...) are into the arrays of the same block.
+    namespace metadata_dump_format {
+        constexpr uint32_t magic = 0x444D4842; // "BHMD"
+        constexpr uint32_t version = 1;
+        constexpr uint32_t noIndex = 0xFFFFFFFF;
+
+        struct DumpHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t blockCount;
+            uint32_t typeCount;
+            uint32_t methodCount;
+            uint32_t fieldCount;
+        };
+
+        struct DumpBlock {
+            // From the start of the file.
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        struct BlockHeader {
+            // The image name, or "<generic instances>".
+            uint32_t image;
+            uint32_t typeCount;
+            uint32_t methodCount;
+            uint32_t fieldCount;
+            uint32_t propertyCount;
+            uint32_t parameterCount;
+            uint32_t stringsSize;
+            uint32_t reserved;
+        };
+
+        struct MethodRecord {
+            // Offset of the code from the base of libil2cpp.so, 0 for methods without code (abstract, or generic definitions).
+            uint64_t rva;
+            uint32_t name;
+            uint32_t returnType;
+            uint32_t firstParameter;
+            uint32_t parameterCount;
+            uint32_t token;
+            // METHOD_ATTRIBUTE_* flags in the low 16 bits, METHOD_IMPL_ATTRIBUTE_* flags in the high 16.
+            uint32_t flags;
+        };
+
+        struct TypeRecord {
+            uint32_t namespaze;
+            uint32_t name;
+            // Full names, as il2cpp_type_get_name formats them, or 0 (the empty string) if there is none.
+            uint32_t fullName;
+            uint32_t parent;
+            uint32_t declaringType;
+            uint32_t token;
+            // TYPE_ATTRIBUTE_* flags.
+            uint32_t flags;
+            int32_t instanceSize;
+            uint32_t firstMethod;
+            uint32_t methodCount;
+            uint32_t firstField;
+            uint32_t fieldCount;
+            uint32_t firstProperty;
+            uint32_t propertyCount;
+        };
+
+        struct FieldRecord {
+            uint32_t name;
+            uint32_t type;
+            // FIELD_ATTRIBUTE_* flags.
+            uint32_t flags;
+            // Offset into instances (or into the static fields of the class), as il2cpp_field_get_offset returns it.
+            int32_t offset;
+        };
+
+        struct PropertyRecord {
+            uint32_t name;
+            uint32_t getter;
+            uint32_t setter;
+        };
+
+        struct ParameterRecord {
+            uint32_t name;
+            uint32_t type;
+        };
+    }
+
+    /// @brief Writes the types, methods, fields and properties of every loaded image (and every generic class instance il2cpp has created)
+    /// to a compact binary file, for beatsaber-hook-metadata-query to search offline.
+    /// Images are split into blocks of at most a few thousand types, which are collected in parallel and then written in order.
+    /// Collecting sets up the methods, fields and properties of every class, as LogClasses does, but does not run any type initializers.
+    struct MetadataDump {
+        /// @brief Writes the dump to the provided path.
+        /// @param outputPath The file to write to.
+        /// @param threads The number of threads to collect blocks on, 0 for one per core.
+        /// @returns Whether the dump was written completely.
+        static bool Write(std::string_view outputPath, uint32_t threads = 0) noexcept;
+        /// @brief Writes the dump to metadata-<timestamp>.bhmd in the data directory of the provided mod.
+        /// @param info The mod whose data directory to write to.
+        /// @returns The path written to, or an empty string if the dump was not written.
+        static std::string Write(const ModInfo& info) noexcept;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "il2cpp-functions.hpp"
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace il2cpp_utils {
+    /// @brief Reads the type, method, field and string tables of global-metadata.dat in place, and indexes them by name.
+    /// Lookups go straight to metadata indices, without class_from_name, class_get_methods or Class::Init.
+    /// Classes, methods and fields are only created by il2cpp once they are resolved (GetClass, GetMethod, GetField), and only for that one class.
+    /// The metadata layout is the one of the libil2cpp headers this library is built against.
+    class MetadataReader {
+        public:
+        /// @brief Reads the metadata libil2cpp has loaded, as found by il2cpp_functions::Init.
+        /// @returns The reader, or std::nullopt if the loaded metadata could not be found or is malformed.
+        static std::optional<MetadataReader> FromRuntime() noexcept;
+        /// @brief Maps and reads a global-metadata.dat file, for offline use and host tests.
+        /// Resolving indices from it into classes requires il2cpp to have loaded the same file.
+        /// @param path The file to read.
+        /// @returns The reader, or std::nullopt if the file could not be mapped or is malformed.
+        static std::optional<MetadataReader> FromFile(std::string_view path) noexcept;
+
+        /// @brief The metadata version, from the header.
+        int32_t Version() const noexcept { return header->version; }
+        TypeDefinitionIndex TypeCount() const noexcept { return typeCount; }
+        MethodIndex MethodCount() const noexcept { return methodCount; }
+        FieldIndex FieldCount() const noexcept { return fieldCount; }
+
+        const Il2CppTypeDefinition* GetTypeDefinition(TypeDefinitionIndex index) const noexcept;
+        const Il2CppMethodDefinition* GetMethodDefinition(MethodIndex index) const noexcept;
+        const Il2CppFieldDefinition* GetFieldDefinition(FieldIndex index) const noexcept;
+        /// @brief Returns the string at the provided index of the string table, or nullptr if it is out of bounds.
+        const char* GetString(StringIndex index) const noexcept;
+
+        /// @brief Returns the type definitions nested directly in the provided one.
+        std::vector<TypeDefinitionIndex> GetNestedTypes(TypeDefinitionIndex type) const noexcept;
+
+        /// @brief Finds a type definition by namespace and name. Nested types are found as "Outer/Inner", with the namespace of the outermost type.
+        /// @returns The index of the type definition, or kTypeDefinitionIndexInvalid if there is none.
+        TypeDefinitionIndex FindType(std::string_view namespaze, std::string_view name) const noexcept;
+        /// @brief Finds the methods (every overload) of a type definition with the provided name. Inherited methods are not included.
+        /// @returns The indices of the method definitions, in definition order.
+        std::vector<MethodIndex> FindMethods(TypeDefinitionIndex type, std::string_view name) const noexcept;
+        /// @brief Finds the field of a type definition with the provided name. Inherited fields are not included.
+        /// @returns The index of the field definition, or kFieldIndexInvalid if there is none.
+        FieldIndex FindField(TypeDefinitionIndex type, std::string_view name) const noexcept;
+
+        /// @brief Returns the class of a type definition, creating it (but not initializing it) if il2cpp has not yet.
+        static Il2CppClass* GetClass(TypeDefinitionIndex type) noexcept;
+        /// @brief Returns the MethodInfo of a method definition, setting up the methods of its class (and only its class) if needed.
+        const MethodInfo* GetMethod(MethodIndex method) const noexcept;
+        /// @brief Returns the FieldInfo of a field definition of the provided type, setting up the fields of that class if needed.
+        FieldInfo* GetField(TypeDefinitionIndex type, FieldIndex field) const noexcept;
+
+        private:
+        // Entries of the name indices, sorted by key (owner and name hash) so that a lookup is an equal_range.
+        struct NameEntry {
+            uint64_t key;
+            int32_t index;
+            bool operator<(NameEntry const& other) const { return key < other.key; }
+        };
+
+        MetadataReader() = default;
+        bool Read(const void* data, std::size_t size) noexcept;
+        void BuildIndices() noexcept;
+        static uint64_t Key(uint32_t owner, std::string_view name) noexcept;
+        static uint64_t Key(std::string_view namespaze, std::string_view name) noexcept;
+        TypeDefinitionIndex FindNested(TypeDefinitionIndex outer, std::string_view name) const noexcept;
+
+        // Keeps a mapped file alive, empty when reading the runtime's metadata.
+        std::shared_ptr<const void> mapping;
+        const char* base = nullptr;
+        const Il2CppGlobalMetadataHeader* header = nullptr;
+        const char* strings = nullptr;
+        uint32_t stringsSize = 0;
+        const Il2CppTypeDefinition* types = nullptr;
+        TypeDefinitionIndex typeCount = 0;
+        const Il2CppMethodDefinition* methods = nullptr;
+        MethodIndex methodCount = 0;
+        const Il2CppFieldDefinition* fields = nullptr;
+        FieldIndex fieldCount = 0;
+        const TypeDefinitionIndex* nestedTypes = nullptr;
+        uint32_t nestedTypeCount = 0;
+
+        std::vector<NameEntry> typeIndex;
+        std::vector<NameEntry> methodIndex;
+        std::vector<NameEntry> fieldIndex;
+    };
+}
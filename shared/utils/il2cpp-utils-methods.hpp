@@ -11,6 +11,7 @@
 #include "il2cpp-type-check.hpp"
 #include "utils.h"
 #include "il2cpp-tabledefs.h"
+#include "gc-alloc.hpp"
 #include <array>
 #include <exception>
 
@@ -50,17 +51,49 @@ namespace il2cpp_utils {
 
     /// @brief Manually creates an instance of the provided Il2CppClass*.
     /// The created instance's type initializer will NOT execute on another thread! Be warned!
-    /// Must be freed using gc_free_specific!
+    /// Must be freed using gc_free_specific, or handed back via ReturnToPool!
+    /// If an instance of klass was previously returned via ReturnToPool, it is reused (zeroed and reset) instead of allocating.
     /// @param klass The Il2CppClass* to create an instance of.
     /// @return The created instance, or nullptr if it failed for any reason.
     Il2CppObject* createManual(const Il2CppClass* klass) noexcept;
+    /// @brief Same as createManual, but attributes the allocation to the provided call site for allocation accounting (see gc_alloc_specific_from).
+    /// @param klass The Il2CppClass* to create an instance of.
+    /// @param site An address within the code that requested this instance.
+    /// @return The created instance, or nullptr if it failed for any reason.
+    Il2CppObject* createManualFrom(const Il2CppClass* klass, const void* site) noexcept;
     /// @brief Manually creates an instance of the provided Il2CppClass*.
     /// The created instance's type initializer will NOT execute on another thread! Be warned!
-    /// Must be freed using gc_free_specific!
+    /// Must be freed using gc_free_specific, or handed back via ReturnToPool!
+    /// If an instance of klass was previously returned via ReturnToPool, it is reused (zeroed and reset) instead of allocating.
     /// This function will throw a exceptions::StackTraceException on failure.
     /// @param klass The Il2CppClass* to create an instance of.
     /// @return The created instance.
     Il2CppObject* createManualThrow(Il2CppClass* const klass);
+    /// @brief Same as createManualThrow, but attributes the allocation to the provided call site for allocation accounting (see gc_alloc_specific_from).
+    /// @param klass The Il2CppClass* to create an instance of.
+    /// @param site An address within the code that requested this instance.
+    /// @return The created instance.
+    Il2CppObject* createManualThrowFrom(Il2CppClass* const klass, const void* site);
+
+    /// @brief Returns a manually created instance to the free list of its class, so that a later createManual call reuses it instead of allocating.
+    /// The instance MUST have been created via createManual or createManualThrow, and MUST NOT be used after this call.
+    /// Its fields are zeroed right away, so that a parked instance keeps nothing it referenced alive.
+    /// If the pool for the instance's class is full, the instance is freed via gc_free_specific instead.
+    /// @param obj The instance to return. May be nullptr, which does nothing. An instance without a class is rejected (and not freed).
+    void ReturnToPool(Il2CppObject* obj) noexcept;
+    /// @brief Sets the hook that is invoked on a pooled instance of the provided class right before it is handed out again.
+    /// All instance fields are zeroed before the hook is called, so the hook only needs to restore non-default state.
+    /// @param klass The Il2CppClass* to set the reset hook for.
+    /// @param resetHook The function to call, or nullptr to clear it.
+    void SetPoolResetHook(const Il2CppClass* klass, void (*resetHook)(Il2CppObject*)) noexcept;
+    /// @brief Sets the maximum number of free instances kept for the provided class. Instances beyond this are freed on ReturnToPool.
+    /// Shrinking the capacity frees excess free instances immediately.
+    /// @param klass The Il2CppClass* to set the pool capacity for.
+    /// @param capacity The maximum number of free instances to hold.
+    void SetPoolCapacity(const Il2CppClass* klass, ::std::size_t capacity) noexcept;
+    /// @brief Frees all pooled instances for every class via gc_free_specific.
+    /// Reset hooks and capacities are kept.
+    void ClearPools() noexcept;
 
     ::std::vector<Il2CppClass*> ClassesFrom(::std::vector<Il2CppClass*> classes);
     ::std::vector<Il2CppClass*> ClassesFrom(::std::vector<::std::string_view> strings);
@@ -539,6 +572,27 @@ namespace il2cpp_utils {
     // Calls LogMethod on all methods in the given class
     void LogMethods(LoggerContextObject& logger, Il2CppClass* klass, bool logParents = false);
 
+    // Returns the ClassStandardName of the method's class followed by "::" and its name, for the given MethodInfo*
+    ::std::string MethodStandardName(const MethodInfo* method);
+
+    /// @brief Finds the method whose compiled code contains the provided address, for naming managed frames in backtraces.
+    /// Lookups binary search a sorted index of method pointers. It is built by the first SymbolizeManagedFrame that may block (or by RebuildMethodPointerIndex),
+    /// until then nullptr is returned: this never builds it, so it is safe anywhere.
+    /// Addresses past the end of a method (il2cpp runtime code between managed methods) are rejected using libil2cpp's .eh_frame_hdr function table, when it has one.
+    /// @param pc The address to look up.
+    /// @returns The method containing pc, or nullptr if there is none.
+    const MethodInfo* FindMethodForPC(const void* pc) noexcept;
+
+    /// @brief Builds (or rebuilds) the index FindMethodForPC uses, from the classes (and generic instances) il2cpp already created whose methods are set up.
+    /// Call it again to pick up classes created since.
+    /// @param setupAllMethods Whether to create every class and set up its methods first, so that every method with code is indexed.
+    /// This allocates a MethodInfo for every method in the game, only do it when that memory does not matter.
+    void RebuildMethodPointerIndex(bool setupAllMethods = false) noexcept;
+
+    // Writes the standard name of the method containing pc to out, returns false if there is none. Installed as backtrace_helpers' ManagedFrameSymbolizer
+    // When mayBlock, builds the method pointer index if it was not built yet. Otherwise, neither builds it nor calls into il2cpp, and names the method from its MethodInfo fields only.
+    bool SymbolizeManagedFrame(const void* pc, bool mayBlock, ::std::string& out) noexcept;
+
     template<class TOut = Il2CppObject*, bool checkTypes = true, class T, class... TArgs>
     // Runs a MethodInfo with the specified parameters and instance, with return type TOut.
     // Assumes a static method if instance == nullptr. May fail due to exception or wrong name, hence the ::std::optional.
@@ -708,8 +762,12 @@ namespace il2cpp_utils {
         if constexpr (creationType == CreationType::Temporary) {
             // object_new call
             obj = RET_NULLOPT_UNLESS(logger, il2cpp_functions::object_new(klass));
+            if (gc_accounting::IsEnabled()) {
+                gc_accounting::RecordAlloc(__builtin_return_address(0), klass->instance_size);
+            }
         } else {
-            obj = RET_NULLOPT_UNLESS(logger, createManual(klass));
+            // Attributed to the same return address as a temporary instance
+            obj = RET_NULLOPT_UNLESS(logger, createManualFrom(klass, __builtin_return_address(0)));
         }
         // runtime_invoke constructor with right type(s) of arguments, return null if constructor errors
         std::array<const Il2CppType*, sizeof...(TArgs)> types{ExtractType(args)...};
@@ -737,8 +795,12 @@ namespace il2cpp_utils {
             if (!obj) {
                 throw exceptions::StackTraceException("Failed to allocate new object via object_new!");
             }
+            if (gc_accounting::IsEnabled()) {
+                gc_accounting::RecordAlloc(__builtin_return_address(0), klass->instance_size);
+            }
         } else {
-            obj = createManualThrow(klass);
+            // Attributed to the same return address as a temporary instance
+            obj = createManualThrowFrom(klass, __builtin_return_address(0));
         }
         // Only need to extract based off of types, since we are asusming our TOut is classof-able already
         static auto ctorMethod = FindMethod(klass, ".ctor", std::array<Il2CppType const*, sizeof...(TArgs)>{ExtractIndependentType<TArgs>()...});
@@ -767,8 +829,12 @@ namespace il2cpp_utils {
         if constexpr (creationType == CreationType::Temporary) {
             // object_new call
             obj = RET_NULLOPT_UNLESS(logger, il2cpp_functions::object_new(klass));
+            if (gc_accounting::IsEnabled()) {
+                gc_accounting::RecordAlloc(__builtin_return_address(0), klass->instance_size);
+            }
         } else {
-            obj = RET_NULLOPT_UNLESS(logger, createManual(klass));
+            // Attributed to the same return address as a temporary instance
+            obj = RET_NULLOPT_UNLESS(logger, createManualFrom(klass, __builtin_return_address(0)));
         }
         // runtime_invoke constructor with right number of args, return null if constructor errors
         RET_NULLOPT_UNLESS(logger, RunMethodUnsafe(obj, ".ctor", args...));
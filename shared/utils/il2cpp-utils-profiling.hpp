@@ -0,0 +1,151 @@
+#pragma once
+
+#include "logging.hpp"
+#include "il2cpp-functions.hpp"
+#include <array>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+namespace il2cpp_utils {
+    /// @brief Enables the provided il2cpp profiler events, installing this library's Il2CppProfiler on first use.
+    /// il2cpp only applies il2cpp_profiler_set_events and the install callbacks to the most recently installed profiler,
+    /// so everything in this library shares one, and events are enabled and disabled as a set.
+    /// @param events The events to enable, in addition to the ones already enabled.
+    void EnableProfilerEvents(Il2CppProfileFlags events) noexcept;
+    /// @brief Disables the provided il2cpp profiler events. Installed callbacks remain installed, il2cpp has no way of removing them.
+    /// @param events The events to disable.
+    void DisableProfilerEvents(Il2CppProfileFlags events) noexcept;
+
+    /// @brief Returns a cheap, monotonic timestamp for profiling: the virtual counter on arm64, steady_clock nanoseconds elsewhere.
+    inline uint64_t ProfilerTimestamp() noexcept {
+        #ifdef __aarch64__
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+        #else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        #endif
+    }
+    /// @brief Returns the number of ProfilerTimestamp ticks per second.
+    inline uint64_t ProfilerTimestampFrequency() noexcept {
+        #ifdef __aarch64__
+        uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        return frequency;
+        #else
+        return 1000000000ull;
+        #endif
+    }
+
+    /// @brief Selects which methods MethodProfiler records. An empty filter records every method.
+    struct MethodProfilerFilter {
+        /// @brief Methods of these classes, and of the types nested in them (lambdas, iterators), are recorded.
+        std::vector<const Il2CppClass*> classes;
+        /// @brief Methods of every class in these images are recorded.
+        std::vector<const Il2CppImage*> images;
+        /// @brief Adds the class with the provided namespace and name, logging an error if it does not exist.
+        /// @returns This filter.
+        MethodProfilerFilter& AddClass(std::string_view nameSpace, std::string_view className);
+        /// @brief Adds the assembly with the provided name (for example "Main", without ".dll"), logging an error if it does not exist.
+        /// @returns This filter.
+        MethodProfilerFilter& AddAssembly(std::string_view assemblyName);
+    };
+
+    /// @brief Times and counts calls to one method, for the current MethodProfiler session.
+    struct MethodProfile {
+        const MethodInfo* method;
+        /// @brief Number of calls that returned.
+        uint64_t calls;
+        /// @brief Time spent in the method, including calls to other recorded methods. Recursive calls are counted once.
+        uint64_t inclusiveNs;
+        /// @brief Time spent in the method, excluding calls to other recorded methods.
+        uint64_t exclusiveNs;
+    };
+
+    /// @brief Records managed method enter and leave events through il2cpp_profiler_install_enter_leave,
+    /// and aggregates them into per method call counts and inclusive and exclusive times.
+    /// Events go into a lock-free buffer per thread, which a background thread drains.
+    /// il2cpp only raises enter/leave for code it was built to raise them in (runtime_invoke, and generated code built with profiler support),
+    /// so on a retail build most of what this sees is invoked through il2cpp_utils::RunMethod and the like.
+    struct MethodProfiler {
+        /// @brief Starts (or restarts, clearing previous results) recording the methods selected by filter. Safe to call from any thread.
+        /// @param filter The methods to record. A callback may still be reading the previous filter, so every filter started with is kept alive for the life of the process.
+        /// @param bufferEvents Events each thread can buffer before the aggregator drains them. Events past that are dropped.
+        /// Changing it makes every thread replace its buffer on its next event.
+        /// @returns Whether recording started, false if the profiler API is missing.
+        static bool Start(MethodProfilerFilter filter = {}, uint32_t bufferEvents = 16384) noexcept;
+        /// @brief Stops recording, keeping the results for Collect and Log.
+        static void Stop() noexcept;
+        /// @brief Returns whether the profiler is recording.
+        static bool IsRunning() noexcept;
+        /// @brief Returns the results so far, sorted by descending exclusive time.
+        static std::vector<MethodProfile> Collect() noexcept;
+        /// @brief Returns the number of events dropped because a thread's buffer was full.
+        static uint64_t DroppedEvents() noexcept;
+        /// @brief Logs the methods with the most exclusive time.
+        /// @param logger The logger to log to.
+        /// @param count The maximum number of methods to log.
+        static void Log(LoggerContextObject& logger, std::size_t count = 50) noexcept;
+    };
+
+    /// @brief Allocations of one class, for the current GcTelemetry session.
+    struct AllocationStats {
+        Il2CppClass* klass;
+        uint64_t count;
+        uint64_t bytes;
+    };
+
+    /// @brief One garbage collection, as seen by GcTelemetry.
+    struct GcEvent {
+        /// @brief When the collection started, relative to GcTelemetry::Start.
+        uint64_t startNs;
+        /// @brief Time from the start to the end of the collection.
+        uint64_t durationNs;
+        /// @brief Time the world was stopped for, or 0 if the GC did not report stopping the world.
+        uint64_t pauseNs;
+        /// @brief The generation collected.
+        int generation;
+        /// @brief Heap size after the collection, as last reported by the heap resize callback (0 if it never was).
+        int64_t heapSize;
+        /// @brief Bytes allocated between the previous collection and this one.
+        uint64_t allocatedBytes;
+    };
+
+    /// @brief GC pause counts in power of two buckets: bucket 0 holds pauses under 1us, bucket i pauses in [2^(i-1), 2^i) us.
+    struct GcPauseHistogram {
+        static constexpr std::size_t bucketCount = 24;
+        std::array<uint64_t, bucketCount> counts;
+        /// @brief The exclusive upper bound of the provided bucket, in microseconds.
+        static constexpr uint64_t UpperBoundUs(std::size_t bucket) {
+            return uint64_t(1) << bucket;
+        }
+    };
+
+    /// @brief Counts allocations (and their bytes) per class through il2cpp_profiler_install_allocation,
+    /// and times garbage collections through il2cpp_profiler_install_gc, into a pause histogram and a timeline of recent collections.
+    /// Allocation counters are sharded by thread, GC events are recorded without locks or allocations, since the world is stopped.
+    struct GcTelemetry {
+        /// @brief Starts (or restarts, clearing previous results) recording allocations and collections. Safe to call from any thread.
+        /// A GC may still be writing to the previous timeline, so every restart keeps the previous one (timelineSize events) alive for the life of the process.
+        /// @param timelineSize How many of the most recent collections the timeline keeps.
+        /// @returns Whether recording started, false if the profiler API is missing.
+        static bool Start(uint32_t timelineSize = 1024) noexcept;
+        /// @brief Stops recording, keeping the results.
+        static void Stop() noexcept;
+        /// @brief Returns whether allocations and collections are being recorded.
+        static bool IsRunning() noexcept;
+        /// @brief Returns the classes with the most allocated bytes (or allocations), in descending order.
+        /// @param count The maximum number of classes to return.
+        /// @param byBytes Whether to rank by bytes, rather than allocation count.
+        static std::vector<AllocationStats> TopAllocators(std::size_t count = 50, bool byBytes = true) noexcept;
+        /// @brief Returns the most recent collections, oldest first.
+        static std::vector<GcEvent> Timeline() noexcept;
+        /// @brief Returns the histogram of GC pauses (or of collection durations, for collections that did not report stopping the world).
+        static GcPauseHistogram PauseHistogram() noexcept;
+        /// @brief Logs the top allocators, the pause histogram and the most recent collections.
+        /// @param logger The logger to log to.
+        /// @param count The maximum number of allocators and collections to log.
+        static void Log(LoggerContextObject& logger, std::size_t count = 20) noexcept;
+    };
+}
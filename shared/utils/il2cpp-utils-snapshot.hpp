@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+struct ModInfo;
+
+namespace il2cpp_utils {
+    /// @brief The layout of the files MemorySnapshot writes, shared with the host snapshot analyzer.
+    /// Everything is stored in native byte order. A file is a SnapshotHeader followed by records, each a one byte SnapshotRecord tag and its payload:
+    /// Type: uint32 index, uint32 flags, uint32 baseOrElementTypeIndex, uint32 size, uint64 typeInfoAddress, string name, string assembly,
+    ///     uint32 fieldCount, fieldCount * (uint32 offset, uint32 typeIndex, uint8 isStatic, string name), uint32 staticsSize, staticsSize bytes
+    /// HeapSection, StackSection: uint64 startAddress, uint32 size, size bytes
+    /// GcHandles: uint32 count, count * uint64 object address
+    /// FixedAllocation: uint64 address, uint64 size, string owner ("library!symbol", or "library+0xoffset")
+    /// End: nothing, it is always the last record of a complete file.
+    /// Strings are a uint32 length followed by that many bytes, without a terminator.
+    namespace snapshot_format {
+        constexpr uint32_t magic = 0x534D4842; // "BHMS"
+        constexpr uint32_t version = 1;
+
+        struct SnapshotHeader {
+            uint32_t magic;
+            uint32_t version;
+            // Il2CppRuntimeInformation, as captured.
+            uint32_t pointerSize;
+            uint32_t objectHeaderSize;
+            uint32_t arrayHeaderSize;
+            uint32_t arrayBoundsOffsetInHeader;
+            uint32_t arraySizeOffsetInHeader;
+            uint32_t allocationGranularity;
+        };
+
+        enum SnapshotRecord : uint8_t {
+            End = 0,
+            Type = 1,
+            HeapSection = 2,
+            StackSection = 3,
+            GcHandles = 4,
+            FixedAllocation = 5,
+        };
+
+        // Il2CppMetadataTypeFlags
+        constexpr uint32_t typeValueType = 1 << 0;
+        constexpr uint32_t typeArray = 1 << 1;
+        constexpr uint32_t typeArrayRankShift = 16;
+        constexpr uint32_t noType = 0xFFFFFFFF;
+    }
+
+    /// @brief Captures the managed heap through il2cpp_capture_memory_snapshot and streams it to a binary file on a background thread,
+    /// for beatsaber-hook-snapshot-analyzer to turn into type histograms and root paths offline.
+    /// Capturing stops the world while il2cpp copies the heap, writing happens after the world restarts, and the copy is freed as soon as it is written.
+    /// Fixed allocations (gc_alloc_specific, and the handles of every SafePtr) made while gc_accounting is enabled are written as roots named after their owner,
+    /// so objects that are only alive because a mod still holds a SafePtr to them can be found. Enable gc_accounting before creating the SafePtrs of interest.
+    struct MemorySnapshot {
+        /// @brief Captures the managed heap and starts writing it to the provided path.
+        /// Waits for a previous snapshot to finish writing first, so that only one copy of the heap exists at a time.
+        /// @param outputPath The file to write the snapshot to.
+        /// @returns Whether the heap was captured, false if il2cpp_capture_memory_snapshot is unavailable or the file could not be opened.
+        static bool Capture(std::string_view outputPath) noexcept;
+        /// @brief Captures the managed heap and starts writing it to snapshot-<timestamp>.bhms in the data directory of the provided mod.
+        /// @param info The mod whose data directory to write to.
+        /// @returns The path being written to, or an empty string if the heap was not captured.
+        static std::string Capture(const ModInfo& info) noexcept;
+        /// @brief Returns whether a snapshot is still being written.
+        static bool IsWriting() noexcept;
+        /// @brief Waits for the snapshot being written (if any) to finish. This also happens on normal process exit.
+        /// @returns Whether the last snapshot was written completely.
+        static bool Wait() noexcept;
+    };
+}
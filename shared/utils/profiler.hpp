@@ -0,0 +1,67 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <string_view>
+
+struct ModInfo;
+
+/// @brief Options for SamplingProfiler::Start.
+struct SamplingProfilerOptions {
+    /// @brief Samples per second of process CPU time. A prime avoids sampling in lockstep with frame timers.
+    uint32_t frequency = 997;
+    /// @brief Maximum number of frames captured per sample, deeper stacks are truncated at the root.
+    uint16_t maxDepth = 64;
+    /// @brief Number of samples the ring holds before the aggregation thread drains it. Rounded up to a power of two.
+    /// Samples taken while the ring is full are dropped and counted.
+    uint32_t ringSize = 4096;
+    /// @brief Frame records further than this above the interrupted stack pointer end the walk, even within a registered thread's stack.
+    uint32_t maxStackBytes = 1024 * 1024;
+    /// @brief Whether to add the sampled thread's name as the root frame of every stack.
+    bool threadNames = true;
+};
+
+/// @brief Counters for the current (or last) profiling session.
+struct SamplingProfilerStats {
+    /// @brief Samples recorded in the ring.
+    uint64_t samples;
+    /// @brief Samples dropped because the ring was full.
+    uint64_t dropped;
+    /// @brief Distinct stacks aggregated so far.
+    uint64_t stacks;
+};
+
+/// @brief An in-process sampling profiler for native code, for when simpleperf is not available.
+/// A process CPU time timer (timer_create) raises SIGPROF, whose handler walks the interrupted thread's frame pointer chain into a lock-free ring.
+/// A background thread drains the ring and aggregates the stacks, which are symbolized with dladdr (as Logger::Backtrace does)
+/// and written as folded stacks ("thread;outer;...;inner count" lines), ready for flamegraph.pl or speedscope.
+/// Frames are named "library!symbol", or "library+0xoffset" when there is no symbol, so time can be attributed to each mod.
+/// Stacks can only be walked through code built with frame pointers, which is the default on arm64 Android.
+/// Only threads registered with RegisterThread are walked across their whole stack: on other threads,
+/// frame records past the page holding the interrupted stack pointer are not read, as they may not be mapped.
+struct SamplingProfiler {
+    /// @brief Starts profiling, writing folded stacks to the provided path when stopped.
+    /// Installs a SIGPROF handler, replacing (and restoring on Stop) any existing one.
+    /// @param outputPath The file to write the folded stacks to.
+    /// @param options The options to profile with.
+    /// @returns Whether profiling was started, false if it is already running or the timer could not be created or armed.
+    static bool Start(std::string_view outputPath, SamplingProfilerOptions options = {}) noexcept;
+    /// @brief Starts profiling, writing folded stacks to profile-<timestamp>.folded in the data directory of the provided mod.
+    /// @param info The mod whose data directory to write to.
+    /// @param options The options to profile with.
+    /// @returns Whether profiling was started.
+    static bool Start(const ModInfo& info, SamplingProfilerOptions options = {}) noexcept;
+    /// @brief Records the calling thread's stack bounds, so that samples of it walk its whole stack. Start registers the thread calling it.
+    /// Registrations outlive profiling sessions, register a thread once, when it starts.
+    /// @returns Whether the thread was registered, false if its stack could not be found or too many threads are registered.
+    static bool RegisterThread() noexcept;
+    /// @brief Stops profiling, aggregates whatever remains in the ring, and writes the folded stacks.
+    /// @returns The path written to, or an empty string if the profiler was not running or the file could not be written.
+    static std::string Stop() noexcept;
+    /// @brief Writes the folded stacks collected so far, without stopping.
+    /// @returns Whether the file was written.
+    static bool Flush() noexcept;
+    /// @brief Returns whether the profiler is running.
+    static bool IsRunning() noexcept;
+    /// @brief Returns the counters of the current (or last) session.
+    static SamplingProfilerStats GetStats() noexcept;
+};
@@ -11,7 +11,9 @@
 #include <concepts>
 #include <type_traits>
 #include <memory>
+#include <initializer_list>
 #include "il2cpp-utils-exceptions.hpp"
+#include "gc-alloc.hpp"
 
 #if __has_feature(cxx_exceptions)
 struct CreatedTooEarlyException : il2cpp_utils::exceptions::StackTraceException {
@@ -265,7 +267,7 @@ struct SafePtr {
             if (!il2cpp_functions::hasGCFuncs) {
                 SAFE_ABORT_MSG("Cannot use SafePtr without GC functions!");
             }
-            il2cpp_functions::GC_free(internalHandle.__internal_get());
+            gc_free_specific(internalHandle.__internal_get());
         }
     }
 
@@ -422,9 +424,9 @@ private:
                 SAFE_ABORT_MSG("Cannot use a SafePtr this early/without GC functions!");
 #endif
             }
-            // It should be safe to assume that GC_AllocateFixed returns a non-null pointer. If it does return null, we have a pretty big issue.
-            auto* wrapper = reinterpret_cast<SafePointerWrapper*>(il2cpp_functions::GarbageCollector_AllocateFixed(sizeof(SafePointerWrapper), nullptr));
-            CRASH_UNLESS(wrapper);
+            // gc_alloc_specific_from crashes if GC_AllocateFixed returns null. The site is this function, so gc_accounting (and memory snapshots)
+            // attribute the wrapper to the mod and the wrapped type that created it.
+            auto* wrapper = reinterpret_cast<SafePointerWrapper*>(gc_alloc_specific_from(sizeof(SafePointerWrapper), reinterpret_cast<const void*>(&SafePointerWrapper::New)));
             wrapper->instancePointer = instance;
             return wrapper;
         }
@@ -550,6 +552,57 @@ struct WeakPtr {
 
 };
 
+/// @brief Keeps a group of C# objects alive from native code using a single GC handle.
+/// All held objects are stored in one C# object[], which is the only thing rooted by the handle.
+/// This means adding N objects takes the runtime's GC handle lock at most a handful of times (on growth), instead of N times,
+/// and releasing the whole group is a single gchandle_free.
+/// This type is NOT thread safe, synchronize access to a single group yourself.
+/// This instance must be created at a time such that il2cpp_functions::Init is valid.
+struct GCHandleGroup {
+    /// @brief Constructs an empty group. No C# allocation happens until the first add or reserve.
+    GCHandleGroup() noexcept = default;
+    /// @brief Constructs an empty group with room for the provided number of objects.
+    explicit GCHandleGroup(std::size_t capacity);
+    /// @brief Constructs a group that holds all of the provided objects.
+    GCHandleGroup(std::initializer_list<Il2CppObject*> objects);
+    GCHandleGroup(const GCHandleGroup&) = delete;
+    GCHandleGroup& operator=(const GCHandleGroup&) = delete;
+    GCHandleGroup(GCHandleGroup&& other) noexcept;
+    GCHandleGroup& operator=(GCHandleGroup&& other) noexcept;
+    /// @brief Destructor, releases the group.
+    ~GCHandleGroup();
+
+    /// @brief Adds an object to the group, keeping it alive until this group is released.
+    /// @param obj The object to add. May be nullptr.
+    /// @return The index of the added object, for use with get and set.
+    std::size_t add(Il2CppObject* obj);
+    /// @brief Adds all of the provided objects to the group, growing the root at most once.
+    /// @param objects The pointer to the first object to add.
+    /// @param count The number of objects to add.
+    /// @return The index of the first added object.
+    std::size_t add(Il2CppObject* const* objects, std::size_t count);
+    /// @brief Gets the object at the provided index. Performs no bounds checking.
+    Il2CppObject* get(std::size_t idx) const noexcept;
+    /// @brief Replaces the object at the provided index, releasing the old one. Performs no bounds checking.
+    void set(std::size_t idx, Il2CppObject* obj) noexcept;
+    /// @brief Ensures the group can hold the provided number of objects without growing again.
+    void reserve(std::size_t capacity);
+    /// @brief Releases every held object with a single gchandle_free. The group may be reused afterwards.
+    void release() noexcept;
+
+    /// @brief The number of objects held in this group.
+    std::size_t size() const noexcept {
+        return count;
+    }
+    /// @brief The number of objects this group can hold before it must grow.
+    std::size_t capacity() const noexcept;
+
+private:
+    Il2CppArray* root = nullptr;
+    uint32_t handle = 0;
+    std::size_t count = 0;
+};
+
 template<template<typename> typename Container, typename Item>
 concept is_valid_container = requires (Container<Item> coll, Item item) {
     coll.erase(item);
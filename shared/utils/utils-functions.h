@@ -48,6 +48,8 @@ std::string readfile(std::string_view filename);
 std::vector<char> readbytes(std::string_view filename);
 // Writes all of the text to a file at the given filename. Returns true on success, false otherwise
 bool writefile(std::string_view filename, std::string_view text);
+// Same as writefile, but fsyncs the file before returning, so the text is on disk once this returns true
+bool writefileSync(std::string_view filename, std::string_view text);
 // Deletes a file at the given filename. Returns true on success, false otherwise
 bool deletefile(std::string_view filename);
 // Returns if a file exists and can be written to / read from
@@ -70,6 +72,23 @@ namespace backtrace_helpers {
     };
     _Unwind_Reason_Code unwindCallback(struct _Unwind_Context *context, void *arg);
     size_t captureBacktrace(void **buffer, uint16_t max, uint16_t skip = 0);
+    struct FrameSymbol {
+        // Path of the library containing the address
+        const char* library;
+        // Demangled name of the closest symbol, or the managed method containing the address, empty if there is neither
+        std::string symbol;
+        // Offset of the address from the base of the library
+        uintptr_t offset;
+    };
+    // Describes an address from a captured backtrace using dladdr, returns false if it is not in any loaded library
+    bool symbolizeFrame(const void* pc, FrameSymbol& out);
+    // Names an address on one line: "library!symbol", or "library+0xoffset" without a symbol (library being the file name only), or "0xaddress" outside of any library
+    std::string describeFrame(const void* pc);
+    // Names an address without an ELF symbol (such as managed code in libil2cpp) into out, returns false if it can not.
+    // mayBlock is false while aborting, where nothing that could wait on a lock held by the aborting thread should run.
+    using ManagedFrameSymbolizer = bool (*)(const void* pc, bool mayBlock, std::string& out);
+    // Sets the symbolizer symbolizeFrame falls back to, il2cpp_functions::Init installs il2cpp_utils::SymbolizeManagedFrame
+    void setManagedFrameSymbolizer(ManagedFrameSymbolizer symbolizer);
 }
 
 #endif /* UTILS_FUNCTIONS_H */
@@ -11,6 +11,24 @@
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
 #include "modloader/shared/modloader.hpp"
 
 // CONFIG
@@ -29,6 +47,43 @@ bool Configuration::ensureObject() {
     return true;
 }
 
+// State of a Configuration kept outside of the class, so that its layout stays the same for mods built against older headers.
+struct ConfigState {
+    bool useSnapshot = false;
+    // Set while watched for changes.
+    std::function<void(Configuration&)> reloadCallback;
+    // The document parsed by the watcher, until ApplyPendingReload swaps it in.
+    std::unique_ptr<ConfigDocument> pendingReload;
+};
+
+static std::mutex configStateLock;
+static std::unordered_map<const Configuration*, ConfigState> configStates;
+// How many configs have a pending reload, so that ApplyPendingReload does not need the lock while there are none.
+static std::atomic<std::size_t> pendingReloadCount = 0;
+
+static bool usesSnapshot(const Configuration* config) {
+    std::scoped_lock lock(configStateLock);
+    auto itr = configStates.find(config);
+    return itr != configStates.end() && itr->second.useSnapshot;
+}
+
+void Configuration::UseSnapshot(bool use) {
+    std::scoped_lock lock(configStateLock);
+    configStates[this].useSnapshot = use;
+}
+
+// A copy only keeps the settings: it is not watched, and does not see reloads for the original.
+void Configuration::copyState(const Configuration& other) {
+    std::scoped_lock lock(configStateLock);
+    auto itr = configStates.find(&other);
+    if (itr != configStates.end()) {
+        configStates[this].useSnapshot = itr->second.useSnapshot;
+    }
+}
+
+static std::string encodeSnapshot(ConfigValue const& value);
+static void queueSnapshot(std::string const& path, std::string snapshot);
+
 // Loads the config for the given mod, if it doesn't exist, will leave it as an empty object.
 void Configuration::Load() {
     if (readJson) {
@@ -38,46 +93,698 @@ void Configuration::Load() {
     if (!fileexists(filePath)) {
         writefile(filePath, "{}");
     }
+    bool snapshot = usesSnapshot(this);
+    if (snapshot && loadSnapshot()) {
+        readJson = true;
+        ensureObject();
+        return;
+    }
     Configuration::Reload();
+    if (snapshot && readJson) {
+        // Written by the writer thread, so loading never waits on the disk for it.
+        queueSnapshot(filePath, encodeSnapshot(config));
+    }
 }
 
 void Configuration::Reload() {
+    // Make sure we do not read back a config that is about to be overwritten by a pending write.
+    FlushWrites();
     readJson = parsejsonfile(config, filePath);
     ensureObject();
 }
 
-void Configuration::Write() {
-    ensureObject();
+// How long the writer waits after a Write for further writes to coalesce with.
+static constexpr auto writeDebounce = std::chrono::milliseconds(250);
+
+// Guards the queue below. Never held while touching the disk, so Write does not wait on the writer.
+static std::mutex writeLock;
+// Held while writing config files, so that a WriteSync and the writer thread never write at the same time.
+static std::mutex diskLock;
+static std::condition_variable writeCv;
+static std::condition_variable flushCv;
+struct PendingWrite {
+    // The JSON text to write, or nullopt to only rebuild the snapshot of the file as it is.
+    std::optional<std::string> text;
+    // The encoded root value for the snapshot, empty if the config does not use one.
+    std::string snapshot;
+};
+
+// Latest contents per config path that have not been written yet.
+static std::unordered_map<std::string, PendingWrite> pendingWrites;
+static std::chrono::steady_clock::time_point lastWriteRequest;
+static std::size_t writesInFlight = 0;
+static bool writerStarted = false;
+
+// FNV-1a, only used to tell whether JSON text changed.
+static uint64_t hashBytes(const char* data, std::size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
 
+// Hash of the last text this process wrote per config path, so the watcher can ignore our own writes.
+static std::mutex writeHashLock;
+static std::unordered_map<std::string, uint64_t> lastWrittenHash;
+
+// Writes to a temporary file next to the target, then renames it over the target.
+// This way a crash mid-write leaves either the old or the new config, never a truncated one.
+// Without sync the data may not have reached the disk when the rename does, which is only acceptable for files that are validated on read.
+static bool writeFileAtomic(std::string const& path, std::string_view data, bool sync = true) {
+    static auto logger = Logger::get().WithContext("Configuration");
+    auto tmpPath = path + ".tmp";
+    if (!(sync ? writefileSync(tmpPath, data) : writefile(tmpPath, data))) {
+        logger.error("Failed to write temporary config file: %s, errno: %i", tmpPath.c_str(), errno);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        logger.error("Failed to rename temporary config file: %s to: %s, errno: %i", tmpPath.c_str(), path.c_str(), errno);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void writeSnapshot(std::string const& path, std::string_view text, std::string_view snapshot);
+
+// Writes the JSON text (if any) of a pending write, then its snapshot. Called with diskLock held.
+static void writePending(std::string const& path, PendingWrite const& write) {
+    if (write.text) {
+        if (!writeFileAtomic(path, *write.text)) {
+            return;
+        }
+        std::scoped_lock hashLock(writeHashLock);
+        lastWrittenHash.insert_or_assign(path, hashBytes(write.text->data(), write.text->size()));
+    }
+    if (write.snapshot.empty()) {
+        return;
+    }
+    if (write.text) {
+        writeSnapshot(path, *write.text, write.snapshot);
+    } else {
+        writeSnapshot(path, readfile(path), write.snapshot);
+    }
+}
+
+static void configWriter() {
+    std::unique_lock lock(writeLock);
+    while (true) {
+        writeCv.wait(lock, [] { return !pendingWrites.empty(); });
+        // Wait for writes to settle (ex: a slider being dragged) before touching the disk.
+        while (std::chrono::steady_clock::now() - lastWriteRequest < writeDebounce) {
+            writeCv.wait_until(lock, lastWriteRequest + writeDebounce);
+        }
+        auto toWrite = std::move(pendingWrites);
+        pendingWrites.clear();
+        writesInFlight = toWrite.size();
+        lock.unlock();
+        {
+            std::scoped_lock disk(diskLock);
+            for (auto const& [path, write] : toWrite) {
+                writePending(path, write);
+            }
+        }
+        lock.lock();
+        writesInFlight = 0;
+        flushCv.notify_all();
+    }
+}
+
+// Queues a write for the writer thread. A write that only rebuilds a snapshot never replaces a pending write of the JSON text.
+static void queueWrite(std::string const& path, PendingWrite write) {
+    {
+        std::scoped_lock lock(writeLock);
+        if (write.text) {
+            pendingWrites.insert_or_assign(path, std::move(write));
+        } else {
+            pendingWrites.try_emplace(path, std::move(write));
+        }
+        lastWriteRequest = std::chrono::steady_clock::now();
+        if (!writerStarted) {
+            writerStarted = true;
+            std::thread(configWriter).detach();
+            // Writes still waiting out the debounce would otherwise be lost when the process exits normally.
+            atexit(&Configuration::FlushWrites);
+        }
+    }
+    writeCv.notify_one();
+}
+
+static void queueSnapshot(std::string const& path, std::string snapshot) {
+    queueWrite(path, {std::nullopt, std::move(snapshot)});
+}
+
+// Serializes the config, and encodes its snapshot if it uses one, so that both are written from the same state.
+static PendingWrite serializeConfig(Configuration const& config, bool snapshot) {
     StringBuffer buf;
     PrettyWriter<StringBuffer> writer(buf);
-    config.Accept(writer);
-    writefile(filePath, buf.GetString());
+    config.config.Accept(writer);
+    return {std::string(buf.GetString(), buf.GetSize()), snapshot ? encodeSnapshot(config.config) : std::string()};
 }
 
-bool parsejsonfile(ConfigDocument& doc, std::string_view filename) {
-    if (!fileexists(filename.data())) {
+void Configuration::Write() {
+    ensureObject();
+    queueWrite(filePath, serializeConfig(*this, usesSnapshot(this)));
+}
+
+void Configuration::WriteSync() {
+    ensureObject();
+
+    auto write = serializeConfig(*this, usesSnapshot(this));
+    std::unique_lock lock(writeLock);
+    pendingWrites.erase(filePath);
+    // An in flight write for this path could otherwise land after ours.
+    flushCv.wait(lock, [] { return writesInFlight == 0; });
+    // Taken before letting go of the queue, so the writer can not start an older write of this path in between.
+    std::scoped_lock disk(diskLock);
+    lock.unlock();
+    writePending(filePath, write);
+}
+
+void Configuration::FlushWrites() {
+    std::unique_lock lock(writeLock);
+    if (!pendingWrites.empty()) {
+        // Skip the debounce, the caller wants it on disk now.
+        lastWriteRequest = {};
+        writeCv.notify_one();
+    }
+    flushCv.wait(lock, [] { return pendingWrites.empty() && writesInFlight == 0; });
+}
+
+// Binary config snapshots.
+// Layout: SnapshotHeader, followed by a single encoded value (the root object).
+// Every value is a one byte SnapshotTag, followed by its payload:
+// numbers are 8 bytes, strings are a uint32 length followed by the bytes,
+// arrays are a uint32 count followed by the values, objects are a uint32 count followed by (string name, value) pairs.
+// Everything is stored in native byte order, snapshots are never shared between devices.
+static constexpr uint32_t snapshotMagic = 0x53434842; // "BHCS"
+static constexpr uint32_t snapshotVersion = 1;
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    int64_t jsonMtimeNs;
+    uint64_t jsonSize;
+    uint64_t jsonHash;
+};
+
+enum SnapshotTag : uint8_t {
+    SNAPSHOT_NULL,
+    SNAPSHOT_FALSE,
+    SNAPSHOT_TRUE,
+    SNAPSHOT_INT64,
+    SNAPSHOT_UINT64,
+    SNAPSHOT_DOUBLE,
+    SNAPSHOT_STRING,
+    SNAPSHOT_ARRAY,
+    SNAPSHOT_OBJECT
+};
+
+static std::string snapshotPath(std::string const& jsonPath) {
+    return jsonPath + ".snapshot";
+}
+
+static int64_t mtimeNs(struct stat const& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+template<class T>
+static void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void appendString(std::string& out, const char* str, uint32_t length) {
+    appendRaw(out, length);
+    out.append(str, length);
+}
+
+static void encodeSnapshotValue(std::string& out, ConfigValue const& value) {
+    switch (value.GetType()) {
+        case kNullType:
+            appendRaw(out, SNAPSHOT_NULL);
+            break;
+        case kFalseType:
+            appendRaw(out, SNAPSHOT_FALSE);
+            break;
+        case kTrueType:
+            appendRaw(out, SNAPSHOT_TRUE);
+            break;
+        case kNumberType:
+            if (value.IsDouble()) {
+                appendRaw(out, SNAPSHOT_DOUBLE);
+                appendRaw(out, value.GetDouble());
+            } else if (value.IsInt64()) {
+                appendRaw(out, SNAPSHOT_INT64);
+                appendRaw(out, value.GetInt64());
+            } else {
+                appendRaw(out, SNAPSHOT_UINT64);
+                appendRaw(out, value.GetUint64());
+            }
+            break;
+        case kStringType:
+            appendRaw(out, SNAPSHOT_STRING);
+            appendString(out, value.GetString(), value.GetStringLength());
+            break;
+        case kArrayType:
+            appendRaw(out, SNAPSHOT_ARRAY);
+            appendRaw(out, static_cast<uint32_t>(value.Size()));
+            for (auto const& elem : value.GetArray()) {
+                encodeSnapshotValue(out, elem);
+            }
+            break;
+        case kObjectType:
+            appendRaw(out, SNAPSHOT_OBJECT);
+            appendRaw(out, static_cast<uint32_t>(value.MemberCount()));
+            for (auto const& member : value.GetObject()) {
+                appendString(out, member.name.GetString(), member.name.GetStringLength());
+                encodeSnapshotValue(out, member.value);
+            }
+            break;
+    }
+}
+
+struct SnapshotReader {
+    const char* cur;
+    const char* end;
+
+    template<class T>
+    bool read(T& out) {
+        if (static_cast<std::size_t>(end - cur) < sizeof(T)) {
+            return false;
+        }
+        memcpy(&out, cur, sizeof(T));
+        cur += sizeof(T);
+        return true;
+    }
+
+    bool readString(const char*& str, uint32_t& length) {
+        if (!read(length) || static_cast<std::size_t>(end - cur) < length) {
+            return false;
+        }
+        str = cur;
+        cur += length;
+        return true;
+    }
+
+    bool decode(ConfigValue& value, ConfigDocument::AllocatorType& allocator, int depth = 0) {
+        // Guard against corrupted snapshots recursing forever.
+        if (depth > 256) {
+            return false;
+        }
+        uint8_t tag;
+        if (!read(tag)) {
+            return false;
+        }
+        switch (tag) {
+            case SNAPSHOT_NULL:
+                value.SetNull();
+                return true;
+            case SNAPSHOT_FALSE:
+                value.SetBool(false);
+                return true;
+            case SNAPSHOT_TRUE:
+                value.SetBool(true);
+                return true;
+            case SNAPSHOT_INT64: {
+                int64_t v;
+                if (!read(v)) return false;
+                value.SetInt64(v);
+                return true;
+            }
+            case SNAPSHOT_UINT64: {
+                uint64_t v;
+                if (!read(v)) return false;
+                value.SetUint64(v);
+                return true;
+            }
+            case SNAPSHOT_DOUBLE: {
+                double v;
+                if (!read(v)) return false;
+                value.SetDouble(v);
+                return true;
+            }
+            case SNAPSHOT_STRING: {
+                const char* str;
+                uint32_t length;
+                if (!readString(str, length)) return false;
+                value.SetString(str, length, allocator);
+                return true;
+            }
+            case SNAPSHOT_ARRAY: {
+                uint32_t count;
+                if (!read(count)) return false;
+                value.SetArray();
+                // Every element takes at least its tag byte, so this bounds the reservation for corrupted counts.
+                value.Reserve(std::min<std::size_t>(count, end - cur), allocator);
+                for (uint32_t i = 0; i < count; i++) {
+                    ConfigValue elem;
+                    if (!decode(elem, allocator, depth + 1)) return false;
+                    value.PushBack(elem, allocator);
+                }
+                return true;
+            }
+            case SNAPSHOT_OBJECT: {
+                uint32_t count;
+                if (!read(count)) return false;
+                value.SetObject();
+                for (uint32_t i = 0; i < count; i++) {
+                    const char* name;
+                    uint32_t length;
+                    if (!readString(name, length)) return false;
+                    ConfigValue member;
+                    if (!decode(member, allocator, depth + 1)) return false;
+                    value.AddMember(ConfigValue(name, length, allocator), member, allocator);
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+};
+
+bool Configuration::loadSnapshot() {
+    struct stat jsonStat;
+    if (stat(filePath.c_str(), &jsonStat) != 0) {
+        return false;
+    }
+    auto path = snapshotPath(filePath);
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+    auto* data = static_cast<const char*>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if (data == MAP_FAILED) {
         return false;
     }
-    std::ifstream is;
-    is.open(filename.data());
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+    bool current = header.magic == snapshotMagic && header.version == snapshotVersion && header.jsonSize == static_cast<uint64_t>(jsonStat.st_size);
+    if (current && header.jsonMtimeNs != mtimeNs(jsonStat)) {
+        // The file was touched, but may hold the same text (ex: rewritten with the same values).
+        auto text = readfile(filePath);
+        current = hashBytes(text.data(), text.size()) == header.jsonHash;
+    }
+    bool loaded = false;
+    if (current) {
+        // Decoded into config's own allocator, which references to it may be held across loads.
+        ConfigValue value;
+        SnapshotReader reader{data + sizeof(SnapshotHeader), data + size};
+        if (reader.decode(value, config.GetAllocator()) && reader.cur == reader.end) {
+            static_cast<ConfigValue&>(config) = value;
+            loaded = true;
+        }
+    }
+    munmap(const_cast<char*>(data), size);
+    return loaded;
+}
 
-    IStreamWrapper wrapper {is};
-    
-    return !doc.ParseStream(wrapper).HasParseError();
+static std::string encodeSnapshot(ConfigValue const& value) {
+    std::string out;
+    encodeSnapshotValue(out, value);
+    return out;
 }
 
+// Writes the snapshot of the JSON file at path, which must hold text. Only called from the writer thread, or by WriteSync, with diskLock held.
+// A snapshot is checked against the JSON file and fully decoded before it is used, so it is not synced: losing it only costs one parse.
+static void writeSnapshot(std::string const& path, std::string_view text, std::string_view snapshot) {
+    static auto logger = Logger::get().WithContext("Configuration");
+    struct stat jsonStat;
+    if (stat(path.c_str(), &jsonStat) != 0 || static_cast<std::size_t>(jsonStat.st_size) != text.size()) {
+        // Changed under us, the next Load will rebuild it.
+        return;
+    }
+    std::string out;
+    out.reserve(sizeof(SnapshotHeader) + snapshot.size());
+    SnapshotHeader header{snapshotMagic, snapshotVersion, mtimeNs(jsonStat), static_cast<uint64_t>(jsonStat.st_size), hashBytes(text.data(), text.size())};
+    appendRaw(out, header);
+    out.append(snapshot);
+    if (!writeFileAtomic(snapshotPath(path), out, false)) {
+        logger.warning("Failed to write config snapshot for: %s", path.c_str());
+    }
+}
+
+bool parsejsonfile(ConfigDocument& doc, std::string_view filename) {
+    // A missing file reads as empty, which does not parse either.
+    return parsejson(doc, readfile(filename));
+}
+
+// Parses a NUL terminated copy of the input in place. The copy is allocated from doc's own allocator, and the parsed strings point into it,
+// so it lives exactly as long as they can. rapidjson only replaces doc's value when parsing succeeds, so on failure doc is left untouched.
 bool parsejson(ConfigDocument& doc, std::string_view js) {
-    char temp[js.length() + 1];
-    memcpy(temp, js.data(), js.length());
-    temp[js.length()] = '\0';
+    auto* buffer = static_cast<char*>(doc.GetAllocator().Malloc(js.length() + 1));
+    if (!buffer) {
+        return false;
+    }
+    memcpy(buffer, js.data(), js.length());
+    buffer[js.length()] = '\0';
+    return !doc.ParseInsitu(buffer).HasParseError();
+}
 
-    if (doc.ParseInsitu(temp).HasParseError()) {
+// Config hot reload.
+// A single inotify instance watches the directories of every watched config. Renames into the directory are watched too,
+// since both our own atomic writes and most editors replace the file instead of writing it in place.
+static constexpr auto watchDebounce = std::chrono::milliseconds(200);
+
+struct ConfigWatcher {
+    static ConfigWatcher& get() {
+        static ConfigWatcher watcher;
+        return watcher;
+    }
+
+    void add(Configuration* config) {
+        std::scoped_lock lock(watchLock);
+        if (fd < 0) {
+            fd = inotify_init1(IN_CLOEXEC);
+            if (fd < 0) {
+                Logger::get().error("Failed to initialize inotify for config watching, errno: %i", errno);
+                return;
+            }
+            std::thread(&ConfigWatcher::run, this).detach();
+        }
+        auto dir = config->filePath.substr(0, config->filePath.find_last_of('/') + 1);
+        if (!dirWatches.contains(dir)) {
+            int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd < 0) {
+                Logger::get().error("Failed to watch config directory: %s, errno: %i", dir.c_str(), errno);
+                return;
+            }
+            dirWatches.emplace(dir, wd);
+            watchDirs.emplace(wd, dir);
+        }
+        watched.emplace(config->filePath, config);
+    }
+
+    void remove(Configuration* config) {
+        // Taking the callback lock ensures no callback for this config is running once we return.
+        std::scoped_lock lock(callbackLock, watchLock);
+        auto range = watched.equal_range(config->filePath);
+        for (auto itr = range.first; itr != range.second; ++itr) {
+            if (itr->second == config) {
+                watched.erase(itr);
+                break;
+            }
+        }
+    }
+
+    // Hands the watch of from over to to, which has the same path.
+    void replace(Configuration* from, Configuration* to) {
+        std::scoped_lock lock(watchLock);
+        auto range = watched.equal_range(to->filePath);
+        for (auto itr = range.first; itr != range.second; ++itr) {
+            if (itr->second == from) {
+                itr->second = to;
+                break;
+            }
+        }
+    }
+
+    void run() {
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        std::unordered_set<std::string> changed;
+        while (true) {
+            auto len = read(fd, buffer, sizeof(buffer));
+            if (len < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                Logger::get().error("Config watcher failed to read inotify events, errno: %i", errno);
+                return;
+            }
+            collect(buffer, len, changed);
+            // Keep collecting until the directory has been quiet for the debounce period.
+            pollfd pfd{fd, POLLIN, 0};
+            while (poll(&pfd, 1, watchDebounce.count()) > 0) {
+                len = read(fd, buffer, sizeof(buffer));
+                if (len > 0) {
+                    collect(buffer, len, changed);
+                }
+            }
+            for (auto const& path : changed) {
+                reload(path);
+            }
+            changed.clear();
+        }
+    }
+
+    void collect(const char* buffer, ssize_t len, std::unordered_set<std::string>& changed) {
+        std::scoped_lock lock(watchLock);
+        for (auto* ptr = buffer; ptr < buffer + len;) {
+            auto* event = reinterpret_cast<const inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+            auto itr = watchDirs.find(event->wd);
+            if (itr == watchDirs.end() || event->len == 0) {
+                continue;
+            }
+            auto path = itr->second + event->name;
+            if (watched.contains(path)) {
+                changed.emplace(std::move(path));
+            }
+        }
+    }
+
+    void reload(std::string const& path) {
+        auto text = readfile(path);
+        auto hash = hashBytes(text.data(), text.size());
+        {
+            std::scoped_lock hashLock(writeHashLock);
+            auto itr = lastWrittenHash.find(path);
+            if (itr != lastWrittenHash.end() && itr->second == hash) {
+                return;
+            }
+        }
+        std::scoped_lock cbLock(callbackLock);
+        std::vector<Configuration*> configs;
+        {
+            std::scoped_lock lock(watchLock);
+            auto range = watched.equal_range(path);
+            for (auto itr = range.first; itr != range.second; ++itr) {
+                configs.push_back(itr->second);
+            }
+        }
+        for (auto* config : configs) {
+            auto doc = std::make_unique<ConfigDocument>();
+            if (!parsejson(*doc, text) || !doc->IsObject()) {
+                Logger::get().warning("Changed config: %s could not be parsed, ignoring", path.c_str());
+                return;
+            }
+            std::function<void(Configuration&)> callback;
+            {
+                std::scoped_lock lock(configStateLock);
+                auto itr = configStates.find(config);
+                if (itr == configStates.end()) {
+                    continue;
+                }
+                if (!itr->second.pendingReload) {
+                    pendingReloadCount.fetch_add(1, std::memory_order_release);
+                }
+                itr->second.pendingReload = std::move(doc);
+                callback = itr->second.reloadCallback;
+            }
+            if (callback) {
+                callback(*config);
+            }
+        }
+    }
+
+    std::mutex watchLock;
+    // Held while callbacks run, recursive so that a callback may call StopWatching.
+    std::recursive_mutex callbackLock;
+    int fd = -1;
+    std::unordered_map<std::string, int> dirWatches;
+    std::unordered_map<int, std::string> watchDirs;
+    std::unordered_multimap<std::string, Configuration*> watched;
+};
+
+void Configuration::WatchForChanges(std::function<void(Configuration&)> callback) {
+    StopWatching();
+    {
+        std::scoped_lock lock(configStateLock);
+        configStates[this].reloadCallback = std::move(callback);
+    }
+    ConfigWatcher::get().add(this);
+}
+
+void Configuration::StopWatching() {
+    ConfigWatcher::get().remove(this);
+    std::scoped_lock lock(configStateLock);
+    auto itr = configStates.find(this);
+    if (itr != configStates.end()) {
+        itr->second.reloadCallback = nullptr;
+    }
+}
+
+bool Configuration::ApplyPendingReload() {
+    if (pendingReloadCount.load(std::memory_order_acquire) == 0) {
         return false;
     }
+    std::unique_ptr<ConfigDocument> doc;
+    {
+        std::scoped_lock lock(configStateLock);
+        auto itr = configStates.find(this);
+        if (itr == configStates.end() || !itr->second.pendingReload) {
+            return false;
+        }
+        doc = std::move(itr->second.pendingReload);
+        pendingReloadCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    // Copied rather than swapped, so that config keeps its allocator. Strings parsed in place point into doc's allocator, so they are copied too.
+    config.CopyFrom(*doc, config.GetAllocator(), true);
+    readJson = true;
     return true;
 }
 
+void Configuration::moveState(Configuration& other) {
+    // Held so that no reload is delivered while the state and the watch are between the two configs.
+    auto& watcher = ConfigWatcher::get();
+    std::scoped_lock cbLock(watcher.callbackLock);
+    bool watched;
+    {
+        std::scoped_lock lock(configStateLock);
+        auto node = configStates.extract(&other);
+        if (!node) {
+            return;
+        }
+        watched = static_cast<bool>(node.mapped().reloadCallback);
+        node.key() = this;
+        configStates.insert(std::move(node));
+    }
+    if (watched) {
+        watcher.replace(&other, this);
+    }
+}
+
+Configuration::~Configuration() {
+    bool watched;
+    {
+        std::scoped_lock lock(configStateLock);
+        auto itr = configStates.find(this);
+        if (itr == configStates.end()) {
+            return;
+        }
+        watched = static_cast<bool>(itr->second.reloadCallback);
+    }
+    if (watched) {
+        StopWatching();
+    }
+    std::scoped_lock lock(configStateLock);
+    auto itr = configStates.find(this);
+    if (itr->second.pendingReload) {
+        pendingReloadCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    configStates.erase(itr);
+}
+
 std::string Configuration::getConfigFilePath(const ModInfo& info) {
     if (!Configuration::configDir) {
         Configuration::configDir = string_format(CONFIG_PATH_FORMAT, Modloader::getApplicationId().c_str());
@@ -109,4 +816,13 @@ std::string getDataDir(std::string_view id) {
     return *dataDir + id.data() + "/";
 }
 
+std::string getDataFilePath(const ModInfo& info, std::string_view kind, std::string_view extension) {
+    auto dir = getDataDir(info);
+    if (!direxists(dir)) {
+        mkpath(dir);
+    }
+    return dir + string_format("%.*s-%ld.%.*s", static_cast<int>(kind.size()), kind.data(), static_cast<long>(std::time(nullptr)),
+        static_cast<int>(extension.size()), extension.data());
+}
+
 #endif /* CONFIG_DEFINED_H */
\ No newline at end of file
@@ -33,7 +33,8 @@
 #include <android/log.h>
 #include <errno.h>
 #include <string.h>
-#ifdef __aarch64__
+// The relocator (__fix_instructions) is plain integer code, host builds compile it for the relocation harness.
+#if defined(__aarch64__) || defined(BS_HOOK_HOST_BUILD)
 
 #include "../../shared/inline-hook/And64InlineHook.hpp"
 #define   A64_MAX_INSTRUCTIONS 5
@@ -197,8 +198,10 @@ static bool __fix_cond_comp_test_branch(instruction inpp, instruction outpp, con
         } //if
     } //if
 
+    // shift the immediate's sign bit (bit 23, or bit 18 for tbz/tbnz) up to bit 31 so it is sign-extended
+    const uint32_t msb    = (lmask == lmask2) ? 13u : 8u;
     intptr_t current_idx  = ctxp->get_and_set_current_index(*inpp, *outpp);
-    int64_t absolute_addr = reinterpret_cast<int64_t>(*inpp) + ((ins & ~lmask) >> (lsb - 2u));
+    int64_t absolute_addr = reinterpret_cast<int64_t>(*inpp) + (static_cast<int32_t>((ins & ~lmask) << msb) >> (msb + lsb - 2u)); // sign-extended
     int64_t new_pc_offset = static_cast<int64_t>(absolute_addr - reinterpret_cast<int64_t>(*outpp)) >> 2; // shifted
     bool special_fix_type = ctxp->is_in_fixing_range(absolute_addr);
     if (!special_fix_type && llabs(new_pc_offset) >= (~lmask >> (lsb + 1))) {
@@ -277,7 +280,7 @@ static bool __fix_loadlit(instruction inpp, instruction outpp, context *ctxp)
     } //if
 
     intptr_t current_idx  = ctxp->get_and_set_current_index(*inpp, *outpp);
-    int64_t absolute_addr = reinterpret_cast<int64_t>(*inpp) + ((static_cast<int32_t>(ins << msb) >> (msb + lsb - 2u)) & ~3u);
+    int64_t absolute_addr = reinterpret_cast<int64_t>(*inpp) + ((static_cast<int32_t>(ins << msb) >> (msb + lsb - 2u)) & ~3); // sign-extended
     int64_t new_pc_offset = static_cast<int64_t>(absolute_addr - reinterpret_cast<int64_t>(*outpp)) >> 2; // shifted
     bool special_fix_type = ctxp->is_in_fixing_range(absolute_addr);
     // special_fix_type may encounter issue when there are mixed data and code
@@ -302,7 +305,7 @@ static bool __fix_loadlit(instruction inpp, instruction outpp, context *ctxp)
         }
         ctxp->reset_current_ins(current_idx, *outpp);
 
-        (*outpp)[0] = (static_cast<uint32_t>(new_pc_offset << lsb) & ~mask) | (ins & lmask);
+        (*outpp)[0] = (static_cast<uint32_t>(new_pc_offset << lsb) & ~lmask) | (ins & lmask); // ~mask would let a negative offset into the size bits
         ++(*outpp);
     } //if
 
@@ -333,7 +336,7 @@ static bool __fix_pcreladdr(instruction inpp, instruction outpp, context *ctxp)
         {
             current_idx           = ctxp->get_and_set_current_index(*inpp, *outpp);
             int64_t lsb_bytes     = static_cast<uint32_t>(ins << 1u) >> 30u;
-            int64_t absolute_addr = reinterpret_cast<int64_t>(*inpp) + (((static_cast<int32_t>(ins << msb) >> (msb + lsb - 2u)) & ~3u) | lsb_bytes);
+            int64_t absolute_addr = reinterpret_cast<int64_t>(*inpp) + (((static_cast<int32_t>(ins << msb) >> (msb + lsb - 2u)) & ~3) | lsb_bytes); // sign-extended
             int64_t new_pc_offset = static_cast<int64_t>(absolute_addr - reinterpret_cast<int64_t>(*outpp));
             bool special_fix_type = ctxp->is_in_fixing_range(absolute_addr);
             if (!special_fix_type && llabs(new_pc_offset) >= (max_val >> 1)) {
@@ -357,8 +360,8 @@ static bool __fix_pcreladdr(instruction inpp, instruction outpp, context *ctxp)
                     } //if
                 } //if
 
-                // the lsb_bytes will never be changed, so we can use lmask to keep it
-                (*outpp)[0] = (static_cast<uint32_t>(new_pc_offset << (lsb - 2u)) & fmask) | (ins & lmask);
+                // the lsb_bytes will never be changed, so we can use lmask to keep it (and must not shift them into Rd)
+                (*outpp)[0] = (static_cast<uint32_t>((new_pc_offset >> 2) << lsb) & fmask) | (ins & lmask);
                 ++(*outpp);
             } //if
         }
@@ -367,7 +370,7 @@ static bool __fix_pcreladdr(instruction inpp, instruction outpp, context *ctxp)
         {
             current_idx           = ctxp->get_and_set_current_index(*inpp, *outpp);
             int32_t lsb_bytes     = static_cast<uint32_t>(ins << 1u) >> 30u;
-            int64_t absolute_addr = (reinterpret_cast<int64_t>(*inpp) & ~0xfffll) + ((((static_cast<int32_t>(ins << msb) >> (msb + lsb - 2u)) & ~3u) | lsb_bytes) << 12);
+            int64_t absolute_addr = (reinterpret_cast<int64_t>(*inpp) & ~0xfffll) + (static_cast<int64_t>(((static_cast<int32_t>(ins << msb) >> (msb + lsb - 2u)) & ~3) | lsb_bytes) << 12); // sign-extended
             A64_LOGI("ins = 0x%.8X, pc = %p, abs_addr = %p",
                      ins, *inpp, reinterpret_cast<int64_t *>(absolute_addr));
             if (ctxp->is_in_fixing_range(absolute_addr)) {
@@ -405,7 +408,7 @@ static bool __fix_pcreladdr(instruction inpp, instruction outpp, context *ctxp)
 
 //-------------------------------------------------------------------------
 #define __flush_cache(c, n)        __builtin___clear_cache(reinterpret_cast<char *>(c), reinterpret_cast<char *>(c) + n)
-static void __fix_instructions(uint32_t *__restrict inp, int32_t count, uint32_t *__restrict outp)
+static uintptr_t __fix_instructions(uint32_t *__restrict inp, int32_t count, uint32_t *__restrict outp)
 {
     context ctx;
     ctx.basep = reinterpret_cast<int64_t>(inp);
@@ -451,10 +454,22 @@ static void __fix_instructions(uint32_t *__restrict inp, int32_t count, uint32_t
 
     const uintptr_t total = (outp - outp_base) * sizeof(uint32_t);
     __flush_cache(outp_base, total); // necessary
+    return total;
 }
 
 //-------------------------------------------------------------------------
 
+extern "C" A64_JNIEXPORT uintptr_t A64FixInstructions(uint32_t *const original, const int32_t count, uint32_t *const trampoline)
+{
+    return __fix_instructions(original, count, trampoline);
+}
+
+#endif // defined(__aarch64__) || defined(BS_HOOK_HOST_BUILD)
+
+#ifdef __aarch64__
+
+//-------------------------------------------------------------------------
+
 extern "C" {
 #define __attribute                __attribute__
 #define aligned(x)                 __aligned__(x)
@@ -0,0 +1,67 @@
+#ifdef TEST_CONFIG_BINDING
+#include "../../shared/config/config-binding.hpp"
+#include <cassert>
+
+enum class TestMode {
+    Off,
+    On
+};
+
+struct TestBoundConfig {
+    bool enabled = true;
+    float speed = 1.0f;
+    int count = 3;
+    uint32_t flags = 0;
+    TestMode mode = TestMode::Off;
+    std::string name = "default";
+    static constexpr auto config_fields = std::make_tuple(
+        config_binding::BindField("enabled", &TestBoundConfig::enabled),
+        config_binding::BindField("speed", &TestBoundConfig::speed),
+        config_binding::BindField("count", &TestBoundConfig::count),
+        config_binding::BindField("flags", &TestBoundConfig::flags),
+        config_binding::BindField("mode", &TestBoundConfig::mode),
+        config_binding::BindField("name", &TestBoundConfig::name)
+    );
+};
+
+static void test() {
+    Configuration config(ModInfo{"binding-test", "1.0.0"});
+    // Marked as read, so that Load deserializes this document instead of reading the file.
+    config.readJson = true;
+    parsejson(config.config, R"({"enabled": "yes", "speed": 2.5, "count": 7, "flags": 1, "mode": 1})");
+    BoundConfig<TestBoundConfig> bound(config);
+    bound.Load();
+
+    // Present and well typed.
+    assert(bound->speed == 2.5f);
+    assert(bound->count == 7);
+    assert(bound->flags == 1);
+    assert(bound->mode == TestMode::On);
+    // Wrong typed and missing fields keep their defaults, and are dirty so that the next Write fixes the file.
+    assert(bound->enabled);
+    assert(bound->name == "default");
+    assert(bound.isDirty());
+
+    // Setting a field to its current value does not dirty it.
+    bound.set<&TestBoundConfig::count>(7);
+    bound.set<&TestBoundConfig::count>(8);
+    assert(bound.get().count == 8);
+
+    // Changed behind the binding's back: only dirty fields are serialized, so this must survive the Write.
+    config.config["speed"].SetDouble(9.0);
+    assert(bound.Write());
+    assert(!bound.isDirty());
+    assert(config.config["enabled"].IsBool() && config.config["enabled"].GetBool());
+    assert(std::string_view(config.config["name"].GetString()) == "default");
+    assert(config.config["count"].GetInt() == 8);
+    assert(config.config["speed"].GetDouble() == 9.0);
+
+    // Nothing changed since, so nothing is written.
+    bound.set<&TestBoundConfig::count>(8);
+    assert(!bound.Write());
+
+    bound.markAllDirty();
+    assert(bound.Write());
+    assert(config.config["speed"].GetDouble() == 2.5);
+}
+#endif
@@ -2,17 +2,304 @@
 #include "shared/utils/il2cpp-functions.hpp"
 #include "shared/utils/logging.hpp"
 #include "shared/utils/utils.h"
+#include <dlfcn.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace gc_accounting {
+    namespace detail {
+        std::atomic<bool> enabled = false;
+    }
+
+    namespace {
+        // Each thread owns one of these tables and is the only one that ever writes to it.
+        // Readers (reports) only load, so no lock or RMW is needed on the allocation path.
+        constexpr std::size_t kSiteSlots = 1024;
+        struct SiteCounter {
+            std::atomic<uintptr_t> site;
+            std::atomic<std::size_t> count;
+            std::atomic<std::size_t> bytes;
+        };
+        struct ThreadCounters {
+            std::atomic<uint32_t> generation;
+            // Allocations that could not be given their own slot because the table is full.
+            SiteCounter overflow;
+            SiteCounter slots[kSiteSlots];
+        };
+
+        std::atomic<uint32_t> generation = 0;
+        std::mutex threadsLock;
+        // Thread tables are intentionally never freed, so that counts made by finished threads are still reported.
+        std::vector<ThreadCounters*> threadTables;
+
+        struct FixedAlloc {
+            std::size_t size;
+            uintptr_t site;
+        };
+        // Live allocations are sharded by pointer, so that a free (from whichever thread) finds its allocation's shard,
+        // and allocations and frees on different threads rarely share a lock.
+        constexpr std::size_t kLiveShards = 64;
+        struct alignas(64) LiveShard {
+            std::mutex lock;
+            std::unordered_map<void*, FixedAlloc> allocations;
+        };
+        std::array<LiveShard, kLiveShards> liveFixed;
+
+        LiveShard& liveShardOf(void* ptr) noexcept {
+            // GC allocations are at least 16 byte aligned.
+            return liveFixed[(reinterpret_cast<uintptr_t>(ptr) >> 4) % kLiveShards];
+        }
+
+        template<class F>
+        void forEachLiveFixed(F&& f) {
+            for (auto& shard : liveFixed) {
+                std::scoped_lock lock(shard.lock);
+                for (auto const& pair : shard.allocations) {
+                    f(pair.first, pair.second);
+                }
+            }
+        }
+
+        ThreadCounters* getThreadCounters() noexcept {
+            thread_local ThreadCounters* table = nullptr;
+            if (!table) {
+                table = new (std::nothrow) ThreadCounters();
+                if (!table) {
+                    return nullptr;
+                }
+                table->generation.store(generation.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                std::scoped_lock lock(threadsLock);
+                threadTables.push_back(table);
+            }
+            return table;
+        }
+
+        inline void bump(SiteCounter& counter, std::size_t sz) noexcept {
+            counter.count.store(counter.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            counter.bytes.store(counter.bytes.load(std::memory_order_relaxed) + sz, std::memory_order_relaxed);
+        }
+
+        void clearTable(ThreadCounters& table) noexcept {
+            for (auto& slot : table.slots) {
+                slot.site.store(0, std::memory_order_relaxed);
+                slot.count.store(0, std::memory_order_relaxed);
+                slot.bytes.store(0, std::memory_order_relaxed);
+            }
+            table.overflow.count.store(0, std::memory_order_relaxed);
+            table.overflow.bytes.store(0, std::memory_order_relaxed);
+        }
+
+        void trackFixed(void* ptr, std::size_t sz, const void* site) noexcept {
+            auto& shard = liveShardOf(ptr);
+            std::scoped_lock lock(shard.lock);
+            shard.allocations.insert_or_assign(ptr, FixedAlloc{sz, reinterpret_cast<uintptr_t>(site)});
+        }
+
+        void untrackFixed(void* ptr) noexcept {
+            auto& shard = liveShardOf(ptr);
+            std::scoped_lock lock(shard.lock);
+            shard.allocations.erase(ptr);
+        }
+
+        struct SiteTotals {
+            std::size_t count = 0;
+            std::size_t bytes = 0;
+        };
+
+        std::unordered_map<uintptr_t, SiteTotals> collectSites() {
+            std::unordered_map<uintptr_t, SiteTotals> sites;
+            auto gen = generation.load(std::memory_order_relaxed);
+            std::scoped_lock lock(threadsLock);
+            for (auto* table : threadTables) {
+                // Tables that have not caught up with the last Reset only hold stale counts.
+                if (table->generation.load(std::memory_order_acquire) != gen) {
+                    continue;
+                }
+                auto addSlot = [&](SiteCounter const& slot, uintptr_t site) {
+                    auto count = slot.count.load(std::memory_order_relaxed);
+                    if (count == 0) {
+                        return;
+                    }
+                    auto& totals = sites[site];
+                    totals.count += count;
+                    totals.bytes += slot.bytes.load(std::memory_order_relaxed);
+                };
+                for (auto const& slot : table->slots) {
+                    auto site = slot.site.load(std::memory_order_acquire);
+                    if (site) {
+                        addSlot(slot, site);
+                    }
+                }
+                addSlot(table->overflow, 0);
+            }
+            return sites;
+        }
+
+        std::string moduleOf(uintptr_t site) {
+            Dl_info info;
+            if (site && dladdr(reinterpret_cast<void*>(site), &info) && info.dli_fname) {
+                return info.dli_fname;
+            }
+            return "<unknown>";
+        }
+
+        std::string describeSite(uintptr_t site) {
+            Dl_info info;
+            if (!site || !dladdr(reinterpret_cast<void*>(site), &info)) {
+                return "<unknown>";
+            }
+            auto offset = site - reinterpret_cast<uintptr_t>(info.dli_fbase);
+            if (info.dli_sname) {
+                return string_format("%s (%s) + %lx", info.dli_fname, info.dli_sname, offset);
+            }
+            return string_format("%s + %lx", info.dli_fname, offset);
+        }
+    }
+
+    void SetEnabled(bool value) noexcept {
+        detail::enabled.store(value, std::memory_order_relaxed);
+        if (!value) {
+            // Frees are not observed while disabled, so anything tracked now would go stale.
+            for (auto& shard : liveFixed) {
+                std::scoped_lock lock(shard.lock);
+                shard.allocations.clear();
+            }
+        }
+    }
+
+    void RecordAlloc(const void* site, std::size_t sz) noexcept {
+        if (!IsEnabled()) {
+            return;
+        }
+        auto* table = getThreadCounters();
+        if (!table) {
+            return;
+        }
+        auto gen = generation.load(std::memory_order_relaxed);
+        if (table->generation.load(std::memory_order_relaxed) != gen) {
+            clearTable(*table);
+            table->generation.store(gen, std::memory_order_release);
+        }
+        auto key = reinterpret_cast<uintptr_t>(site);
+        if (key == 0) {
+            bump(table->overflow, sz);
+            return;
+        }
+        // Open addressing with linear probing, sites are code addresses so drop the low (alignment) bits when hashing.
+        auto idx = (key >> 2) % kSiteSlots;
+        for (std::size_t i = 0; i < kSiteSlots; i++) {
+            auto& slot = table->slots[(idx + i) % kSiteSlots];
+            auto existing = slot.site.load(std::memory_order_relaxed);
+            if (existing == key) {
+                bump(slot, sz);
+                return;
+            }
+            if (existing == 0) {
+                bump(slot, sz);
+                slot.site.store(key, std::memory_order_release);
+                return;
+            }
+        }
+        bump(table->overflow, sz);
+    }
+
+    std::vector<ModuleStats> GetModuleStats() {
+        std::unordered_map<std::string, ModuleStats> modules;
+        for (auto const& [site, totals] : collectSites()) {
+            auto name = moduleOf(site);
+            auto& stats = modules.try_emplace(name, ModuleStats{name, 0, 0, 0}).first->second;
+            stats.allocCount += totals.count;
+            stats.allocBytes += totals.bytes;
+        }
+        forEachLiveFixed([&](void*, FixedAlloc const& alloc) {
+            auto name = moduleOf(alloc.site);
+            auto& stats = modules.try_emplace(name, ModuleStats{name, 0, 0, 0}).first->second;
+            stats.liveFixedBytes += alloc.size;
+        });
+        std::vector<ModuleStats> result;
+        result.reserve(modules.size());
+        for (auto& pair : modules) {
+            result.emplace_back(std::move(pair.second));
+        }
+        std::sort(result.begin(), result.end(), [](ModuleStats const& a, ModuleStats const& b) {
+            return a.allocBytes > b.allocBytes;
+        });
+        return result;
+    }
+
+    std::vector<FixedAllocation> GetLiveFixedAllocations() {
+        std::vector<FixedAllocation> result;
+        forEachLiveFixed([&](void* ptr, FixedAlloc const& alloc) {
+            result.push_back({ptr, alloc.size, reinterpret_cast<const void*>(alloc.site)});
+        });
+        return result;
+    }
+
+    void LogReport(std::size_t topN) {
+        static auto logger = Logger::get().WithContext("GCAccounting");
+        static std::mutex reportLock;
+        static std::unordered_map<std::string, std::size_t> lastBytes;
+        static auto lastTime = std::chrono::steady_clock::now();
+
+        std::scoped_lock lock(reportLock);
+        auto now = std::chrono::steady_clock::now();
+        auto seconds = std::chrono::duration<double>(now - lastTime).count();
+        lastTime = now;
+
+        auto modules = GetModuleStats();
+        logger.info("Allocation report for %zu modules over the last %.2fs:", modules.size(), seconds);
+        for (auto const& stats : modules) {
+            auto& last = lastBytes[stats.module];
+            // Counters may have been reset since the last report.
+            auto delta = stats.allocBytes >= last ? stats.allocBytes - last : stats.allocBytes;
+            last = stats.allocBytes;
+            logger.info("%s: %zu allocations, %zu bytes, %zu live fixed bytes, %.1f bytes/s", stats.module.c_str(), stats.allocCount, stats.allocBytes, stats.liveFixedBytes, seconds > 0 ? delta / seconds : 0.0);
+        }
+
+        auto sites = collectSites();
+        std::vector<std::pair<uintptr_t, SiteTotals>> sorted(sites.begin(), sites.end());
+        auto n = std::min(topN, sorted.size());
+        std::partial_sort(sorted.begin(), sorted.begin() + n, sorted.end(), [](auto const& a, auto const& b) {
+            return a.second.bytes > b.second.bytes;
+        });
+        logger.info("Top %zu allocation sites:", n);
+        for (std::size_t i = 0; i < n; i++) {
+            logger.info("%zu: %s: %zu allocations, %zu bytes", i, describeSite(sorted[i].first).c_str(), sorted[i].second.count, sorted[i].second.bytes);
+        }
+    }
+
+    void Reset() noexcept {
+        // Each thread clears its own table the next time it records, keeping the allocation path free of cross thread writes.
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+}
 
 [[nodiscard]] void* gc_alloc_specific(size_t sz) {
+    return gc_alloc_specific_from(sz, __builtin_return_address(0));
+}
+
+[[nodiscard]] void* gc_alloc_specific_from(size_t sz, const void* site) {
     // This function assumes il2cpp_functions will be called at a reasonable time, instead will warn you on allocating unsafe memory.
     if (il2cpp_functions::hasGCFuncs) {
         // We should absolutely panic if we thought we had the allocation function, but it gave us null.
         auto* ptr = CRASH_UNLESS(il2cpp_functions::GarbageCollector_AllocateFixed(sz, nullptr));
+        if (gc_accounting::IsEnabled()) {
+            gc_accounting::RecordAlloc(site, sz);
+            gc_accounting::trackFixed(ptr, sz, site);
+        }
         return ptr;
     } else {
         auto* ptr = calloc(1, sz);
         // We cannot use our logger because we allocate it using this function.
         __android_log_print(Logging::WARNING, "QuestHook[GC_Alloc]", "Allocation at: %p for size: %lu fallback to calloc!", ptr, sz);
+        if (gc_accounting::IsEnabled()) {
+            gc_accounting::RecordAlloc(site, sz);
+            gc_accounting::trackFixed(ptr, sz, site);
+        }
         return ptr;
     }
 }
@@ -25,6 +312,9 @@
 }
 
 void gc_free_specific(void* ptr) noexcept {
+    if (gc_accounting::IsEnabled()) {
+        gc_accounting::untrackFixed(ptr);
+    }
     if (il2cpp_functions::hasGCFuncs) {
         il2cpp_functions::GC_free(ptr);
     }
@@ -1,10 +1,19 @@
 #include <unistd.h>
+#include <link.h>
 
 #include "../../shared/utils/hooking.hpp"
 #include "../../shared/utils/il2cpp-functions.hpp"
+// HOST_BUILD replaces the xref traces with the mock's exports, except for the offline xref harness, which traces a real image.
+#if !defined(BS_HOOK_HOST_BUILD) || defined(BS_HOOK_HOST_XREFS)
+#define BS_HOOK_TRACE_XREFS
+#endif
+#ifdef BS_HOOK_TRACE_XREFS
 #include "capstone/shared/capstone/capstone.h"
+#endif
 #include "../../shared/utils/logging.hpp"
+#ifdef BS_HOOK_TRACE_XREFS
 #include "../../shared/utils/capstone-utils.hpp"
+#endif
 #include "modloader/shared/modloader.hpp"
 
 #define API_INIT(rt, name, ...) rt (*il2cpp_functions::il2cpp_##name)__VA_ARGS__
@@ -307,6 +316,7 @@ std::remove_pointer_t<decltype(il2cpp_functions::s_Il2CppMetadataRegistrationPtr
 
 bool il2cpp_functions::hasGCFuncs;
 const Il2CppDefaults* il2cpp_functions::defaults;
+pthread_mutex_t* il2cpp_functions::s_ClassFromNameMutex;
 bool il2cpp_functions::initialized;
 
 // copies of the highly-inlinable functions
@@ -361,6 +371,13 @@ Il2CppClass* il2cpp_functions::MetadataCache_GetNestedTypeFromIndex(NestedTypeIn
     return il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(nestedTypeIndices[index]);
 }
 
+TypeDefinitionIndex il2cpp_functions::MetadataCache_GetNestedTypeDefinitionIndexFromIndex(NestedTypeIndex index) {
+    CheckS_GlobalMetadata();
+    IL2CPP_ASSERT(index >= 0 && static_cast<uint32_t>(index) < s_GlobalMetadataHeader->nestedTypesCount / sizeof(TypeDefinitionIndex));
+    auto nestedTypeIndices = (const TypeDefinitionIndex*)((const char*)s_GlobalMetadata + s_GlobalMetadataHeader->nestedTypesOffset);
+    return nestedTypeIndices[index];
+}
+
 TypeDefinitionIndex il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(const Il2CppClass* typeDefinition) {
     CheckS_GlobalMetadata();
     IL2CPP_ASSERT(typeDefinition->typeDefinition);
@@ -382,6 +399,7 @@ char* il2cpp_functions::Type_GetName(const Il2CppType *type, Il2CppTypeNameForma
     return buffer;
 }
 
+#ifdef BS_HOOK_TRACE_XREFS
 static std::optional<uint32_t*> blrFind(cs_insn* insn) {
     return insn->id == ARM64_INS_BLR ? std::optional<uint32_t*>(reinterpret_cast<uint32_t*>(insn->address)) : std::nullopt;
 }
@@ -462,23 +480,71 @@ static std::optional<uint32_t*> loadFind(cs_insn* insn) {
     return (insn->id == ARM64_INS_LDR || insn->id == ARM64_INS_LDP) ? std::optional<uint32_t*>(reinterpret_cast<uint32_t*>(insn->address)) : std::nullopt;
 }
 
+struct WritableDataQuery {
+    uintptr_t library;
+    uintptr_t address;
+    size_t size;
+    bool inLibrary;
+    bool writable;
+};
+
+// Finds the library containing query->library, and checks whether [address, address + size) overlaps it, and whether it is in one of its writable segments outside its relro region.
+// The GOT (and so entries like __stack_chk_guard) is relro, while the static a pc relative xref is looking for is in .data or .bss.
+static int findWritableData(dl_phdr_info* info, size_t, void* data) {
+    auto* query = static_cast<WritableDataQuery*>(data);
+    bool containsLibrary = false, inLibrary = false, inWritable = false, inRelro = false;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        auto const& phdr = info->dlpi_phdr[i];
+        auto start = info->dlpi_addr + phdr.p_vaddr;
+        auto end = start + phdr.p_memsz;
+        bool overlaps = query->address < end && query->address + query->size > start;
+        bool contains = query->address >= start && query->address + query->size <= end;
+        if (phdr.p_type == PT_LOAD) {
+            containsLibrary |= query->library >= start && query->library < end;
+            inLibrary |= overlaps;
+            inWritable |= (phdr.p_flags & PF_W) && contains;
+        } else if (phdr.p_type == PT_GNU_RELRO) {
+            inRelro |= overlaps;
+        }
+    }
+    if (!containsLibrary) return 0;
+    query->inLibrary = inLibrary;
+    query->writable = inWritable && !inRelro;
+    return 1;
+}
+
+// Reads the pthread mutex behind the os::FastMutex at address, a static found by xref, or returns nullptr if address does not look like one.
+static pthread_mutex_t* readFastMutex(const void* library, const uint32_t* address) {
+    auto slot = reinterpret_cast<uintptr_t>(address);
+    if (slot % alignof(void*)) return nullptr;
+    WritableDataQuery query{reinterpret_cast<uintptr_t>(library), slot, sizeof(void*), false, false};
+    if (!dl_iterate_phdr(findWritableData, &query) || !query.writable) return nullptr;
+    // FastMutex holds its implementation behind a pointer, which on posix is a recursive pthread mutex allocated at static initialization.
+    auto* impl = *reinterpret_cast<pthread_mutex_t* const*>(slot);
+    if (!impl || reinterpret_cast<uintptr_t>(impl) % alignof(pthread_mutex_t)) return nullptr;
+    // A pointer into the library itself is another static (or code), not the heap allocated implementation.
+    WritableDataQuery implQuery{reinterpret_cast<uintptr_t>(library), reinterpret_cast<uintptr_t>(impl), sizeof(pthread_mutex_t), false, false};
+    if (!dl_iterate_phdr(findWritableData, &implQuery) || implQuery.inLibrary) return nullptr;
+    return impl;
+}
+#endif  // BS_HOOK_TRACE_XREFS
+
 LoggerContextObject& il2cpp_functions::getFuncLogger() {
     static auto logger = Logger::get().WithContext("il2cpp_functions");
     return logger;
 }
 
 
-#define API_SYM(name) \
-*(void**)(&il2cpp_##name) = dlsym(imagehandle, "il2cpp_" #name); \
-logger.debug("Loaded: " #name ", error: %s", dlerror())
-// Autogenerated
+static void* dlsymResolver(void* imagehandle, const char* symbol) {
+    return dlsym(imagehandle, symbol);
+}
+
 // Initializes all of the IL2CPP functions via dlopen and dlsym for use.
 void il2cpp_functions::Init() {
     if (initialized) {
         return;
     }
     static auto logger = getFuncLogger().WithContext("Init");
-    logger.info("il2cpp_functions: Init: Initializing all IL2CPP Functions...");
     dlerror();  // clears existing errors
     auto path = Modloader::getLibIl2CppPath();
     void *imagehandle = dlopen(path.c_str(), RTLD_GLOBAL | RTLD_LAZY);
@@ -486,6 +552,21 @@ void il2cpp_functions::Init() {
         logger.error("Failed to dlopen %s: %s!", path.c_str(), dlerror());
         return;
     }
+    Init(&dlsymResolver, imagehandle);
+    dlclose(imagehandle);
+}
+
+#define API_SYM(name) \
+*(void**)(&il2cpp_##name) = resolve(ctx, "il2cpp_" #name); \
+logger.debug("Loaded: " #name ": %p", *(void**)(&il2cpp_##name))
+// Autogenerated
+// Initializes all of the IL2CPP functions, looking up each exported symbol with resolve.
+void il2cpp_functions::Init(SymbolResolver resolve, void* ctx) {
+    if (initialized) {
+        return;
+    }
+    static auto logger = getFuncLogger().WithContext("Init");
+    logger.info("il2cpp_functions: Init: Initializing all IL2CPP Functions...");
     #ifdef UNITY_2019
     API_SYM(init);
     API_SYM(init_utf16);
@@ -750,11 +831,12 @@ void il2cpp_functions::Init() {
     #endif
 
     // MANUALLY DEFINED CONST DEFINITIONS
-    *(void**)(&il2cpp_class_get_type_const) = dlsym(imagehandle, "il2cpp_class_get_type");
+    *(void**)(&il2cpp_class_get_type_const) = resolve(ctx, "il2cpp_class_get_type");
     logger.info("Loaded: il2cpp_class_get_type CONST VERSION!");
-    *(void**)(&il2cpp_class_get_name_const) = dlsym(imagehandle, "il2cpp_class_get_name");
+    *(void**)(&il2cpp_class_get_name_const) = resolve(ctx, "il2cpp_class_get_name");
     logger.info("Loaded: il2cpp_class_get_name CONST VERSION!");
 
+    #ifdef BS_HOOK_TRACE_XREFS
     // XREF TRACES
     // TODO: Consider making all of these optional and having only those that are truly used crash on fail
     // Alternatively, have none of them crash on fail, but on usage
@@ -885,6 +967,39 @@ void il2cpp_functions::Init() {
         logger.debug("%p %p %p metadata pointers", s_GlobalMetadataHeaderPtr, s_Il2CppMetadataRegistrationPtr, s_GlobalMetadataPtr);
         logger.debug("All global constants found!");
     }
+    {
+        // Image::ClassFromName's s_ClassFromNameMutex: an early pc relative address in Image::ClassFromName, reached through Class::FromName.
+        // Not required: name registration synchronizes only with itself without it.
+        // The address is only trusted if it is a writable static of libil2cpp holding a heap pointer, a GOT entry (like __stack_chk_guard) is rejected.
+        auto Class_FromName = cs::findNthB<1>(reinterpret_cast<const uint32_t*>(il2cpp_class_from_name));
+        auto Image_ClassFromName = Class_FromName ? cs::findNthB<1>(*Class_FromName) : std::nullopt;
+        // A stack protected build loads __stack_chk_guard first, so the first few pc relative addresses are tried in order.
+        auto tryMutex = [&]<uint32_t n>() {
+            auto mutexAddr = cs::getpcaddr<n, 1>(*Image_ClassFromName);
+            s_ClassFromNameMutex = mutexAddr ? readFastMutex(reinterpret_cast<const void*>(il2cpp_class_from_name), std::get<2>(*mutexAddr)) : nullptr;
+            return s_ClassFromNameMutex != nullptr;
+        };
+        if (Image_ClassFromName) {
+            tryMutex.operator()<1>() || tryMutex.operator()<2>() || tryMutex.operator()<3>();
+        }
+        if (s_ClassFromNameMutex) {
+            logger.debug("Image::ClassFromName found? offset: %lX, s_ClassFromNameMutex: %p", reinterpret_cast<uintptr_t>(*Image_ClassFromName) - getRealOffset(0), s_ClassFromNameMutex);
+        } else {
+            logger.warning("Failed to find s_ClassFromNameMutex! Type names will be registered without il2cpp's lock.");
+        }
+    }
+    #else
+    // HOST_BUILD: the mock libil2cpp exports the non-API functions and il2cpp_defaults directly, there is nothing to trace.
+    *(void**)(&il2cpp_Class_Init) = resolve(ctx, "il2cpp_mock_Class_Init");
+    *(void**)(&il2cpp_Class_FromIl2CppType) = resolve(ctx, "il2cpp_mock_Class_FromIl2CppType");
+    *(void**)(&il2cpp_GC_free) = resolve(ctx, "il2cpp_mock_GC_free");
+    *(void**)(&il2cpp_GarbageCollector_AllocateFixed) = resolve(ctx, "il2cpp_mock_GarbageCollector_AllocateFixed");
+    *(void**)(&il2cpp_GarbageCollector_SetWriteBarrier) = resolve(ctx, "il2cpp_mock_GarbageCollector_SetWriteBarrier");
+    hasGCFuncs = il2cpp_GarbageCollector_AllocateFixed != nullptr && il2cpp_GC_free != nullptr;
+    defaults = reinterpret_cast<decltype(defaults)>(resolve(ctx, "il2cpp_mock_defaults"));
+    if (!defaults) SAFE_ABORT_MSG("Mock libil2cpp does not export il2cpp_mock_defaults!");
+    logger.debug("Loaded mock il2cpp non-API functions and il2cpp_defaults: %p", defaults);
+    #endif  // BS_HOOK_TRACE_XREFS
 
     // WeakPtr stuff somewhere
 
@@ -898,7 +1013,9 @@ void il2cpp_functions::Init() {
     //     logger.critical("Failed to parse il2cpp_shutdown's implementation address! Could not install shutdown hook for closing file logs.");
     // }
 
-    dlclose(imagehandle);
+    // Names managed frames in backtraces (and the profiler's stacks) from here on
+    backtrace_helpers::setManagedFrameSymbolizer(&il2cpp_utils::SymbolizeManagedFrame);
+
     initialized = true;
     logger.info("il2cpp_functions: Init: Successfully loaded all il2cpp functions!");
 }
@@ -0,0 +1,163 @@
+#include "../../shared/utils/il2cpp-utils-attributes.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include "../../shared/utils/hashing.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    struct AttributeEntry {
+        bool has = false;
+        // A strong GC handle on the constructed attribute (or array of attributes), 0 if it was not constructed yet.
+        uint32_t handle = 0;
+    };
+
+    // (class or method, attribute class), with a null attribute class for GetAttributes.
+    using AttributeKey = std::pair<const void*, Il2CppClass*>;
+    std::unordered_map<AttributeKey, AttributeEntry, il2cpp_utils::hash_pair> attributeCache;
+    std::shared_mutex attributeCacheLock;
+
+    // The Il2CppCustomAttrInfo of a class or method, freed once the query is done. Null for members without attributes.
+    struct AttrInfo {
+        Il2CppCustomAttrInfo* info;
+        explicit AttrInfo(Il2CppClass* klass) : info(il2cpp_functions::custom_attrs_from_class(klass)) {}
+        explicit AttrInfo(const MethodInfo* method) : info(il2cpp_functions::custom_attrs_from_method(method)) {}
+        AttrInfo(AttrInfo const&) = delete;
+        AttrInfo& operator=(AttrInfo const&) = delete;
+        ~AttrInfo() {
+            if (info) il2cpp_functions::custom_attrs_free(info);
+        }
+    };
+
+    std::optional<AttributeEntry> findCached(AttributeKey const& key) {
+        std::shared_lock lock(attributeCacheLock);
+        auto itr = attributeCache.find(key);
+        if (itr == attributeCache.end()) return std::nullopt;
+        return itr->second;
+    }
+
+    // Stores a constructed object unless another thread stored one first, returning whichever was stored.
+    Il2CppObject* storeConstructed(AttributeKey const& key, Il2CppObject* constructed, bool has) {
+        uint32_t handle = constructed ? il2cpp_functions::gchandle_new(constructed, false) : 0;
+        uint32_t existing = 0;
+        {
+            std::unique_lock lock(attributeCacheLock);
+            auto& entry = attributeCache[key];
+            if (entry.handle) {
+                existing = entry.handle;
+            } else {
+                entry = {has, handle};
+            }
+        }
+        if (!existing) return constructed;
+        if (handle) il2cpp_functions::gchandle_free(handle);
+        return il2cpp_functions::gchandle_get_target(existing);
+    }
+
+    template<class T>
+    bool hasAttribute(T member, Il2CppClass* attributeClass) {
+        il2cpp_functions::Init();
+        if (!member || !attributeClass) return false;
+        AttributeKey key{member, attributeClass};
+        if (auto entry = findCached(key)) return entry->has;
+        AttrInfo info(member);
+        bool has = info.info && il2cpp_functions::custom_attrs_has_attr(info.info, attributeClass);
+        std::unique_lock lock(attributeCacheLock);
+        attributeCache.try_emplace(key, AttributeEntry{has, 0});
+        return has;
+    }
+
+    template<class T>
+    Il2CppObject* getAttribute(T member, Il2CppClass* attributeClass) {
+        il2cpp_functions::Init();
+        if (!member || !attributeClass) return nullptr;
+        AttributeKey key{member, attributeClass};
+        auto entry = findCached(key);
+        if (entry && entry->handle) return il2cpp_functions::gchandle_get_target(entry->handle);
+        // A known absence (from HasAttribute or a scan) needs no construction.
+        if (entry && !entry->has) return nullptr;
+        AttrInfo info(member);
+        auto* attribute = info.info ? il2cpp_functions::custom_attrs_get_attr(info.info, attributeClass) : nullptr;
+        return storeConstructed(key, attribute, attribute != nullptr);
+    }
+
+    template<class T>
+    Il2CppArray* getAttributes(T member) {
+        il2cpp_functions::Init();
+        if (!member) return nullptr;
+        AttributeKey key{member, nullptr};
+        auto entry = findCached(key);
+        if (entry && entry->handle) return reinterpret_cast<Il2CppArray*>(il2cpp_functions::gchandle_get_target(entry->handle));
+        if (entry) return nullptr;
+        AttrInfo info(member);
+        auto* attributes = info.info ? il2cpp_functions::custom_attrs_construct(info.info) : nullptr;
+        if (attributes && il2cpp_functions::array_length(attributes) == 0) attributes = nullptr;
+        return reinterpret_cast<Il2CppArray*>(storeConstructed(key, reinterpret_cast<Il2CppObject*>(attributes), attributes != nullptr));
+    }
+}
+
+namespace il2cpp_utils {
+    bool HasAttribute(Il2CppClass* klass, Il2CppClass* attributeClass) noexcept {
+        return hasAttribute(klass, attributeClass);
+    }
+
+    bool HasAttribute(const MethodInfo* method, Il2CppClass* attributeClass) noexcept {
+        return hasAttribute(method, attributeClass);
+    }
+
+    Il2CppObject* GetAttribute(Il2CppClass* klass, Il2CppClass* attributeClass) noexcept {
+        return getAttribute(klass, attributeClass);
+    }
+
+    Il2CppObject* GetAttribute(const MethodInfo* method, Il2CppClass* attributeClass) noexcept {
+        return getAttribute(method, attributeClass);
+    }
+
+    Il2CppArray* GetAttributes(Il2CppClass* klass) noexcept {
+        return getAttributes(klass);
+    }
+
+    Il2CppArray* GetAttributes(const MethodInfo* method) noexcept {
+        return getAttributes(method);
+    }
+
+    std::vector<Il2CppClass*> FindClassesWithAttribute(Il2CppClass* attributeClass, uint32_t threads) noexcept {
+        static auto logger = getLogger().WithContext("FindClassesWithAttribute");
+        il2cpp_functions::Init();
+        RET_DEFAULT_UNLESS(logger, attributeClass);
+        auto start = std::chrono::steady_clock::now();
+
+        auto slices = detail::SliceClasses();
+        // Matches are stored by slice, so the result does not depend on which thread scanned what.
+        std::vector<std::vector<Il2CppClass*>> matches(slices.size());
+        threads = detail::ParallelForSlices(slices.size(), threads, [&](std::size_t i) {
+            auto const& slice = slices[i];
+            std::vector<std::pair<Il2CppClass*, bool>> answers;
+            for (std::size_t j = slice.first; j < slice.first + slice.count; j++) {
+                auto* klass = const_cast<Il2CppClass*>(il2cpp_functions::image_get_class(slice.image, j));
+                if (!klass) continue;
+                AttrInfo info(klass);
+                bool has = info.info && il2cpp_functions::custom_attrs_has_attr(info.info, attributeClass);
+                answers.emplace_back(klass, has);
+                if (has) matches[i].push_back(klass);
+            }
+            // One lock per slice rather than per class.
+            std::unique_lock lock(attributeCacheLock);
+            for (auto const& answer : answers) {
+                attributeCache.try_emplace({answer.first, attributeClass}, AttributeEntry{answer.second, 0});
+            }
+        });
+
+        std::vector<Il2CppClass*> result;
+        for (auto const& taskMatches : matches) {
+            result.insert(result.end(), taskMatches.begin(), taskMatches.end());
+        }
+        logger.info("Found %zu classes with %s in %zu slices on %u threads in %lldms", result.size(), ClassStandardName(attributeClass).c_str(), slices.size(), threads,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
+        return result;
+    }
+}
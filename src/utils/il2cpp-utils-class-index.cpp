@@ -0,0 +1,265 @@
+#include "../../shared/utils/il2cpp-utils-classes.hpp"
+#include "../../shared/utils/il2cpp-utils-metadata-reader.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    struct ClassEntry {
+        // "Namespace.Name", or just "Name" in the global namespace. Nested classes are named "Outer/Inner", in the namespace of the outermost class.
+        std::string fullName;
+        // Where the name starts in fullName, 0 in the global namespace.
+        uint32_t nameOffset;
+        // Position of the entry in natural order of full names, so that matches are sorted by comparing integers.
+        uint32_t rank = 0;
+        TypeDefinitionIndex index;
+        // Only set when the index was built by walking classes instead of the metadata.
+        Il2CppClass* klass;
+
+        std::string_view Name() const { return std::string_view(fullName).substr(nameOffset); }
+        std::string_view Namespace() const { return std::string_view(fullName).substr(0, nameOffset ? nameOffset - 1 : 0); }
+    };
+
+    struct ClassNameIndex {
+        std::vector<ClassEntry> entries;
+        // Entry indices sorted by name, by full name, and by namespace then rank.
+        std::vector<uint32_t> byName;
+        std::vector<uint32_t> byFullName;
+        std::vector<uint32_t> byNamespace;
+    };
+
+    // Digit runs are replaced by their length (without leading zeros) followed by their digits, so that comparing keys bytewise compares numbers by value,
+    // like alphanum_less does. Runs of more than 16 significant digits all sort as if they were 16 digits long.
+    std::string naturalSortKey(std::string_view name) {
+        std::string key;
+        key.reserve(name.size() + 4);
+        std::size_t i = 0;
+        while (i < name.size()) {
+            if (!isdigit(static_cast<unsigned char>(name[i]))) {
+                key.push_back(name[i++]);
+                continue;
+            }
+            auto start = i;
+            while (i < name.size() && isdigit(static_cast<unsigned char>(name[i]))) i++;
+            auto digits = name.substr(start, i - start);
+            auto significant = digits.find_first_not_of('0');
+            digits = significant == std::string_view::npos ? digits.substr(digits.size() - 1) : digits.substr(significant);
+            key.push_back(static_cast<char>('0' + std::min<std::size_t>(digits.size(), 16)));
+            key.append(digits);
+        }
+        return key;
+    }
+
+    // '*' matches any run of characters and '?' any one character. Backtracks to the last '*' only, which is enough for a single-line glob.
+    bool globMatch(std::string_view pattern, std::string_view text) {
+        std::size_t p = 0, t = 0, star = std::string_view::npos, resume = 0;
+        while (t < text.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == text[t])) {
+                p++;
+                t++;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = t;
+            } else if (star != std::string_view::npos) {
+                p = star + 1;
+                t = ++resume;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') p++;
+        return p == pattern.size();
+    }
+
+    void addTypes(ClassNameIndex& index, il2cpp_utils::MetadataReader const& reader, TypeDefinitionIndex type, std::string fullName, uint32_t nameOffset) {
+        for (auto nested : reader.GetNestedTypes(type)) {
+            auto* definition = reader.GetTypeDefinition(nested);
+            auto* name = definition ? reader.GetString(definition->nameIndex) : nullptr;
+            if (!name) continue;
+            addTypes(index, reader, nested, fullName + "/" + name, nameOffset);
+        }
+        index.entries.push_back({std::move(fullName), nameOffset, 0, type, nullptr});
+    }
+
+    // Reads every type definition from the metadata, without creating their classes.
+    void addTypes(ClassNameIndex& index, il2cpp_utils::MetadataReader const& reader) {
+        index.entries.reserve(reader.TypeCount());
+        for (TypeDefinitionIndex i = 0; i < reader.TypeCount(); i++) {
+            auto* definition = reader.GetTypeDefinition(i);
+            if (definition->declaringTypeIndex != kTypeIndexInvalid) continue;
+            auto* namespaze = reader.GetString(definition->namespaceIndex);
+            auto* name = reader.GetString(definition->nameIndex);
+            if (!name) continue;
+            std::string fullName = namespaze && *namespaze ? std::string(namespaze) + "." : std::string();
+            auto nameOffset = static_cast<uint32_t>(fullName.size());
+            addTypes(index, reader, i, fullName + name, nameOffset);
+        }
+    }
+
+    // Walks the classes of every assembly instead, for when the metadata can not be read (such as with the mock libil2cpp).
+    void addClasses(ClassNameIndex& index) {
+        static auto logger = getLogger().WithContext("FindClasses");
+        auto* domain = il2cpp_functions::domain_get();
+        size_t size;
+        auto** assemblies = il2cpp_functions::domain_get_assemblies(domain, &size);
+        for (size_t i = 0; i < size; i++) {
+            auto* image = assemblies[i] ? il2cpp_functions::assembly_get_image(assemblies[i]) : nullptr;
+            if (!image) {
+                logger.warning("Assembly %zu has no image! Skipping.", i);
+                continue;
+            }
+            auto count = il2cpp_functions::image_get_class_count(image);
+            for (size_t j = 0; j < count; j++) {
+                auto* klass = const_cast<Il2CppClass*>(il2cpp_functions::image_get_class(image, j));
+                if (!klass) continue;
+                std::string name = il2cpp_functions::class_get_name(klass);
+                auto* outer = klass;
+                while (auto* declaring = il2cpp_functions::class_get_declaring_type(outer)) {
+                    name = std::string(il2cpp_functions::class_get_name(declaring)) + "/" + name;
+                    outer = declaring;
+                }
+                auto* namespaze = il2cpp_functions::class_get_namespace(outer);
+                std::string fullName = namespaze && *namespaze ? std::string(namespaze) + "." : std::string();
+                auto nameOffset = static_cast<uint32_t>(fullName.size());
+                index.entries.push_back({fullName + name, nameOffset, 0, kTypeDefinitionIndexInvalid, klass});
+            }
+        }
+    }
+
+    // Adds the names in il2cpp's class hash tables that neither the metadata nor the classes named, such as those registered by custom type libraries.
+    void addRegisteredNames(ClassNameIndex& index) {
+        std::unordered_set<std::string_view> known;
+        known.reserve(index.entries.size());
+        for (auto const& entry : index.entries) known.insert(entry.fullName);
+        std::vector<ClassEntry> added;
+        il2cpp_utils::detail::ForEachRegisteredName([&](const char* namespaze, const char* name, TypeDefinitionIndex type) {
+            if (!name) return;
+            std::string fullName = namespaze && *namespaze ? std::string(namespaze) + "." : std::string();
+            auto nameOffset = static_cast<uint32_t>(fullName.size());
+            fullName += name;
+            if (known.contains(fullName)) return;
+            added.push_back({std::move(fullName), nameOffset, 0, type, nullptr});
+        });
+        // known views the entries' names, so they are only appended once it is no longer used.
+        known.clear();
+        for (auto& entry : added) {
+            index.entries.push_back(std::move(entry));
+        }
+    }
+
+    ClassNameIndex buildIndex() {
+        static auto logger = getLogger().WithContext("FindClasses");
+        auto start = std::chrono::steady_clock::now();
+        ClassNameIndex index;
+        bool fromMetadata = false;
+        #ifndef BS_HOOK_HOST_BUILD
+        if (auto reader = il2cpp_utils::MetadataReader::FromRuntime()) {
+            addTypes(index, *reader);
+            fromMetadata = true;
+        }
+        #endif
+        if (!fromMetadata) {
+            addClasses(index);
+        }
+        addRegisteredNames(index);
+        auto& entries = index.entries;
+
+        // Sort keys are only needed once, to rank the entries.
+        {
+            std::vector<std::string> keys;
+            keys.reserve(entries.size());
+            for (auto const& entry : entries) keys.push_back(naturalSortKey(entry.fullName));
+            std::vector<uint32_t> order(entries.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return keys[a] != keys[b] ? keys[a] < keys[b] : entries[a].fullName < entries[b].fullName;
+            });
+            for (uint32_t rank = 0; rank < order.size(); rank++) entries[order[rank]].rank = rank;
+            index.byFullName = order;
+            index.byName = order;
+            index.byNamespace = std::move(order);
+        }
+        std::sort(index.byFullName.begin(), index.byFullName.end(), [&](uint32_t a, uint32_t b) { return entries[a].fullName < entries[b].fullName; });
+        // Stable from rank order, so that equal names and namespaces stay in natural order.
+        std::stable_sort(index.byName.begin(), index.byName.end(), [&](uint32_t a, uint32_t b) { return entries[a].Name() < entries[b].Name(); });
+        std::stable_sort(index.byNamespace.begin(), index.byNamespace.end(), [&](uint32_t a, uint32_t b) { return entries[a].Namespace() < entries[b].Namespace(); });
+
+        logger.info("Indexed %zu class names from %s in %lldms", entries.size(), fromMetadata ? "metadata" : "classes",
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
+        return index;
+    }
+
+    // Appends the entries of sorted, from the first whose key is not below query, for as long as their key starts with query.
+    template<class Key>
+    void collectPrefix(ClassNameIndex const& index, std::vector<uint32_t> const& sorted, std::string_view query, Key key, std::vector<uint32_t>& out) {
+        auto itr = std::lower_bound(sorted.begin(), sorted.end(), query, [&](uint32_t entry, std::string_view value) { return key(index.entries[entry]) < value; });
+        for (; itr != sorted.end() && key(index.entries[*itr]).starts_with(query); ++itr) {
+            out.push_back(*itr);
+        }
+    }
+}
+
+namespace il2cpp_utils {
+    std::vector<Il2CppClass*> FindClasses(std::string_view query, ClassNameQuery kind) noexcept {
+        il2cpp_functions::Init();
+        // Replaced indices stay alive for as long as a lookup is still using them.
+        static std::mutex indexLock;
+        static std::shared_ptr<const ClassNameIndex> currentIndex;
+        static uint32_t indexGeneration = 0;
+        std::shared_ptr<const ClassNameIndex> held;
+        {
+            std::lock_guard lock(indexLock);
+            auto generation = detail::RegisteredNamesGeneration();
+            if (!currentIndex || indexGeneration != generation) {
+                currentIndex = std::make_shared<const ClassNameIndex>(buildIndex());
+                indexGeneration = generation;
+            }
+            held = currentIndex;
+        }
+        auto const& index = *held;
+        auto const& entries = index.entries;
+
+        std::vector<uint32_t> matches;
+        switch (kind) {
+            case ClassNameQuery::Prefix:
+                collectPrefix(index, index.byName, query, [](ClassEntry const& entry) { return entry.Name(); }, matches);
+                break;
+            case ClassNameQuery::Namespace: {
+                auto first = std::lower_bound(index.byNamespace.begin(), index.byNamespace.end(), query,
+                    [&](uint32_t entry, std::string_view value) { return entries[entry].Namespace() < value; });
+                auto last = std::upper_bound(first, index.byNamespace.end(), query,
+                    [&](std::string_view value, uint32_t entry) { return value < entries[entry].Namespace(); });
+                // Already in natural order.
+                matches.assign(first, last);
+                break;
+            }
+            case ClassNameQuery::Wildcard: {
+                std::vector<uint32_t> candidates;
+                collectPrefix(index, index.byFullName, query.substr(0, query.find_first_of("*?")), [](ClassEntry const& entry) { return std::string_view(entry.fullName); }, candidates);
+                for (auto candidate : candidates) {
+                    if (globMatch(query, entries[candidate].fullName)) matches.push_back(candidate);
+                }
+                break;
+            }
+        }
+        if (kind != ClassNameQuery::Namespace) {
+            std::sort(matches.begin(), matches.end(), [&](uint32_t a, uint32_t b) { return entries[a].rank < entries[b].rank; });
+        }
+
+        std::vector<Il2CppClass*> classes;
+        classes.reserve(matches.size());
+        for (auto match : matches) {
+            auto const& entry = entries[match];
+            if (auto* klass = entry.klass ? entry.klass : MetadataReader::GetClass(entry.index)) {
+                classes.push_back(klass);
+            }
+        }
+        return classes;
+    }
+}
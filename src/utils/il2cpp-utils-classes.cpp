@@ -3,7 +3,12 @@
 #include "../../shared/utils/il2cpp-utils-methods.hpp"
 #include "../../shared/utils/il2cpp-utils-properties.hpp"
 #include "../../shared/utils/il2cpp-utils-fields.hpp"
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <thread>
 #include <unordered_map>
 #include "../../shared/utils/alphanum.hpp"
 #include "shared/utils/gc-alloc.hpp"
@@ -142,90 +147,90 @@ namespace il2cpp_utils {
         indent--;
     }
 
-    static std::unordered_map<Il2CppClass*, std::map<std::string, Il2CppGenericClass*, doj::alphanum_less<std::string>>> classToGenericClassMap;
-    void BuildGenericsMap() {
-        static auto logger = getLogger().WithContext("BuildGenericsMap");
-        il2cpp_functions::Init();
-        auto* metadataReg = RET_V_UNLESS(logger, il2cpp_functions::s_Il2CppMetadataRegistration);
-        logger.debug("metadataReg: %p, offset = %lX", metadataReg, ((uintptr_t)metadataReg) - getRealOffset(0));
+    // Generic type definition -> the generic instances the game was compiled with. metadataReg->genericClasses is only ever read,
+    // entries past genericsMapCount are added on the next lookup, readers only share the lock.
+    static std::unordered_map<TypeDefinitionIndex, std::vector<Il2CppGenericClass*>> genericsMap;
+    static int32_t genericsMapCount = 0;
+    static std::shared_mutex genericsMapLock;
 
+    // Called with genericsMapLock held exclusively.
+    static void BuildGenericsMap(const Il2CppMetadataRegistration* metadataReg) {
+        static auto logger = getLogger().WithContext("BuildGenericsMap");
         int uncached_class_count = 0;
-        for (int i=0; i < metadataReg->genericClassesCount; i++) {
+        for (int i = genericsMapCount; i < metadataReg->genericClassesCount; i++) {
             Il2CppGenericClass* genClass = metadataReg->genericClasses[i];
-            if (!genClass) continue;
+            if (!genClass || genClass->typeDefinitionIndex == kTypeDefinitionIndexInvalid) continue;
             if (!(genClass->cached_class)) {
                 uncached_class_count++;
             }
-            std::string genClassName = GenericClassStandardName(genClass);
-
-            auto* typeDefClass = il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(genClass->typeDefinitionIndex);
-            if (!typeDefClass) continue;
-
-            classToGenericClassMap[typeDefClass][genClassName.c_str()] = genClass;
+            genericsMap[genClass->typeDefinitionIndex].push_back(genClass);
         }
-        logger.debug("uncached_class_count: %i (%f proportion of total)", uncached_class_count, uncached_class_count * 1.0 / metadataReg->genericClassesCount);
+        logger.debug("Indexed generic classes %i to %i, uncached_class_count: %i", genericsMapCount, metadataReg->genericClassesCount, uncached_class_count);
+        genericsMapCount = metadataReg->genericClassesCount;
     }
 
-    void LogClasses(LoggerContextObject& logger, std::string_view classPrefix, bool logParents) noexcept {
+    // Returns the generic instances of the provided type definition, extending the map first if needed.
+    static std::vector<Il2CppGenericClass*> GenericClassesOf(TypeDefinitionIndex typeDefinition) {
         il2cpp_functions::Init();
-        BuildGenericsMap();
-
-        // Begin prefix matching
-        std::map<std::string, Il2CppClass*, doj::alphanum_less<std::string>> matches;
-        // Get il2cpp domain
-        auto* dom = il2cpp_functions::domain_get();
-        // Get all il2cpp assemblies
-        size_t size;
-        auto** assembs = il2cpp_functions::domain_get_assemblies(dom, &size);
-
-        for (size_t i = 0; i < size; ++i) {
-            // Get image for each assembly
-            if (!assembs[i]) {
-                logger.warning("Assembly %zu was null! Skipping.", i);
-                continue;
-            }
-            logger.debug("Scanning assembly \"%s\"", assembs[i]->aname.name);
-            auto* img = il2cpp_functions::assembly_get_image(assembs[i]);
-            if (!img) {
-                logger.warning("Assembly's image was null! Skipping.");
-                continue;
-            }
-
-            if (img->nameToClassHashTable == nullptr) {
-                logger.debug("Assembly's nameToClassHashTable is empty. Populating it instead.");
-
-                img->nameToClassHashTable = new Il2CppNameToTypeDefinitionIndexHashTable();
-                for (uint32_t index = 0; index < img->typeCount; index++) {
-                    TypeDefinitionIndex typeIndex = img->typeStart + index;
-                    AddTypeToNametoClassHashTable(img, typeIndex);
-                }
-
-                for (uint32_t index = 0; index < img->exportedTypeCount; index++) {
-                    auto typeIndex = il2cpp_functions::MetadataCache_GetExportedTypeFromIndex(img->exportedTypeStart + index);
-                    if (typeIndex != kTypeIndexInvalid)
-                        AddTypeToNametoClassHashTable(img, typeIndex);
-                }
+        auto* metadataReg = il2cpp_functions::s_Il2CppMetadataRegistration;
+        if (!metadataReg) return {};
+        {
+            std::shared_lock lock(genericsMapLock);
+            if (genericsMapCount >= metadataReg->genericClassesCount) {
+                auto itr = genericsMap.find(typeDefinition);
+                return itr != genericsMap.end() ? itr->second : std::vector<Il2CppGenericClass*>();
             }
+        }
+        std::unique_lock lock(genericsMapLock);
+        if (genericsMapCount < metadataReg->genericClassesCount) {
+            BuildGenericsMap(metadataReg);
+        }
+        auto itr = genericsMap.find(typeDefinition);
+        return itr != genericsMap.end() ? itr->second : std::vector<Il2CppGenericClass*>();
+    }
 
-            for (auto itr = img->nameToClassHashTable->begin(); itr != img->nameToClassHashTable->end(); ++itr) {
-                // ->first is a KeyWrapper(pair(namespaceName, className))
-                // ->second is TypeDefinitionIndex
-                if (strncmp(classPrefix.data(), itr->first.key.second, classPrefix.length()) == 0) {
-                    // Starts with!
-                    // Convert TypeDefinitionIndex --> class
-                    auto klazz = il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(itr->second);
-                    matches[ClassStandardName(klazz)] = klazz;
+    std::vector<Il2CppClass*> GetGenericInstances(const Il2CppClass* klass, bool onlyCreated) noexcept {
+        il2cpp_functions::Init();
+        if (!klass || !il2cpp_functions::s_Il2CppMetadataRegistration) return {};
+        TypeDefinitionIndex typeDefinition;
+        if (klass->generic_class) {
+            typeDefinition = klass->generic_class->typeDefinitionIndex;
+        } else if (klass->typeDefinition && klass->is_generic) {
+            typeDefinition = il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(klass);
+        } else {
+            return {};
+        }
+        std::vector<Il2CppClass*> instances;
+        for (auto* genClass : GenericClassesOf(typeDefinition)) {
+            if (genClass->cached_class) {
+                instances.push_back(genClass->cached_class);
+            } else if (!onlyCreated) {
+                if (auto* instance = il2cpp_functions::GenericClass_GetClass(genClass)) {
+                    instances.push_back(instance);
                 }
             }
         }
+        return instances;
+    }
+
+    void LogClasses(LoggerContextObject& logger, std::string_view classPrefix, bool logParents) noexcept {
+        il2cpp_functions::Init();
+
+        auto matches = FindClasses(classPrefix, ClassNameQuery::Prefix);
 
         usleep(1000);  // 0.001s
         logger.debug("LogClasses:");
-        for ( const auto &pair : matches ) {
-            LogClass(logger, pair.second, logParents);
+        for (auto* klass : matches) {
+            LogClass(logger, klass, logParents);
             indent = -1;
-            for ( const auto &genPair : classToGenericClassMap[pair.second] ) {
-                logger.debug("%s", genPair.first.c_str());
+            if (klass->is_generic && il2cpp_functions::s_Il2CppMetadataRegistration) {
+                std::set<std::string, doj::alphanum_less<std::string>> genClassNames;
+                for (auto* genClass : GenericClassesOf(il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(klass))) {
+                    genClassNames.insert(GenericClassStandardName(genClass));
+                }
+                for (const auto& genClassName : genClassNames) {
+                    logger.debug("%s", genClassName.c_str());
+                }
             }
             usleep(1000);  // 0.001s
         }
@@ -233,6 +238,103 @@ namespace il2cpp_utils {
         logger.debug("maxIndent: %i", maxIndent);
     }
 
+    // A name for AddTypesToNametoClassHashTable to register: the metadata's name for top level types, or the joined "Outer/Inner" for nested types.
+    struct PendingTypeName {
+        const char* namespaze;
+        const char* name;
+        std::string joined;
+        TypeDefinitionIndex index;
+    };
+
+    static void CollectNestedTypeNames(const Il2CppTypeDefinition* typeDefinition, const char* namespaze, const std::string& parentName, std::vector<PendingTypeName>& names) {
+        for (int i = 0; i < typeDefinition->nested_type_count; ++i) {
+            auto index = il2cpp_functions::MetadataCache_GetNestedTypeDefinitionIndexFromIndex(typeDefinition->nestedTypesStart + i);
+            auto* nested = il2cpp_functions::MetadataCache_GetTypeDefinitionFromIndex(index);
+            auto name = parentName + "/" + il2cpp_functions::MetadataCache_GetStringFromIndex(nested->nameIndex);
+            CollectNestedTypeNames(nested, namespaze, name, names);
+            names.push_back({namespaze, nullptr, std::move(name), index});
+        }
+    }
+
+    static void CollectTypeNames(const Il2CppImage* img, TypeDefinitionIndex index, std::vector<PendingTypeName>& names) {
+        const Il2CppTypeDefinition* typeDefinition = il2cpp_functions::MetadataCache_GetTypeDefinitionFromIndex(index);
+        // nested types are found through their declaring type
+        if (typeDefinition->declaringTypeIndex != kTypeIndexInvalid)
+            return;
+        auto* namespaze = il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->namespaceIndex);
+        auto* name = il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->nameIndex);
+        // il2cpp does not register the nested types of corlib either
+        if (img != il2cpp_functions::get_corlib())
+            CollectNestedTypeNames(typeDefinition, namespaze, name, names);
+        names.push_back({namespaze, name, {}, index});
+    }
+
+    // Holds s_ClassFromNameMutex, so that registering names is synchronized with il2cpp creating and reading the table. Falls back to a lock of our own if it was not found.
+    static std::mutex nameTableFallbackLock;
+    // Bumped by every registration, so that FindClasses knows to pick up the new names.
+    static std::atomic<uint32_t> registeredNamesGeneration = 0;
+
+    struct NameTableLock {
+        pthread_mutex_t* mutex = il2cpp_functions::s_ClassFromNameMutex;
+        NameTableLock() {
+            if (mutex) pthread_mutex_lock(mutex);
+            else nameTableFallbackLock.lock();
+        }
+        ~NameTableLock() {
+            if (mutex) pthread_mutex_unlock(mutex);
+            else nameTableFallbackLock.unlock();
+        }
+    };
+
+    size_t AddTypesToNametoClassHashTable(const Il2CppImage* img) {
+        static auto logger = getLogger().WithContext("AddTypesToNametoClassHashTable");
+        il2cpp_functions::Init();
+        RET_0_UNLESS(logger, img);
+
+        // Every name is joined before taking the lock.
+        std::vector<PendingTypeName> names;
+        for (uint32_t index = 0; index < img->typeCount; index++) {
+            CollectTypeNames(img, img->typeStart + index, names);
+        }
+        for (uint32_t index = 0; index < img->exportedTypeCount; index++) {
+            auto typeIndex = il2cpp_functions::MetadataCache_GetExportedTypeFromIndex(img->exportedTypeStart + index);
+            if (typeIndex != kTypeIndexInvalid)
+                CollectTypeNames(img, typeIndex, names);
+        }
+
+        NameTableLock lock;
+        // il2cpp only fills the table when it creates it, so a table created here has to hold every name
+        if (!img->nameToClassHashTable)
+            img->nameToClassHashTable = new Il2CppNameToTypeDefinitionIndexHashTable();
+        auto* hashTable = img->nameToClassHashTable;
+
+        std::vector<PendingTypeName*> missing;
+        size_t arenaSize = 0;
+        for (auto& pending : names) {
+            auto* name = pending.name ? pending.name : pending.joined.c_str();
+            if (hashTable->find(std::make_pair(pending.namespaze, name)) != hashTable->end())
+                continue;
+            missing.push_back(&pending);
+            if (!pending.name)
+                arenaSize += pending.joined.size() + 1;
+        }
+        // One allocation for every joined name, which the table references for as long as the image lives.
+        auto* arena = arenaSize ? static_cast<char*>(gc_alloc_specific(arenaSize)) : nullptr;
+        for (auto* pending : missing) {
+            auto* name = pending->name;
+            if (!name) {
+                memcpy(arena, pending->joined.c_str(), pending->joined.size() + 1);
+                name = arena;
+                arena += pending->joined.size() + 1;
+            }
+            hashTable->insert(std::make_pair(std::make_pair(pending->namespaze, name), pending->index));
+        }
+        if (!missing.empty())
+            registeredNamesGeneration.fetch_add(1, std::memory_order_release);
+        logger.debug("Registered %zu of %zu type names of %s", missing.size(), names.size(), img->name);
+        return missing.size();
+    }
+
     void AddTypeToNametoClassHashTable(const Il2CppImage* img, TypeDefinitionIndex index) {
         il2cpp_functions::Init();
         const Il2CppTypeDefinition* typeDefinition = il2cpp_functions::MetadataCache_GetTypeDefinitionFromIndex(index);
@@ -244,6 +346,7 @@ namespace il2cpp_utils {
             AddNestedTypesToNametoClassHashTable(img, typeDefinition);
 
         img->nameToClassHashTable->insert(std::make_pair(std::make_pair(il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->namespaceIndex), il2cpp_functions::MetadataCache_GetStringFromIndex(typeDefinition->nameIndex)), index));
+        registeredNamesGeneration.fetch_add(1, std::memory_order_release);
     }
 
     void AddNestedTypesToNametoClassHashTable(const Il2CppImage* img, const Il2CppTypeDefinition* typeDefinition) {
@@ -261,9 +364,85 @@ namespace il2cpp_utils {
         strlcpy(pName, name.c_str(), name.length() + 1);
 
         hashTable->insert(std::make_pair(std::make_pair(namespaze, (const char*)pName), il2cpp_functions::MetadataCache_GetIndexForTypeDefinition(klass)));
+        registeredNamesGeneration.fetch_add(1, std::memory_order_release);
 
         void *iter = NULL;
         while (Il2CppClass *nestedClass = il2cpp_functions::class_get_nested_types(klass, &iter))
             AddNestedTypesToNametoClassHashTable(hashTable, namespaze, name, nestedClass);
     }
+
+    namespace detail {
+        uint32_t RegisteredNamesGeneration() noexcept {
+            return registeredNamesGeneration.load(std::memory_order_acquire);
+        }
+
+        void ForEachRegisteredName(std::function<void(const char* namespaze, const char* name, TypeDefinitionIndex index)> const& visit) {
+            il2cpp_functions::Init();
+            size_t assemblyCount = 0;
+            auto** assemblies = il2cpp_functions::domain_get_assemblies(il2cpp_functions::domain_get(), &assemblyCount);
+            for (size_t i = 0; i < assemblyCount; i++) {
+                auto* img = assemblies[i] ? il2cpp_functions::assembly_get_image(assemblies[i]) : nullptr;
+                if (!img)
+                    continue;
+                NameTableLock lock;
+                if (!img->nameToClassHashTable)
+                    continue;
+                for (auto itr = img->nameToClassHashTable->begin(); itr != img->nameToClassHashTable->end(); ++itr) {
+                    // ->first is a KeyWrapper(pair(namespaceName, className)), ->second is the TypeDefinitionIndex
+                    visit(itr->first.key.first, itr->first.key.second, itr->second);
+                }
+            }
+        }
+
+        static constexpr std::size_t classesPerSlice = 2048;
+
+        std::vector<ClassSlice> SliceClasses(std::size_t extraCount) {
+            il2cpp_functions::Init();
+            std::vector<ClassSlice> slices;
+            size_t assemblyCount = 0;
+            auto** assemblies = il2cpp_functions::domain_get_assemblies(il2cpp_functions::domain_get(), &assemblyCount);
+            for (size_t i = 0; i < assemblyCount; i++) {
+                auto* image = assemblies[i] ? il2cpp_functions::assembly_get_image(assemblies[i]) : nullptr;
+                if (!image) continue;
+                auto classCount = il2cpp_functions::image_get_class_count(image);
+                for (std::size_t first = 0; first < classCount; first += classesPerSlice) {
+                    slices.push_back({image, first, std::min(classesPerSlice, classCount - first)});
+                }
+            }
+            for (std::size_t first = 0; first < extraCount; first += classesPerSlice) {
+                slices.push_back({nullptr, first, std::min(classesPerSlice, extraCount - first)});
+            }
+            return slices;
+        }
+
+        uint32_t ParallelForSlices(std::size_t sliceCount, uint32_t threads, std::function<void(std::size_t slice)> const& work) {
+            std::atomic<std::size_t> nextSlice = 0;
+            auto claim = [&]() {
+                auto i = nextSlice.fetch_add(1, std::memory_order_relaxed);
+                while (i < sliceCount) {
+                    work(i);
+                    i = nextSlice.fetch_add(1, std::memory_order_relaxed);
+                }
+            };
+            // Creating and initializing classes allocates from the GC, which must know about the threads doing it.
+            auto attachedClaim = [&]() {
+                auto* thread = il2cpp_functions::thread_attach(il2cpp_functions::domain_get());
+                claim();
+                il2cpp_functions::thread_detach(thread);
+            };
+            if (threads == 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            threads = std::min<std::size_t>(threads, std::max<std::size_t>(1, sliceCount));
+            std::vector<std::thread> workers;
+            for (uint32_t i = 1; i < threads; i++) {
+                workers.emplace_back(attachedClaim);
+            }
+            claim();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            return threads;
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "../../shared/utils/il2cpp-utils-metadata-dump.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include "../../shared/utils/utils-functions.h"
+#include "../../shared/config/config-utils.hpp"
+#include "modloader/shared/modloader.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace il2cpp_utils::metadata_dump_format;
+
+namespace {
+
+    struct BlockBuilder {
+        uintptr_t codeBase;
+        std::vector<MethodRecord> methods;
+        std::vector<TypeRecord> types;
+        std::vector<FieldRecord> fields;
+        std::vector<PropertyRecord> properties;
+        std::vector<ParameterRecord> parameters;
+        // Offset 0 is the empty string.
+        std::string strings = std::string(1, '\0');
+        std::unordered_map<std::string, uint32_t> stringOffsets;
+        // The same Il2CppType* is shared by every use of a type in metadata, so most names are formatted once.
+        std::unordered_map<const Il2CppType*, uint32_t> typeNames;
+        std::unordered_map<const MethodInfo*, uint32_t> methodIndices;
+
+        uint32_t string(const char* str) {
+            if (!str || !*str) return 0;
+            auto [itr, inserted] = stringOffsets.try_emplace(str, strings.size());
+            if (inserted) {
+                strings.append(itr->first.c_str(), itr->first.size() + 1);
+            }
+            return itr->second;
+        }
+
+        uint32_t typeName(const Il2CppType* type) {
+            if (!type) return 0;
+            auto [itr, inserted] = typeNames.try_emplace(type, 0);
+            if (inserted) {
+                // You must il2cpp_functions::free the result of type_get_name
+                auto* name = il2cpp_functions::type_get_name(type);
+                itr->second = string(name);
+                il2cpp_functions::free(name);
+            }
+            return itr->second;
+        }
+
+        void addMethod(const MethodInfo* method) {
+            methodIndices.emplace(method, methods.size());
+            auto& record = methods.emplace_back();
+            auto code = reinterpret_cast<uintptr_t>(method->methodPointer);
+            record.rva = code && code >= codeBase ? code - codeBase : 0;
+            record.name = string(method->name);
+            record.returnType = typeName(il2cpp_functions::method_get_return_type(method));
+            record.firstParameter = parameters.size();
+            record.parameterCount = il2cpp_functions::method_get_param_count(method);
+            record.token = method->token;
+            uint32_t implFlags = 0;
+            record.flags = il2cpp_functions::method_get_flags(method, &implFlags) | (implFlags << 16);
+            for (uint32_t i = 0; i < record.parameterCount; i++) {
+                parameters.push_back({string(il2cpp_functions::method_get_param_name(method, i)), typeName(il2cpp_functions::method_get_param(method, i))});
+            }
+        }
+
+        uint32_t methodIndex(const MethodInfo* method) {
+            if (!method) return noIndex;
+            auto itr = methodIndices.find(method);
+            return itr != methodIndices.end() ? itr->second : noIndex;
+        }
+
+        void addClass(Il2CppClass* klass) {
+            il2cpp_functions::Class_Init(klass);
+            TypeRecord record{};
+            record.namespaze = string(klass->namespaze);
+            record.name = string(klass->name);
+            record.fullName = typeName(&klass->byval_arg);
+            record.parent = klass->parent ? typeName(&klass->parent->byval_arg) : 0;
+            auto* declaring = il2cpp_functions::class_get_declaring_type(klass);
+            record.declaringType = declaring ? typeName(&declaring->byval_arg) : 0;
+            record.token = klass->token;
+            record.flags = klass->flags;
+            record.instanceSize = klass->instance_size;
+
+            record.firstMethod = methods.size();
+            methodIndices.clear();
+            void* iter = nullptr;
+            while (auto* method = il2cpp_functions::class_get_methods(klass, &iter)) {
+                addMethod(method);
+            }
+            record.methodCount = methods.size() - record.firstMethod;
+
+            record.firstField = fields.size();
+            iter = nullptr;
+            while (auto* field = il2cpp_functions::class_get_fields(klass, &iter)) {
+                fields.push_back({string(field->name), typeName(field->type), static_cast<uint32_t>(il2cpp_functions::field_get_flags(field)), field->offset});
+            }
+            record.fieldCount = fields.size() - record.firstField;
+
+            record.firstProperty = properties.size();
+            iter = nullptr;
+            while (auto* property = il2cpp_functions::class_get_properties(klass, &iter)) {
+                properties.push_back({string(property->name), methodIndex(property->get), methodIndex(property->set)});
+            }
+            record.propertyCount = properties.size() - record.firstProperty;
+            types.push_back(record);
+        }
+
+        template<class T>
+        static void append(std::vector<uint8_t>& out, std::vector<T> const& records) {
+            auto* data = reinterpret_cast<const uint8_t*>(records.data());
+            out.insert(out.end(), data, data + records.size() * sizeof(T));
+        }
+
+        std::vector<uint8_t> Finish(const char* imageName) {
+            BlockHeader header{};
+            header.image = string(imageName);
+            header.typeCount = types.size();
+            header.methodCount = methods.size();
+            header.fieldCount = fields.size();
+            header.propertyCount = properties.size();
+            header.parameterCount = parameters.size();
+            header.stringsSize = strings.size();
+            std::vector<uint8_t> out;
+            out.reserve(sizeof(header) + methods.size() * sizeof(MethodRecord) + types.size() * sizeof(TypeRecord) + fields.size() * sizeof(FieldRecord) +
+                properties.size() * sizeof(PropertyRecord) + parameters.size() * sizeof(ParameterRecord) + strings.size() + 8);
+            auto* headerData = reinterpret_cast<const uint8_t*>(&header);
+            out.insert(out.end(), headerData, headerData + sizeof(header));
+            // MethodRecord is the only record with 8 byte members, so it goes first, right after the 8 byte aligned header.
+            append(out, methods);
+            append(out, types);
+            append(out, fields);
+            append(out, properties);
+            append(out, parameters);
+            out.insert(out.end(), strings.begin(), strings.end());
+            out.resize((out.size() + 7) & ~std::size_t(7));
+            return out;
+        }
+    };
+    static_assert(sizeof(BlockHeader) % 8 == 0 && sizeof(MethodRecord) % 8 == 0);
+
+    // Collects a slice of an image, or of the generic instances when its image is nullptr.
+    std::vector<uint8_t> collectBlock(il2cpp_utils::detail::ClassSlice const& slice, std::vector<Il2CppClass*> const& genericInstances, uintptr_t codeBase, DumpHeader& totals) {
+        BlockBuilder builder;
+        builder.codeBase = codeBase;
+        for (std::size_t i = slice.first; i < slice.first + slice.count; i++) {
+            auto* klass = slice.image ? const_cast<Il2CppClass*>(il2cpp_functions::image_get_class(slice.image, i)) : genericInstances[i];
+            if (klass) {
+                builder.addClass(klass);
+            }
+        }
+        // Only written by the thread that owns this block, summed once every block is collected.
+        totals.typeCount = builder.types.size();
+        totals.methodCount = builder.methods.size();
+        totals.fieldCount = builder.fields.size();
+        return builder.Finish(slice.image ? il2cpp_functions::image_get_name(slice.image) : "<generic instances>");
+    }
+}
+
+namespace il2cpp_utils {
+    bool MetadataDump::Write(std::string_view outputPath, uint32_t threads) noexcept {
+        static auto logger = getLogger().WithContext("MetadataDump");
+        il2cpp_functions::Init();
+        #ifndef BS_HOOK_HOST_BUILD
+        il2cpp_functions::CheckS_GlobalMetadata();
+        auto codeBase = getRealOffset(0);
+        #else
+        uintptr_t codeBase = 0;
+        #endif
+        auto start = std::chrono::steady_clock::now();
+
+        std::vector<Il2CppClass*> genericInstances;
+        if (auto* metadataReg = il2cpp_functions::s_Il2CppMetadataRegistration) {
+            for (int i = 0; i < metadataReg->genericClassesCount; i++) {
+                auto* genClass = metadataReg->genericClasses[i];
+                if (genClass && genClass->cached_class) {
+                    genericInstances.push_back(genClass->cached_class);
+                }
+            }
+        }
+        auto slices = il2cpp_utils::detail::SliceClasses(genericInstances.size());
+
+        // Blocks are stored by slice, so the file does not depend on which thread collected what.
+        std::vector<std::vector<uint8_t>> blocks(slices.size());
+        std::vector<DumpHeader> blockTotals(slices.size());
+        threads = il2cpp_utils::detail::ParallelForSlices(slices.size(), threads, [&](std::size_t i) {
+            blocks[i] = collectBlock(slices[i], genericInstances, codeBase, blockTotals[i]);
+        });
+        auto collected = std::chrono::steady_clock::now();
+
+        DumpHeader header{magic, version, static_cast<uint32_t>(blocks.size()), 0, 0, 0};
+        for (auto const& totals : blockTotals) {
+            header.typeCount += totals.typeCount;
+            header.methodCount += totals.methodCount;
+            header.fieldCount += totals.fieldCount;
+        }
+        std::vector<DumpBlock> table(blocks.size());
+        uint64_t offset = (sizeof(DumpHeader) + table.size() * sizeof(DumpBlock) + 7) & ~uint64_t(7);
+        for (std::size_t i = 0; i < blocks.size(); i++) {
+            table[i] = {offset, blocks[i].size()};
+            offset += blocks[i].size();
+        }
+        std::string path(outputPath);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            logger.error("Could not open %s for writing!", path.c_str());
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(DumpBlock));
+        static constexpr char padding[8] = {};
+        out.write(padding, table.empty() ? 0 : table[0].offset - sizeof(DumpHeader) - table.size() * sizeof(DumpBlock));
+        for (auto const& block : blocks) {
+            out.write(reinterpret_cast<const char*>(block.data()), block.size());
+        }
+        out.close();
+        if (out.fail()) {
+            logger.error("Failed writing %s: %s", path.c_str(), strerror(errno));
+            return false;
+        }
+        auto now = std::chrono::steady_clock::now();
+        logger.info("Dumped %u types, %u methods and %u fields in %zu blocks on %u threads to %s (%lu bytes): collected in %lldms, written in %lldms",
+            header.typeCount, header.methodCount, header.fieldCount, blocks.size(), threads, path.c_str(), static_cast<unsigned long>(offset),
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(collected - start).count()),
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(now - collected).count()));
+        return true;
+    }
+
+    std::string MetadataDump::Write(const ModInfo& info) noexcept {
+        auto path = getDataFilePath(info, "metadata", "bhmd");
+        return Write(path) ? path : std::string();
+    }
+}
@@ -0,0 +1,274 @@
+#include "../../shared/utils/il2cpp-utils-metadata-reader.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <string>
+
+namespace {
+    constexpr uint32_t metadataSanity = 0xFAB11BAF;
+
+    // Returns the table at offset, or nullptr if it does not fit in the first size bytes of the metadata.
+    template<class T>
+    const T* table(const char* base, std::size_t size, int32_t offset, int32_t bytes, int32_t& count) {
+        if (offset < 0 || bytes < 0 || static_cast<std::size_t>(offset) > size || static_cast<std::size_t>(bytes) > size - offset) {
+            return nullptr;
+        }
+        // The header stores the size of each table in bytes.
+        count = bytes / sizeof(T);
+        return reinterpret_cast<const T*>(base + offset);
+    }
+
+    std::string_view view(const char* str) {
+        return str ? std::string_view(str) : std::string_view();
+    }
+}
+
+namespace il2cpp_utils {
+    std::optional<MetadataReader> MetadataReader::FromRuntime() noexcept {
+        static auto logger = getLogger().WithContext("MetadataReader");
+        il2cpp_functions::Init();
+        #ifdef BS_HOOK_HOST_BUILD
+        logger.error("The mock libil2cpp has no global metadata, use FromFile instead!");
+        return std::nullopt;
+        #else
+        il2cpp_functions::CheckS_GlobalMetadata();
+        MetadataReader reader;
+        // The runtime does not keep the size of the metadata around, tables are trusted to be within it.
+        if (!reader.Read(il2cpp_functions::s_GlobalMetadata, SIZE_MAX)) {
+            return std::nullopt;
+        }
+        return reader;
+        #endif
+    }
+
+    std::optional<MetadataReader> MetadataReader::FromFile(std::string_view path) noexcept {
+        static auto logger = getLogger().WithContext("MetadataReader");
+        std::string pathStr(path);
+        int fd = open(pathStr.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            logger.error("Could not open %s: %s", pathStr.c_str(), strerror(errno));
+            if (fd >= 0) close(fd);
+            return std::nullopt;
+        }
+        auto size = static_cast<std::size_t>(st.st_size);
+        auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            logger.error("Could not map %s: %s", pathStr.c_str(), strerror(errno));
+            return std::nullopt;
+        }
+        MetadataReader reader;
+        reader.mapping = std::shared_ptr<const void>(data, [size](const void* mapped) { munmap(const_cast<void*>(mapped), size); });
+        if (!reader.Read(data, size)) {
+            return std::nullopt;
+        }
+        return reader;
+    }
+
+    bool MetadataReader::Read(const void* data, std::size_t size) noexcept {
+        static auto logger = getLogger().WithContext("MetadataReader");
+        auto start = std::chrono::steady_clock::now();
+        base = static_cast<const char*>(data);
+        header = static_cast<const Il2CppGlobalMetadataHeader*>(data);
+        if (!data || size < sizeof(Il2CppGlobalMetadataHeader) || static_cast<uint32_t>(header->sanity) != metadataSanity) {
+            logger.error("Not global metadata (sanity %X, should be %X)", data && size >= sizeof(Il2CppGlobalMetadataHeader) ? header->sanity : 0, metadataSanity);
+            return false;
+        }
+        int32_t stringBytes = 0, nestedCount = 0;
+        strings = table<char>(base, size, header->stringOffset, header->stringCount, stringBytes);
+        types = table<Il2CppTypeDefinition>(base, size, header->typeDefinitionsOffset, header->typeDefinitionsCount, typeCount);
+        methods = table<Il2CppMethodDefinition>(base, size, header->methodsOffset, header->methodsCount, methodCount);
+        fields = table<Il2CppFieldDefinition>(base, size, header->fieldsOffset, header->fieldsCount, fieldCount);
+        nestedTypes = table<TypeDefinitionIndex>(base, size, header->nestedTypesOffset, header->nestedTypesCount, nestedCount);
+        if (!strings || !types || !methods || !fields || !nestedTypes) {
+            logger.error("Metadata tables are out of bounds, is it version %i of the format?", header->version);
+            return false;
+        }
+        stringsSize = stringBytes;
+        nestedTypeCount = nestedCount;
+        BuildIndices();
+        logger.info("Read version %i metadata: %i types, %i methods and %i fields indexed in %lldms", header->version, typeCount, methodCount, fieldCount,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()));
+        return true;
+    }
+
+    uint64_t MetadataReader::Key(uint32_t owner, std::string_view name) noexcept {
+        return (static_cast<uint64_t>(owner) << 32) | static_cast<uint32_t>(std::hash<std::string_view>{}(name));
+    }
+
+    uint64_t MetadataReader::Key(std::string_view namespaze, std::string_view name) noexcept {
+        std::hash<std::string_view> hash;
+        return hash(namespaze) * 0x9E3779B97F4A7C15ull ^ hash(name);
+    }
+
+    void MetadataReader::BuildIndices() noexcept {
+        typeIndex.clear();
+        methodIndex.clear();
+        fieldIndex.clear();
+        methodIndex.reserve(methodCount);
+        fieldIndex.reserve(fieldCount);
+        for (TypeDefinitionIndex i = 0; i < typeCount; i++) {
+            auto const& type = types[i];
+            // Nested types are found through their declaring type, which is how class_from_name finds them too.
+            if (type.declaringTypeIndex == kTypeIndexInvalid) {
+                typeIndex.push_back({Key(view(GetString(type.namespaceIndex)), view(GetString(type.nameIndex))), i});
+            }
+            for (uint16_t m = 0; m < type.method_count; m++) {
+                auto method = type.methodStart + m;
+                if (auto* definition = GetMethodDefinition(method)) {
+                    methodIndex.push_back({Key(i, view(GetString(definition->nameIndex))), method});
+                }
+            }
+            for (uint16_t f = 0; f < type.field_count; f++) {
+                auto field = type.fieldStart + f;
+                if (auto* definition = GetFieldDefinition(field)) {
+                    fieldIndex.push_back({Key(i, view(GetString(definition->nameIndex))), field});
+                }
+            }
+        }
+        // Stable, so overloads stay in definition order.
+        std::stable_sort(typeIndex.begin(), typeIndex.end());
+        std::stable_sort(methodIndex.begin(), methodIndex.end());
+        std::stable_sort(fieldIndex.begin(), fieldIndex.end());
+    }
+
+    const Il2CppTypeDefinition* MetadataReader::GetTypeDefinition(TypeDefinitionIndex index) const noexcept {
+        return index >= 0 && index < typeCount ? types + index : nullptr;
+    }
+
+    const Il2CppMethodDefinition* MetadataReader::GetMethodDefinition(MethodIndex index) const noexcept {
+        return index >= 0 && index < methodCount ? methods + index : nullptr;
+    }
+
+    const Il2CppFieldDefinition* MetadataReader::GetFieldDefinition(FieldIndex index) const noexcept {
+        return index >= 0 && index < fieldCount ? fields + index : nullptr;
+    }
+
+    const char* MetadataReader::GetString(StringIndex index) const noexcept {
+        return index >= 0 && static_cast<uint32_t>(index) < stringsSize ? strings + index : nullptr;
+    }
+
+    std::vector<TypeDefinitionIndex> MetadataReader::GetNestedTypes(TypeDefinitionIndex type) const noexcept {
+        std::vector<TypeDefinitionIndex> result;
+        auto* definition = GetTypeDefinition(type);
+        if (!definition) return result;
+        for (uint16_t i = 0; i < definition->nested_type_count; i++) {
+            auto index = definition->nestedTypesStart + i;
+            if (index < 0 || static_cast<uint32_t>(index) >= nestedTypeCount) break;
+            result.push_back(nestedTypes[index]);
+        }
+        return result;
+    }
+
+    TypeDefinitionIndex MetadataReader::FindNested(TypeDefinitionIndex outer, std::string_view name) const noexcept {
+        auto const& type = types[outer];
+        for (uint16_t i = 0; i < type.nested_type_count; i++) {
+            auto index = type.nestedTypesStart + i;
+            if (index < 0 || static_cast<uint32_t>(index) >= nestedTypeCount) break;
+            auto* nested = GetTypeDefinition(nestedTypes[index]);
+            if (nested && name == view(GetString(nested->nameIndex))) {
+                return nestedTypes[index];
+            }
+        }
+        return kTypeDefinitionIndexInvalid;
+    }
+
+    TypeDefinitionIndex MetadataReader::FindType(std::string_view namespaze, std::string_view name) const noexcept {
+        auto slash = name.find('/');
+        auto outerName = name.substr(0, slash);
+        auto [first, last] = std::equal_range(typeIndex.begin(), typeIndex.end(), NameEntry{Key(namespaze, outerName), 0});
+        auto result = kTypeDefinitionIndexInvalid;
+        for (auto itr = first; itr != last; itr++) {
+            auto const& type = types[itr->index];
+            if (namespaze == view(GetString(type.namespaceIndex)) && outerName == view(GetString(type.nameIndex))) {
+                result = itr->index;
+                break;
+            }
+        }
+        while (result != kTypeDefinitionIndexInvalid && slash != std::string_view::npos) {
+            name.remove_prefix(slash + 1);
+            slash = name.find('/');
+            result = FindNested(result, name.substr(0, slash));
+        }
+        return result;
+    }
+
+    std::vector<MethodIndex> MetadataReader::FindMethods(TypeDefinitionIndex type, std::string_view name) const noexcept {
+        std::vector<MethodIndex> result;
+        auto [first, last] = std::equal_range(methodIndex.begin(), methodIndex.end(), NameEntry{Key(static_cast<uint32_t>(type), name), 0});
+        for (auto itr = first; itr != last; itr++) {
+            if (name == view(GetString(methods[itr->index].nameIndex))) {
+                result.push_back(itr->index);
+            }
+        }
+        return result;
+    }
+
+    FieldIndex MetadataReader::FindField(TypeDefinitionIndex type, std::string_view name) const noexcept {
+        auto [first, last] = std::equal_range(fieldIndex.begin(), fieldIndex.end(), NameEntry{Key(static_cast<uint32_t>(type), name), 0});
+        for (auto itr = first; itr != last; itr++) {
+            if (name == view(GetString(fields[itr->index].nameIndex))) {
+                return itr->index;
+            }
+        }
+        return kFieldIndexInvalid;
+    }
+
+    Il2CppClass* MetadataReader::GetClass(TypeDefinitionIndex type) noexcept {
+        il2cpp_functions::Init();
+        if (type == kTypeDefinitionIndexInvalid) return nullptr;
+        return il2cpp_functions::MetadataCache_GetTypeInfoFromTypeDefinitionIndex(type);
+    }
+
+    const MethodInfo* MetadataReader::GetMethod(MethodIndex method) const noexcept {
+        auto* definition = GetMethodDefinition(method);
+        auto* typeDefinition = definition ? GetTypeDefinition(definition->declaringType) : nullptr;
+        if (!typeDefinition) return nullptr;
+        auto* klass = GetClass(definition->declaringType);
+        if (!klass) return nullptr;
+        // The first call sets up every method of the class, in definition order.
+        void* iter = nullptr;
+        il2cpp_functions::class_get_methods(klass, &iter);
+        auto slot = method - typeDefinition->methodStart;
+        if (klass->methods && slot >= 0 && slot < klass->method_count && klass->methods[slot]->token == definition->token) {
+            return klass->methods[slot];
+        }
+        for (uint16_t i = 0; klass->methods && i < klass->method_count; i++) {
+            if (klass->methods[i]->token == definition->token) {
+                return klass->methods[i];
+            }
+        }
+        return nullptr;
+    }
+
+    FieldInfo* MetadataReader::GetField(TypeDefinitionIndex type, FieldIndex field) const noexcept {
+        auto* typeDefinition = GetTypeDefinition(type);
+        auto* definition = GetFieldDefinition(field);
+        if (!typeDefinition || !definition) return nullptr;
+        auto* klass = GetClass(type);
+        if (!klass) return nullptr;
+        // Likewise for fields.
+        void* iter = nullptr;
+        il2cpp_functions::class_get_fields(klass, &iter);
+        auto slot = field - typeDefinition->fieldStart;
+        if (klass->fields && slot >= 0 && slot < klass->field_count && klass->fields[slot].token == definition->token) {
+            return &klass->fields[slot];
+        }
+        for (uint16_t i = 0; klass->fields && i < klass->field_count; i++) {
+            if (klass->fields[i].token == definition->token) {
+                return &klass->fields[i];
+            }
+        }
+        return nullptr;
+    }
+}
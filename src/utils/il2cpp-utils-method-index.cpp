@@ -0,0 +1,216 @@
+#include "../../shared/utils/il2cpp-utils-methods.hpp"
+#include "../../shared/utils/il2cpp-utils-classes.hpp"
+#include <link.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace {
+    struct MethodPointerIndex {
+        // Sorted by method pointer, one entry per pointer.
+        std::vector<std::pair<uintptr_t, const MethodInfo*>> methods;
+        // The library holding the methods, lookups outside of it are rejected without searching.
+        uintptr_t libraryStart = 0;
+        uintptr_t libraryEnd = UINTPTR_MAX;
+        // The library's .eh_frame_hdr binary search table: functionCount pairs of (function start, FDE), both relative to tableBase.
+        const int32_t* functionTable = nullptr;
+        uintptr_t tableBase = 0;
+        uint32_t functionCount = 0;
+    };
+
+    // Held while building, so that concurrent rebuilds do not interleave. Lookups never take it.
+    std::mutex indexLock;
+    // Replaced indices are kept alive, lookups in progress may still be reading them. Rebuilds are rare.
+    std::list<MethodPointerIndex> indices;
+    std::atomic<const MethodPointerIndex*> currentIndex = nullptr;
+
+    void addMethods(std::vector<std::pair<uintptr_t, const MethodInfo*>>& methods, const Il2CppClass* klass, bool setupMethods) {
+        if (!klass) return;
+        if (setupMethods) {
+            void* iter = nullptr;
+            while (il2cpp_functions::class_get_methods(const_cast<Il2CppClass*>(klass), &iter));
+        }
+        // Only read methods that are already set up, setting them up allocates.
+        if (!klass->methods) return;
+        for (uint16_t i = 0; i < klass->method_count; i++) {
+            auto* method = klass->methods[i];
+            if (method && method->methodPointer) {
+                methods.emplace_back(reinterpret_cast<uintptr_t>(method->methodPointer), method);
+            }
+        }
+    }
+
+    struct LibraryQuery {
+        uintptr_t address;
+        uintptr_t start;
+        uintptr_t end;
+        const uint8_t* ehFrameHdr;
+    };
+
+    int findLibrary(dl_phdr_info* info, size_t, void* data) {
+        auto* query = static_cast<LibraryQuery*>(data);
+        bool contains = false;
+        uintptr_t start = UINTPTR_MAX, end = 0;
+        const uint8_t* ehFrameHdr = nullptr;
+        for (int i = 0; i < info->dlpi_phnum; i++) {
+            auto const& phdr = info->dlpi_phdr[i];
+            auto segment = info->dlpi_addr + phdr.p_vaddr;
+            if (phdr.p_type == PT_LOAD) {
+                start = std::min<uintptr_t>(start, segment);
+                end = std::max<uintptr_t>(end, segment + phdr.p_memsz);
+                contains |= query->address >= segment && query->address < segment + phdr.p_memsz;
+            } else if (phdr.p_type == PT_GNU_EH_FRAME) {
+                ehFrameHdr = reinterpret_cast<const uint8_t*>(segment);
+            }
+        }
+        if (!contains) return 0;
+        query->start = start;
+        query->end = end;
+        query->ehFrameHdr = ehFrameHdr;
+        return 1;
+    }
+
+    // Only the layout every toolchain we care about emits is understood: version 1, an absent or 4 byte eh_frame_ptr,
+    // a DW_EH_PE_udata4 fde_count and a DW_EH_PE_datarel | DW_EH_PE_sdata4 table.
+    bool readFunctionTable(const uint8_t* hdr, MethodPointerIndex& index) {
+        constexpr uint8_t omit = 0xFF, udata4 = 0x03, sdata4 = 0x0B, datarelSdata4 = 0x3B;
+        if (hdr[0] != 1 || hdr[2] != udata4 || hdr[3] != datarelSdata4) return false;
+        std::size_t offset = 4;
+        if (hdr[1] != omit) {
+            if ((hdr[1] & 0x0F) != udata4 && (hdr[1] & 0x0F) != sdata4) return false;
+            offset += 4;
+        }
+        memcpy(&index.functionCount, hdr + offset, sizeof(uint32_t));
+        index.functionTable = reinterpret_cast<const int32_t*>(hdr + offset + sizeof(uint32_t));
+        index.tableBase = reinterpret_cast<uintptr_t>(hdr);
+        return index.functionCount > 0;
+    }
+
+    // Returns the start of the function containing pc according to the function table, or 0 if pc precedes every function.
+    uintptr_t functionStart(MethodPointerIndex const& index, uintptr_t pc) {
+        uint32_t low = 0, high = index.functionCount;
+        while (low < high) {
+            auto mid = low + (high - low) / 2;
+            if (index.tableBase + index.functionTable[mid * 2] <= pc) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low ? index.tableBase + index.functionTable[(low - 1) * 2] : 0;
+    }
+
+    // Called with indexLock held.
+    void buildIndex(bool setupAllMethods) {
+        static auto logger = il2cpp_utils::getLogger().WithContext("MethodPointerIndex");
+        il2cpp_functions::Init();
+        #ifndef BS_HOOK_HOST_BUILD
+        il2cpp_functions::CheckS_GlobalMetadata();
+        #endif
+        auto startTime = std::chrono::steady_clock::now();
+        MethodPointerIndex index;
+        if (setupAllMethods) {
+            // image_get_class creates every class, which is what was asked for.
+            auto* domain = il2cpp_functions::domain_get();
+            size_t assemblyCount = 0;
+            auto** assemblies = il2cpp_functions::domain_get_assemblies(domain, &assemblyCount);
+            for (size_t i = 0; i < assemblyCount; i++) {
+                auto* image = il2cpp_functions::assembly_get_image(assemblies[i]);
+                if (!image) continue;
+                auto classCount = il2cpp_functions::image_get_class_count(image);
+                for (size_t j = 0; j < classCount; j++) {
+                    addMethods(index.methods, il2cpp_functions::image_get_class(image, j), true);
+                }
+            }
+        } else {
+            // Only classes il2cpp already created. They are collected first, il2cpp may hold its metadata lock while reporting them.
+            std::vector<Il2CppClass*> classes;
+            il2cpp_functions::class_for_each([](Il2CppClass* klass, void* data) { static_cast<std::vector<Il2CppClass*>*>(data)->push_back(klass); }, &classes);
+            for (auto* klass : classes) {
+                addMethods(index.methods, klass, false);
+            }
+        }
+        // Instances of generic classes have their own methods, with their own (possibly shared) code.
+        // Instances of generic methods live in Il2CppCodeRegistration::genericMethodPointers, which il2cpp_functions does not find, so they are not indexed.
+        if (auto* metadataReg = il2cpp_functions::s_Il2CppMetadataRegistration) {
+            for (int i = 0; i < metadataReg->genericClassesCount; i++) {
+                auto* genClass = metadataReg->genericClasses[i];
+                if (genClass && genClass->cached_class) {
+                    addMethods(index.methods, genClass->cached_class, setupAllMethods);
+                }
+            }
+        }
+        // Shared generic code and identical code folding give many methods the same pointer, the first one found names it.
+        std::stable_sort(index.methods.begin(), index.methods.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+        index.methods.erase(std::unique(index.methods.begin(), index.methods.end(), [](auto const& a, auto const& b) { return a.first == b.first; }), index.methods.end());
+        index.methods.shrink_to_fit();
+
+        if (!index.methods.empty()) {
+            LibraryQuery query{index.methods[index.methods.size() / 2].first, 0, 0, nullptr};
+            if (dl_iterate_phdr(findLibrary, &query)) {
+                index.libraryStart = query.start;
+                index.libraryEnd = query.end;
+                if (!query.ehFrameHdr || !readFunctionTable(query.ehFrameHdr, index)) {
+                    logger.warning("No usable .eh_frame_hdr, addresses between methods will be attributed to the preceding method");
+                }
+            }
+        }
+        auto& stored = indices.emplace_back(std::move(index));
+        currentIndex.store(&stored, std::memory_order_release);
+        logger.info("Indexed %zu method pointers in %lldms", stored.methods.size(),
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count()));
+    }
+}
+
+namespace il2cpp_utils {
+    const MethodInfo* FindMethodForPC(const void* pc) noexcept {
+        auto* index = currentIndex.load(std::memory_order_acquire);
+        if (!index) return nullptr;
+        auto address = reinterpret_cast<uintptr_t>(pc);
+        if (address < index->libraryStart || address >= index->libraryEnd) return nullptr;
+        auto itr = std::upper_bound(index->methods.begin(), index->methods.end(), address, [](uintptr_t value, auto const& entry) { return value < entry.first; });
+        if (itr == index->methods.begin()) return nullptr;
+        --itr;
+        // A method only extends to the end of the function it starts, anything after that is code without a MethodInfo.
+        if (index->functionTable && itr->first < functionStart(*index, address)) return nullptr;
+        return itr->second;
+    }
+
+    void RebuildMethodPointerIndex(bool setupAllMethods) noexcept {
+        std::lock_guard lock(indexLock);
+        buildIndex(setupAllMethods);
+    }
+
+    bool SymbolizeManagedFrame(const void* pc, bool mayBlock, std::string& out) noexcept {
+        // The first lookup that may block builds the index, from the classes il2cpp created so far.
+        if (mayBlock && !currentIndex.load(std::memory_order_acquire)) {
+            std::lock_guard lock(indexLock);
+            if (!currentIndex.load(std::memory_order_relaxed)) {
+                buildIndex(false);
+            }
+        }
+        auto* method = FindMethodForPC(pc);
+        if (!method) return false;
+        if (mayBlock) {
+            out = MethodStandardName(method);
+            return true;
+        }
+        // MethodStandardName calls into il2cpp, which may take a lock the aborting thread holds, so only fields already set are read.
+        auto* klass = method->klass;
+        out.clear();
+        if (klass) {
+            if (klass->namespaze && klass->namespaze[0] != '\0') {
+                out.append(klass->namespaze).append("::");
+            } else if (klass->declaringType && klass->declaringType->name) {
+                out.append(klass->declaringType->name).append("/");
+            }
+            out.append(klass->name ? klass->name : "?").append("::");
+        }
+        out.append(method->name ? method->name : "?");
+        return true;
+    }
+}
@@ -313,6 +313,14 @@ namespace il2cpp_utils {
         logger.debug("%s%s %s(%s);", flagStr, retTypeStr, methodName, paramStr);
     }
 
+    std::string MethodStandardName(const MethodInfo* method) {
+        const char* name = method->name ? method->name : "__noname__";
+        if (!method->klass) {
+            return name;
+        }
+        return ClassStandardName(method->klass) + "::" + name;
+    }
+
     bool IsConvertibleFrom(const Il2CppType* to, const Il2CppType* from, bool asArgs) {
         static auto logger = getLogger().WithContext("IsConvertibleFrom");
         RET_0_UNLESS(logger, to);
@@ -0,0 +1,654 @@
+#include "../../shared/utils/il2cpp-utils-profiling.hpp"
+#include "../../shared/utils/il2cpp-utils-classes.hpp"
+#include "../../shared/utils/il2cpp-utils-methods.hpp"
+#include "../../shared/utils/il2cpp-type-check.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+    // il2cpp keeps this pointer and passes it back to every callback, it is never dereferenced.
+    char profilerStorage;
+    std::mutex profilerLock;
+    bool profilerInstalled = false;
+    int enabledEvents = IL2CPP_PROFILE_NONE;
+
+    // ---------------------------------------------------------------- MethodProfiler
+
+    // An enter or leave event. MethodInfo* is at least 4 byte aligned, so the low bit marks leaves.
+    struct MethodEvent {
+        uintptr_t methodAndLeave;
+        uint64_t timestamp;
+    };
+
+    // Single producer (the thread itself), single consumer (the aggregator) ring of events.
+    struct ThreadBuffer {
+        std::unique_ptr<MethodEvent[]> events;
+        uint64_t mask;
+        std::atomic<uint64_t> head = 0;
+        std::atomic<uint64_t> tail = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<bool> exited = false;
+
+        // Owned by the aggregator.
+        struct Frame {
+            const MethodInfo* method;
+            uint64_t start;
+            uint64_t children;
+        };
+        std::vector<Frame> stack;
+        std::unordered_map<const MethodInfo*, uint32_t> active;
+        uint64_t seenDropped = 0;
+
+        explicit ThreadBuffer(uint32_t size) {
+            uint64_t capacity = 1;
+            while (capacity < size) {
+                capacity <<= 1;
+            }
+            events = std::make_unique<MethodEvent[]>(capacity);
+            mask = capacity - 1;
+        }
+    };
+
+    struct Filter {
+        std::unordered_set<const Il2CppClass*> classes;
+        std::unordered_set<const Il2CppImage*> images;
+
+        bool Selects(const MethodInfo* method) const {
+            if (classes.empty() && images.empty()) {
+                return true;
+            }
+            auto* klass = method->klass;
+            if (!klass) {
+                return false;
+            }
+            if (images.contains(klass->image)) {
+                return true;
+            }
+            for (auto* cur = klass; cur; cur = cur->declaringType) {
+                if (classes.contains(cur)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct Totals {
+        uint64_t calls = 0;
+        uint64_t inclusive = 0;
+        uint64_t exclusive = 0;
+    };
+
+    // Serializes MethodProfiler::Start and Stop.
+    std::mutex methodProfilerLock;
+    std::atomic<bool> recording = false;
+    std::atomic<uint32_t> bufferEvents = 16384;
+    // Bumped by Start when bufferEvents changes, so that threads replace their buffer with one of the new size.
+    std::atomic<uint32_t> bufferGeneration = 0;
+    // Callbacks can still be reading a filter when Start replaces it, so replaced filters are kept alive.
+    std::atomic<const Filter*> activeFilter = nullptr;
+    std::list<Filter> filters;
+
+    std::mutex buffersLock;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+    // Guards everything the aggregator owns: the per thread stacks and the totals.
+    std::mutex aggregateLock;
+    std::unordered_map<const MethodInfo*, Totals> totals;
+    uint64_t droppedTotal = 0;
+    std::thread aggregator;
+    std::condition_variable aggregatorWake;
+    bool aggregatorStopping = false;
+
+    struct ThreadBufferHandle {
+        std::shared_ptr<ThreadBuffer> buffer;
+        uint32_t generation = 0;
+        ~ThreadBufferHandle() {
+            if (buffer) {
+                buffer->exited = true;
+            }
+        }
+    };
+
+    ThreadBuffer& currentBuffer() {
+        thread_local ThreadBufferHandle handle;
+        auto generation = bufferGeneration.load(std::memory_order_relaxed);
+        if (!handle.buffer || handle.generation != generation) {
+            // The aggregator drops the old buffer once it has drained it.
+            if (handle.buffer) {
+                handle.buffer->exited = true;
+            }
+            handle.buffer = std::make_shared<ThreadBuffer>(bufferEvents.load(std::memory_order_relaxed));
+            handle.generation = generation;
+            std::lock_guard lock(buffersLock);
+            buffers.push_back(handle.buffer);
+        }
+        return *handle.buffer;
+    }
+
+    void push(const MethodInfo* method, bool leave) {
+        if (!recording.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto* filter = activeFilter.load(std::memory_order_acquire);
+        if (!filter || !filter->Selects(method)) {
+            return;
+        }
+        auto timestamp = il2cpp_utils::ProfilerTimestamp();
+        auto& buffer = currentBuffer();
+        auto head = buffer.head.load(std::memory_order_relaxed);
+        if (head - buffer.tail.load(std::memory_order_acquire) > buffer.mask) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        buffer.events[head & buffer.mask] = {reinterpret_cast<uintptr_t>(method) | (leave ? 1 : 0), timestamp};
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void onEnter(Il2CppProfiler*, const MethodInfo* method) {
+        push(method, false);
+    }
+
+    void onLeave(Il2CppProfiler*, const MethodInfo* method) {
+        push(method, true);
+    }
+
+    void leave(ThreadBuffer& buffer, const MethodInfo* method, uint64_t timestamp) {
+        // Unwind to the matching enter. Frames above it lost their leave (to an exception, or a full buffer), and are discarded.
+        auto itr = std::find_if(buffer.stack.rbegin(), buffer.stack.rend(), [method](auto const& frame) { return frame.method == method; });
+        if (itr == buffer.stack.rend()) {
+            return;
+        }
+        auto depth = buffer.stack.rend() - itr;
+        while (static_cast<std::ptrdiff_t>(buffer.stack.size()) > depth) {
+            buffer.active[buffer.stack.back().method]--;
+            buffer.stack.pop_back();
+        }
+        auto frame = buffer.stack.back();
+        buffer.stack.pop_back();
+        auto inclusive = timestamp - frame.start;
+        auto& total = totals[method];
+        total.calls++;
+        total.exclusive += inclusive - std::min(inclusive, frame.children);
+        // Recursive calls are already part of the outermost call's time.
+        if (--buffer.active[method] == 0) {
+            total.inclusive += inclusive;
+        }
+        if (!buffer.stack.empty()) {
+            buffer.stack.back().children += inclusive;
+        }
+    }
+
+    // Drains every thread's buffer into the totals. Called with aggregateLock held.
+    void drain() {
+        std::vector<std::shared_ptr<ThreadBuffer>> current;
+        {
+            std::lock_guard lock(buffersLock);
+            current = buffers;
+        }
+        for (auto& buffer : current) {
+            auto tail = buffer->tail.load(std::memory_order_relaxed);
+            auto head = buffer->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++) {
+                auto event = buffer->events[tail & buffer->mask];
+                auto* method = reinterpret_cast<const MethodInfo*>(event.methodAndLeave & ~uintptr_t(1));
+                if (event.methodAndLeave & 1) {
+                    leave(*buffer, method, event.timestamp);
+                } else {
+                    buffer->stack.push_back({method, event.timestamp, 0});
+                    buffer->active[method]++;
+                }
+            }
+            buffer->tail.store(tail, std::memory_order_release);
+            // Events were lost after the ones just read, so the open frames can no longer be matched.
+            auto dropped = buffer->dropped.load(std::memory_order_relaxed);
+            if (dropped != buffer->seenDropped) {
+                droppedTotal += dropped - buffer->seenDropped;
+                buffer->seenDropped = dropped;
+                buffer->stack.clear();
+                buffer->active.clear();
+            }
+        }
+        std::lock_guard lock(buffersLock);
+        std::erase_if(buffers, [](auto const& buffer) {
+            return buffer->exited && buffer->tail.load() == buffer->head.load();
+        });
+    }
+
+    void aggregate() {
+        std::unique_lock lock(aggregateLock);
+        while (!aggregatorStopping) {
+            aggregatorWake.wait_for(lock, std::chrono::milliseconds(50));
+            drain();
+        }
+        drain();
+    }
+
+    void stopAggregator() {
+        if (!aggregator.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard lock(aggregateLock);
+            aggregatorStopping = true;
+        }
+        aggregatorWake.notify_one();
+        aggregator.join();
+        aggregatorStopping = false;
+    }
+
+    // ---------------------------------------------------------------- GcTelemetry
+
+    // Allocations are counted in the shard of the allocating thread, so threads rarely share a lock.
+    constexpr std::size_t allocationShardCount = 64;
+
+    struct alignas(64) AllocationShard {
+        std::mutex lock;
+        std::unordered_map<Il2CppClass*, std::pair<uint64_t, uint64_t>> classes;
+        // Read by the GC callback while the world is stopped, so it can not sit behind the lock.
+        std::atomic<uint64_t> bytes = 0;
+    };
+
+    std::array<AllocationShard, allocationShardCount> allocationShards;
+    std::atomic<uint32_t> nextShard = 0;
+
+    // Collections are written by the collecting thread only, and read by copying and then checking nothing was overwritten.
+    struct Timeline {
+        std::unique_ptr<il2cpp_utils::GcEvent[]> events;
+        uint32_t capacity;
+        std::atomic<uint64_t> published = 0;
+
+        explicit Timeline(uint32_t size) : events(std::make_unique<il2cpp_utils::GcEvent[]>(size)), capacity(size) {}
+    };
+
+    // Serializes GcTelemetry::Start and Stop.
+    std::mutex gcTelemetryLock;
+    std::atomic<bool> gcRecording = false;
+    // A GC can still be writing to a timeline when Start replaces it, so replaced timelines are kept alive.
+    std::atomic<Timeline*> activeTimeline = nullptr;
+    std::list<Timeline> timelines;
+    std::array<std::atomic<uint64_t>, il2cpp_utils::GcPauseHistogram::bucketCount> pauseBuckets;
+    std::atomic<int64_t> heapSize = 0;
+
+    // Owned by whichever thread is collecting, the GC serializes collections.
+    uint64_t sessionStart = 0;
+    uint64_t collectionStart = 0;
+    int collectionGeneration = 0;
+    bool inCollection = false;
+    uint64_t worldStopped = 0;
+    uint64_t collectionPause = 0;
+    uint64_t bytesAtLastCollection = 0;
+
+    // Set by Start, a function local static would take a lock on first use.
+    double tickScale = 1;
+
+    uint64_t ticksToNs(uint64_t ticks) {
+        return static_cast<uint64_t>(ticks * tickScale);
+    }
+
+    void recordPause(uint64_t ns) {
+        std::size_t bucket = 0;
+        for (auto us = ns / 1000; us && bucket < pauseBuckets.size() - 1; us >>= 1) {
+            bucket++;
+        }
+        pauseBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t allocatedBytes() {
+        uint64_t total = 0;
+        for (auto& shard : allocationShards) {
+            total += shard.bytes.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void onAllocation(Il2CppProfiler*, Il2CppObject* obj, Il2CppClass* klass) {
+        if (!gcRecording.load(std::memory_order_relaxed)) {
+            return;
+        }
+        thread_local uint32_t shardIndex = nextShard.fetch_add(1, std::memory_order_relaxed) % allocationShardCount;
+        uint64_t size = il2cpp_functions::object_get_size(obj);
+        auto& shard = allocationShards[shardIndex];
+        shard.bytes.fetch_add(size, std::memory_order_relaxed);
+        std::lock_guard lock(shard.lock);
+        auto& [count, bytes] = shard.classes[klass];
+        count++;
+        bytes += size;
+    }
+
+    // Runs on the collecting thread, usually with every other thread stopped (and possibly holding any lock): no locks, no allocations.
+    void onGcEvent(Il2CppProfiler*, Il2CppGCEvent event, int generation) {
+        if (!gcRecording.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto now = il2cpp_utils::ProfilerTimestamp();
+        switch (event) {
+            case IL2CPP_GC_EVENT_START:
+                inCollection = true;
+                collectionStart = now;
+                collectionGeneration = generation;
+                collectionPause = 0;
+                break;
+            case IL2CPP_GC_EVENT_PRE_STOP_WORLD:
+                worldStopped = now;
+                break;
+            case IL2CPP_GC_EVENT_POST_START_WORLD: {
+                if (!worldStopped) {
+                    break;
+                }
+                auto pause = now - worldStopped;
+                worldStopped = 0;
+                recordPause(ticksToNs(pause));
+                if (inCollection) {
+                    collectionPause += pause;
+                }
+                break;
+            }
+            case IL2CPP_GC_EVENT_END: {
+                if (!inCollection) {
+                    break;
+                }
+                inCollection = false;
+                auto duration = ticksToNs(now - collectionStart);
+                if (!collectionPause) {
+                    recordPause(duration);
+                }
+                auto allocated = allocatedBytes();
+                auto* timeline = activeTimeline.load(std::memory_order_acquire);
+                if (timeline) {
+                    auto index = timeline->published.load(std::memory_order_relaxed);
+                    timeline->events[index % timeline->capacity] = {
+                        ticksToNs(collectionStart - sessionStart), duration, ticksToNs(collectionPause), collectionGeneration,
+                        heapSize.load(std::memory_order_relaxed), allocated - std::min(allocated, bytesAtLastCollection)
+                    };
+                    timeline->published.store(index + 1, std::memory_order_release);
+                }
+                bytesAtLastCollection = allocated;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void onHeapResize(Il2CppProfiler*, int64_t newSize) {
+        heapSize.store(newSize, std::memory_order_relaxed);
+    }
+}
+
+namespace il2cpp_utils {
+    void EnableProfilerEvents(Il2CppProfileFlags events) noexcept {
+        il2cpp_functions::Init();
+        std::lock_guard lock(profilerLock);
+        if (!profilerInstalled) {
+            il2cpp_functions::profiler_install(reinterpret_cast<Il2CppProfiler*>(&profilerStorage), nullptr);
+            profilerInstalled = true;
+        }
+        enabledEvents |= events;
+        il2cpp_functions::profiler_set_events(static_cast<Il2CppProfileFlags>(enabledEvents));
+    }
+
+    void DisableProfilerEvents(Il2CppProfileFlags events) noexcept {
+        std::lock_guard lock(profilerLock);
+        if (!profilerInstalled) {
+            return;
+        }
+        enabledEvents &= ~events;
+        il2cpp_functions::profiler_set_events(static_cast<Il2CppProfileFlags>(enabledEvents));
+    }
+
+    MethodProfilerFilter& MethodProfilerFilter::AddClass(std::string_view nameSpace, std::string_view className) {
+        if (auto* klass = GetClassFromName(nameSpace, className)) {
+            classes.push_back(klass);
+        }
+        return *this;
+    }
+
+    MethodProfilerFilter& MethodProfilerFilter::AddAssembly(std::string_view assemblyName) {
+        il2cpp_functions::Init();
+        static auto logger = getLogger().WithContext("MethodProfilerFilter");
+        size_t count;
+        auto** assemblies = il2cpp_functions::domain_get_assemblies(il2cpp_functions::domain_get(), &count);
+        for (size_t i = 0; i < count; i++) {
+            if (assemblies[i] && assemblies[i]->aname.name == assemblyName) {
+                images.push_back(il2cpp_functions::assembly_get_image(assemblies[i]));
+                return *this;
+            }
+        }
+        logger.error("Could not find assembly: %.*s", static_cast<int>(assemblyName.size()), assemblyName.data());
+        return *this;
+    }
+
+    bool MethodProfiler::Start(MethodProfilerFilter filter, uint32_t bufferSize) noexcept {
+        il2cpp_functions::Init();
+        static auto logger = getLogger().WithContext("MethodProfiler");
+        if (!il2cpp_functions::il2cpp_profiler_install || !il2cpp_functions::il2cpp_profiler_set_events || !il2cpp_functions::il2cpp_profiler_install_enter_leave) {
+            logger.error("The il2cpp profiler API is not available!");
+            return false;
+        }
+        std::lock_guard control(methodProfilerLock);
+        recording = false;
+        stopAggregator();
+        {
+            std::lock_guard lock(aggregateLock);
+            // Discard what the previous session left behind.
+            drain();
+            totals.clear();
+            droppedTotal = 0;
+            std::lock_guard buffersGuard(buffersLock);
+            for (auto& buffer : buffers) {
+                buffer->stack.clear();
+                buffer->active.clear();
+            }
+        }
+        auto& created = filters.emplace_back();
+        created.classes.insert(filter.classes.begin(), filter.classes.end());
+        created.images.insert(filter.images.begin(), filter.images.end());
+        activeFilter.store(&created, std::memory_order_release);
+        bufferSize = std::max<uint32_t>(bufferSize, 2);
+        if (bufferEvents.exchange(bufferSize) != bufferSize) {
+            bufferGeneration.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static bool callbacksInstalled = false;
+        EnableProfilerEvents(IL2CPP_PROFILE_ENTER_LEAVE);
+        if (!callbacksInstalled) {
+            // The callbacks stay installed for good, and return immediately while not recording.
+            il2cpp_functions::profiler_install_enter_leave(onEnter, onLeave);
+            callbacksInstalled = true;
+        }
+        static bool exitHandlerRegistered = false;
+        if (!exitHandlerRegistered) {
+            // A joinable aggregator would make exit terminate the process, when Stop was never called.
+            std::atexit([] {
+                std::lock_guard control(methodProfilerLock);
+                recording = false;
+                stopAggregator();
+            });
+            exitHandlerRegistered = true;
+        }
+        aggregator = std::thread(aggregate);
+        recording = true;
+        logger.info("Recording %s", filter.classes.empty() && filter.images.empty() ? "every method" :
+            string_format("methods of %zu classes and %zu images", created.classes.size(), created.images.size()).c_str());
+        return true;
+    }
+
+    void MethodProfiler::Stop() noexcept {
+        std::lock_guard control(methodProfilerLock);
+        if (!recording.exchange(false)) {
+            return;
+        }
+        DisableProfilerEvents(IL2CPP_PROFILE_ENTER_LEAVE);
+        stopAggregator();
+    }
+
+    bool MethodProfiler::IsRunning() noexcept {
+        return recording;
+    }
+
+    std::vector<MethodProfile> MethodProfiler::Collect() noexcept {
+        std::vector<MethodProfile> profiles;
+        {
+            std::lock_guard lock(aggregateLock);
+            drain();
+            profiles.reserve(totals.size());
+            double scale = 1e9 / ProfilerTimestampFrequency();
+            for (auto const& [method, total] : totals) {
+                profiles.push_back({method, total.calls, static_cast<uint64_t>(total.inclusive * scale), static_cast<uint64_t>(total.exclusive * scale)});
+            }
+        }
+        std::sort(profiles.begin(), profiles.end(), [](auto const& a, auto const& b) { return a.exclusiveNs > b.exclusiveNs; });
+        return profiles;
+    }
+
+    uint64_t MethodProfiler::DroppedEvents() noexcept {
+        std::lock_guard lock(aggregateLock);
+        return droppedTotal;
+    }
+
+    void MethodProfiler::Log(LoggerContextObject& logger, std::size_t count) noexcept {
+        auto profiles = Collect();
+        logger.info("%zu methods recorded, %lu events dropped", profiles.size(), static_cast<unsigned long>(DroppedEvents()));
+        logger.info("%12s %14s %14s %12s  %s", "calls", "exclusive(us)", "inclusive(us)", "avg(ns)", "method");
+        for (std::size_t i = 0; i < std::min(count, profiles.size()); i++) {
+            auto const& profile = profiles[i];
+            logger.info("%12lu %14.1f %14.1f %12lu  %s", static_cast<unsigned long>(profile.calls), profile.exclusiveNs / 1000.0, profile.inclusiveNs / 1000.0,
+                static_cast<unsigned long>(profile.calls ? profile.inclusiveNs / profile.calls : 0), MethodStandardName(profile.method).c_str());
+        }
+    }
+
+    bool GcTelemetry::Start(uint32_t timelineSize) noexcept {
+        il2cpp_functions::Init();
+        static auto logger = getLogger().WithContext("GcTelemetry");
+        if (!il2cpp_functions::il2cpp_profiler_install || !il2cpp_functions::il2cpp_profiler_set_events ||
+            !il2cpp_functions::il2cpp_profiler_install_allocation || !il2cpp_functions::il2cpp_profiler_install_gc) {
+            logger.error("The il2cpp profiler API is not available!");
+            return false;
+        }
+        std::lock_guard control(gcTelemetryLock);
+        gcRecording = false;
+        for (auto& shard : allocationShards) {
+            std::lock_guard lock(shard.lock);
+            shard.classes.clear();
+            shard.bytes = 0;
+        }
+        for (auto& bucket : pauseBuckets) {
+            bucket = 0;
+        }
+        activeTimeline.store(&timelines.emplace_back(std::max<uint32_t>(timelineSize, 1)), std::memory_order_release);
+        tickScale = 1e9 / ProfilerTimestampFrequency();
+        sessionStart = ProfilerTimestamp();
+        inCollection = false;
+        worldStopped = 0;
+        bytesAtLastCollection = 0;
+        heapSize = il2cpp_functions::gc_get_heap_size();
+
+        static bool callbacksInstalled = false;
+        EnableProfilerEvents(static_cast<Il2CppProfileFlags>(IL2CPP_PROFILE_ALLOCATIONS | IL2CPP_PROFILE_GC));
+        if (!callbacksInstalled) {
+            il2cpp_functions::profiler_install_allocation(onAllocation);
+            il2cpp_functions::profiler_install_gc(onGcEvent, onHeapResize);
+            callbacksInstalled = true;
+        }
+        gcRecording = true;
+        logger.info("Recording allocations and collections, keeping the last %u collections", std::max<uint32_t>(timelineSize, 1));
+        return true;
+    }
+
+    void GcTelemetry::Stop() noexcept {
+        std::lock_guard control(gcTelemetryLock);
+        if (!gcRecording.exchange(false)) {
+            return;
+        }
+        DisableProfilerEvents(static_cast<Il2CppProfileFlags>(IL2CPP_PROFILE_ALLOCATIONS | IL2CPP_PROFILE_GC));
+    }
+
+    bool GcTelemetry::IsRunning() noexcept {
+        return gcRecording;
+    }
+
+    std::vector<AllocationStats> GcTelemetry::TopAllocators(std::size_t count, bool byBytes) noexcept {
+        std::unordered_map<Il2CppClass*, std::pair<uint64_t, uint64_t>> merged;
+        for (auto& shard : allocationShards) {
+            std::lock_guard lock(shard.lock);
+            for (auto const& [klass, stats] : shard.classes) {
+                auto& total = merged[klass];
+                total.first += stats.first;
+                total.second += stats.second;
+            }
+        }
+        std::vector<AllocationStats> allocators;
+        allocators.reserve(merged.size());
+        for (auto const& [klass, stats] : merged) {
+            allocators.push_back({klass, stats.first, stats.second});
+        }
+        auto key = [byBytes](auto const& stats) { return byBytes ? stats.bytes : stats.count; };
+        count = std::min(count, allocators.size());
+        std::partial_sort(allocators.begin(), allocators.begin() + count, allocators.end(), [&key](auto const& a, auto const& b) { return key(a) > key(b); });
+        allocators.resize(count);
+        return allocators;
+    }
+
+    std::vector<GcEvent> GcTelemetry::Timeline() noexcept {
+        auto* timeline = activeTimeline.load(std::memory_order_acquire);
+        if (!timeline) {
+            return {};
+        }
+        auto published = timeline->published.load(std::memory_order_acquire);
+        auto first = published - std::min<uint64_t>(published, timeline->capacity);
+        std::vector<GcEvent> events;
+        events.reserve(published - first);
+        for (auto i = first; i < published; i++) {
+            events.push_back(timeline->events[i % timeline->capacity]);
+        }
+        // Entries a collection overwrote while they were being copied are torn, so drop them.
+        auto after = timeline->published.load(std::memory_order_acquire);
+        if (after - first > timeline->capacity) {
+            auto torn = std::min<uint64_t>(after - first - timeline->capacity, events.size());
+            events.erase(events.begin(), events.begin() + torn);
+        }
+        return events;
+    }
+
+    GcPauseHistogram GcTelemetry::PauseHistogram() noexcept {
+        GcPauseHistogram histogram;
+        for (std::size_t i = 0; i < pauseBuckets.size(); i++) {
+            histogram.counts[i] = pauseBuckets[i].load(std::memory_order_relaxed);
+        }
+        return histogram;
+    }
+
+    void GcTelemetry::Log(LoggerContextObject& logger, std::size_t count) noexcept {
+        auto allocators = TopAllocators(count);
+        logger.info("%lu bytes allocated", static_cast<unsigned long>(allocatedBytes()));
+        logger.info("%12s %14s  %s", "count", "bytes", "class");
+        for (auto const& stats : allocators) {
+            logger.info("%12lu %14lu  %s", static_cast<unsigned long>(stats.count), static_cast<unsigned long>(stats.bytes), ClassStandardName(stats.klass).c_str());
+        }
+        auto histogram = PauseHistogram();
+        logger.info("GC pauses:");
+        for (std::size_t i = 0; i < histogram.counts.size(); i++) {
+            if (histogram.counts[i]) {
+                logger.info("  < %10lu us: %lu", static_cast<unsigned long>(GcPauseHistogram::UpperBoundUs(i)), static_cast<unsigned long>(histogram.counts[i]));
+            }
+        }
+        auto timeline = Timeline();
+        logger.info("%zu collections kept, most recent:", timeline.size());
+        logger.info("%12s %12s %12s %4s %14s %14s", "start(ms)", "duration(us)", "pause(us)", "gen", "heap", "allocated");
+        for (auto i = timeline.size() - std::min(count, timeline.size()); i < timeline.size(); i++) {
+            auto const& event = timeline[i];
+            logger.info("%12.3f %12.1f %12.1f %4d %14ld %14lu", event.startNs / 1e6, event.durationNs / 1000.0, event.pauseNs / 1000.0, event.generation,
+                static_cast<long>(event.heapSize), static_cast<unsigned long>(event.allocatedBytes));
+        }
+    }
+}
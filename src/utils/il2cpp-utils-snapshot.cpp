@@ -0,0 +1,208 @@
+#include "../../shared/utils/il2cpp-utils-snapshot.hpp"
+#include "../../shared/utils/il2cpp-utils.hpp"
+#include "../../shared/utils/gc-alloc.hpp"
+#include "../../shared/utils/utils-functions.h"
+#include "../../shared/config/config-utils.hpp"
+#include "modloader/shared/modloader.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace il2cpp_utils::snapshot_format;
+
+namespace {
+    // The writer thread is detached, and reports finishing through writing and writerDone, so that no joinable thread is left for exit to terminate on.
+    std::mutex writerLock;
+    std::condition_variable writerDone;
+    std::atomic<bool> writing = false;
+    bool lastSucceeded = true;
+
+    // Buffered writes straight from the captured snapshot, nothing is assembled in memory first.
+    struct SnapshotWriter {
+        std::ofstream out;
+        std::unique_ptr<char[]> buffer;
+
+        explicit SnapshotWriter(std::string const& path) : buffer(std::make_unique<char[]>(1 << 20)) {
+            out.rdbuf()->pubsetbuf(buffer.get(), 1 << 20);
+            out.open(path, std::ios::binary | std::ios::trunc);
+        }
+
+        template<class T>
+        void value(T const& value) {
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void bytes(const void* data, std::size_t size) {
+            if (size) {
+                out.write(static_cast<const char*>(data), size);
+            }
+        }
+
+        void string(const char* str) {
+            uint32_t length = str ? strlen(str) : 0;
+            value(length);
+            bytes(str, length);
+        }
+
+        void string(std::string const& str) {
+            value(static_cast<uint32_t>(str.size()));
+            bytes(str.data(), str.size());
+        }
+
+        void sections(SnapshotRecord tag, uint32_t count, const Il2CppManagedMemorySection* sections) {
+            for (uint32_t i = 0; i < count; i++) {
+                value(tag);
+                value(sections[i].sectionStartAddress);
+                value(sections[i].sectionSize);
+                bytes(sections[i].sectionBytes, sections[i].sectionSize);
+            }
+        }
+    };
+
+    std::string describeOwner(const void* site) {
+        return site ? backtrace_helpers::describeFrame(site) : "<unknown>";
+    }
+
+    bool write(SnapshotWriter& w, const Il2CppManagedMemorySnapshot& snapshot, std::vector<gc_accounting::FixedAllocation> const& fixed) {
+        auto const& runtime = snapshot.runtimeInformation;
+        w.value(SnapshotHeader{magic, version, runtime.pointerSize, runtime.objectHeaderSize, runtime.arrayHeaderSize,
+            runtime.arrayBoundsOffsetInHeader, runtime.arraySizeOffsetInHeader, runtime.allocationGranularity});
+
+        for (uint32_t i = 0; i < snapshot.metadata.typeCount; i++) {
+            auto const& type = snapshot.metadata.types[i];
+            w.value(SnapshotRecord::Type);
+            w.value(i);
+            w.value(static_cast<uint32_t>(type.flags));
+            w.value(type.baseOrElementTypeIndex);
+            w.value(type.size);
+            w.value(type.typeInfoAddress);
+            w.string(type.name);
+            w.string(type.assemblyName);
+            w.value(type.fieldCount);
+            for (uint32_t f = 0; f < type.fieldCount; f++) {
+                auto const& field = type.fields[f];
+                w.value(field.offset);
+                w.value(field.typeIndex);
+                w.value(static_cast<uint8_t>(field.isStatic));
+                w.string(field.name);
+            }
+            w.value(type.staticsSize);
+            w.bytes(type.statics, type.staticsSize);
+        }
+        w.sections(SnapshotRecord::HeapSection, snapshot.heap.sectionCount, snapshot.heap.sections);
+        w.sections(SnapshotRecord::StackSection, snapshot.stacks.stackCount, snapshot.stacks.stacks);
+
+        w.value(SnapshotRecord::GcHandles);
+        w.value(snapshot.gcHandles.trackedObjectCount);
+        w.bytes(snapshot.gcHandles.pointersToObjects, snapshot.gcHandles.trackedObjectCount * sizeof(uint64_t));
+
+        // Owners are symbolized once per site, there are usually far fewer sites than allocations.
+        std::unordered_map<const void*, std::string> owners;
+        for (auto const& allocation : fixed) {
+            auto [itr, inserted] = owners.try_emplace(allocation.site);
+            if (inserted) {
+                itr->second = describeOwner(allocation.site);
+            }
+            w.value(SnapshotRecord::FixedAllocation);
+            w.value(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(allocation.ptr)));
+            w.value(static_cast<uint64_t>(allocation.size));
+            w.string(itr->second);
+        }
+        w.value(SnapshotRecord::End);
+        w.out.close();
+        return !w.out.fail();
+    }
+
+    void waitForWriter(std::unique_lock<std::mutex>& lock) {
+        writerDone.wait(lock, [] { return !writing; });
+    }
+
+    // A snapshot still being written when the process exits normally is finished first.
+    void waitAtExit() {
+        std::unique_lock lock(writerLock);
+        waitForWriter(lock);
+    }
+}
+
+namespace il2cpp_utils {
+    bool MemorySnapshot::Capture(std::string_view outputPath) noexcept {
+        il2cpp_functions::Init();
+        static auto logger = getLogger().WithContext("MemorySnapshot");
+        if (!il2cpp_functions::il2cpp_capture_memory_snapshot || !il2cpp_functions::il2cpp_free_captured_memory_snapshot) {
+            logger.error("il2cpp_capture_memory_snapshot is not available!");
+            return false;
+        }
+        std::unique_lock lock(writerLock);
+        waitForWriter(lock);
+        std::string path(outputPath);
+        auto w = std::make_unique<SnapshotWriter>(path);
+        if (!w->out) {
+            logger.error("Could not open %s for writing!", path.c_str());
+            return false;
+        }
+        auto fixed = gc_accounting::GetLiveFixedAllocations();
+        auto start = std::chrono::steady_clock::now();
+        auto* snapshot = il2cpp_functions::capture_memory_snapshot();
+        if (!snapshot) {
+            logger.error("il2cpp_capture_memory_snapshot failed!");
+            return false;
+        }
+        auto captured = std::chrono::steady_clock::now();
+        uint64_t heapBytes = 0;
+        for (uint32_t i = 0; i < snapshot->heap.sectionCount; i++) {
+            heapBytes += snapshot->heap.sections[i].sectionSize;
+        }
+        logger.info("Captured %lu bytes in %u heap sections, %u types and %u GC handles in %lldms, writing to %s",
+            static_cast<unsigned long>(heapBytes), snapshot->heap.sectionCount, snapshot->metadata.typeCount, snapshot->gcHandles.trackedObjectCount,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(captured - start).count()), path.c_str());
+        static bool exitHandlerRegistered = false;
+        if (!exitHandlerRegistered) {
+            std::atexit(waitAtExit);
+            exitHandlerRegistered = true;
+        }
+        writing = true;
+        std::thread([w = std::move(w), snapshot, fixed = std::move(fixed), path = std::move(path)]() {
+            auto writeStart = std::chrono::steady_clock::now();
+            auto succeeded = write(*w, *snapshot, fixed);
+            il2cpp_functions::free_captured_memory_snapshot(snapshot);
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - writeStart).count();
+            if (succeeded) {
+                logger.info("Wrote %s in %lldms", path.c_str(), static_cast<long long>(elapsed));
+            } else {
+                logger.error("Failed writing %s: %s", path.c_str(), strerror(errno));
+            }
+            {
+                std::lock_guard lock(writerLock);
+                lastSucceeded = succeeded;
+                writing = false;
+            }
+            writerDone.notify_all();
+        }).detach();
+        return true;
+    }
+
+    std::string MemorySnapshot::Capture(const ModInfo& info) noexcept {
+        auto path = getDataFilePath(info, "snapshot", "bhms");
+        return Capture(path) ? path : std::string();
+    }
+
+    bool MemorySnapshot::IsWriting() noexcept {
+        return writing;
+    }
+
+    bool MemorySnapshot::Wait() noexcept {
+        std::unique_lock lock(writerLock);
+        waitForWriter(lock);
+        return lastSucceeded;
+    }
+}
@@ -7,6 +7,7 @@
 #include "../../shared/utils/il2cpp-functions.hpp"
 #include <algorithm>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 #include <unordered_set>
 #include <sstream>
@@ -233,7 +234,52 @@ namespace il2cpp_utils {
         return ss.str();
     }
 
+    // A free instance sitting in a ManualPool. Overlays the Il2CppObject header of the pooled instance, so pooling allocates nothing.
+    struct PooledObject {
+        Il2CppClass* klass;
+        PooledObject* next;
+    };
+    static_assert(sizeof(PooledObject) <= sizeof(Il2CppObject));
+
+    struct ManualPool {
+        PooledObject* head = nullptr;
+        std::size_t count = 0;
+        std::size_t capacity = 256;
+        void (*resetHook)(Il2CppObject*) = nullptr;
+    };
+
+    static std::unordered_map<const Il2CppClass*, ManualPool> manualPools;
+    static std::mutex poolLock;
+
+    // Pops a free instance of klass and resets it, or returns nullptr if there is none.
+    static Il2CppObject* popPooled(const Il2CppClass* klass) noexcept {
+        void (*resetHook)(Il2CppObject*);
+        PooledObject* node;
+        {
+            std::scoped_lock lock(poolLock);
+            auto itr = manualPools.find(klass);
+            if (itr == manualPools.end() || !itr->second.head) {
+                return nullptr;
+            }
+            node = itr->second.head;
+            itr->second.head = node->next;
+            itr->second.count--;
+            resetHook = itr->second.resetHook;
+        }
+        // The rest was zeroed by ReturnToPool, only the link overlaying the monitor is left.
+        node->next = nullptr;
+        auto* obj = reinterpret_cast<Il2CppObject*>(node);
+        if (resetHook) {
+            resetHook(obj);
+        }
+        return obj;
+    }
+
     Il2CppObject* createManual(const Il2CppClass* klass) noexcept {
+        return createManualFrom(klass, __builtin_return_address(0));
+    }
+
+    Il2CppObject* createManualFrom(const Il2CppClass* klass, const void* site) noexcept {
         static auto logger = getLogger().WithContext("createManual");
         if (!klass) {
             logger.error("Cannot create a manual object on a null class!");
@@ -243,7 +289,11 @@ namespace il2cpp_utils {
             logger.error("Cannot create an object that does not have an initialized class: %p", klass);
             return nullptr;
         }
-        auto* obj = reinterpret_cast<Il2CppObject*>(gc_alloc_specific(klass->instance_size));
+        // A pooled instance has already been through the .cctor handling below, no need to do it again.
+        if (auto* pooled = popPooled(klass)) {
+            return pooled;
+        }
+        auto* obj = reinterpret_cast<Il2CppObject*>(gc_alloc_specific_from(klass->instance_size, site));
         if (!obj) {
             logger.error("Failed to allocate GC specific area for instance size: %u", klass->instance_size);
             return nullptr;
@@ -260,10 +310,17 @@ namespace il2cpp_utils {
     }
 
     Il2CppObject* createManualThrow(Il2CppClass* const klass) {
+        return createManualThrowFrom(klass, __builtin_return_address(0));
+    }
+
+    Il2CppObject* createManualThrowFrom(Il2CppClass* const klass, const void* site) {
         if (!klass->initialized) {
             throw exceptions::StackTraceException(string_format("Cannot create an object that does not have an initialized class: %p", klass));
         }
-        auto* obj = reinterpret_cast<Il2CppObject*>(gc_alloc_specific(klass->instance_size));
+        if (auto* pooled = popPooled(klass)) {
+            return pooled;
+        }
+        auto* obj = reinterpret_cast<Il2CppObject*>(gc_alloc_specific_from(klass->instance_size, site));
         if (!obj) {
             throw exceptions::StackTraceException(string_format("Failed to allocate GC specific area for instance size: %u", klass->instance_size));
         }
@@ -283,6 +340,81 @@ namespace il2cpp_utils {
         return obj;
     }
 
+    void ReturnToPool(Il2CppObject* obj) noexcept {
+        static auto logger = getLogger().WithContext("ReturnToPool");
+        if (!obj) {
+            return;
+        }
+        if (!obj->klass) {
+            logger.error("Cannot pool an object without a class: %p", obj);
+            return;
+        }
+        // Zero everything (including the monitor) but the klass pointer now, not when the instance is reused:
+        // a parked instance is scanned by the GC, and would otherwise keep everything it referenced alive.
+        memset(reinterpret_cast<uint8_t*>(obj) + sizeof(Il2CppClass*), 0, obj->klass->instance_size - sizeof(Il2CppClass*));
+        {
+            std::scoped_lock lock(poolLock);
+            auto& pool = manualPools[obj->klass];
+            if (pool.count < pool.capacity) {
+                auto* node = reinterpret_cast<PooledObject*>(obj);
+                node->next = pool.head;
+                pool.head = node;
+                pool.count++;
+                return;
+            }
+        }
+        gc_free_specific(obj);
+    }
+
+    void SetPoolResetHook(const Il2CppClass* klass, void (*resetHook)(Il2CppObject*)) noexcept {
+        std::scoped_lock lock(poolLock);
+        manualPools[klass].resetHook = resetHook;
+    }
+
+    void SetPoolCapacity(const Il2CppClass* klass, std::size_t capacity) noexcept {
+        PooledObject* excess = nullptr;
+        {
+            std::scoped_lock lock(poolLock);
+            auto& pool = manualPools[klass];
+            pool.capacity = capacity;
+            while (pool.count > capacity) {
+                auto* node = pool.head;
+                pool.head = node->next;
+                pool.count--;
+                node->next = excess;
+                excess = node;
+            }
+        }
+        // Free outside of the lock, GC_free may take the GC lock.
+        while (excess) {
+            auto* next = excess->next;
+            gc_free_specific(excess);
+            excess = next;
+        }
+    }
+
+    void ClearPools() noexcept {
+        PooledObject* freed = nullptr;
+        {
+            std::scoped_lock lock(poolLock);
+            for (auto& pair : manualPools) {
+                auto& pool = pair.second;
+                while (pool.head) {
+                    auto* node = pool.head;
+                    pool.head = node->next;
+                    node->next = freed;
+                    freed = node;
+                }
+                pool.count = 0;
+            }
+        }
+        while (freed) {
+            auto* next = freed->next;
+            gc_free_specific(freed);
+            freed = next;
+        }
+    }
+
     void* __AllocateUnsafe(std::size_t size) {
         il2cpp_functions::Init();
         // Because we want to allocate this object using C# GC, we will do a bit of a hack here.
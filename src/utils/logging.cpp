@@ -214,23 +214,15 @@ void Logger::Backtrace(uint16_t frameCount) {
     debug("Printing backtrace with: %u max lines:", frameCount);
     log(Logging::DEBUG, "*** *** *** *** *** *** *** *** *** *** *** *** *** *** *** ***");
     debug("pid: %i, tid: %i", getpid(), gettid());
+    backtrace_helpers::FrameSymbol symbol;
     for (uint16_t i = 0; i < frameCount; ++i) {
-        Dl_info info;
-        if (dladdr(buffer[i], &info)) {
+        if (backtrace_helpers::symbolizeFrame(buffer[i], symbol)) {
             // Buffer points to 1 instruction ahead
-            long addr = reinterpret_cast<char*>(buffer[i]) - reinterpret_cast<char*>(info.dli_fbase) - 4;
-            if (info.dli_sname) {
-                int status;
-                const char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
-                if (status) {
-                    demangled = info.dli_sname;
-                }
-                debug("        #%02i  pc %016lx  %s (%s)", i, addr, info.dli_fname, demangled);
-                if (!status) {
-                    free(const_cast<char*>(demangled));
-                }
+            long addr = symbol.offset - 4;
+            if (!symbol.symbol.empty()) {
+                debug("        #%02i  pc %016lx  %s (%s)", i, addr, symbol.library, symbol.symbol.c_str());
             } else {
-                debug("        #%02i  pc %016lx  %s", i, addr, info.dli_fname);
+                debug("        #%02i  pc %016lx  %s", i, addr, symbol.library);
             }
         }
     }
@@ -244,23 +236,15 @@ void LoggerContextObject::Backtrace(uint16_t frameCount) {
     debug("Printing backtrace with: %u max lines:", frameCount);
     log(Logging::DEBUG, "*** *** *** *** *** *** *** *** *** *** *** *** *** *** *** ***");
     debug("pid: %i, tid: %i", getpid(), gettid());
+    backtrace_helpers::FrameSymbol symbol;
     for (uint16_t i = 0; i < frameCount; ++i) {
-        Dl_info info;
-        if (dladdr(buffer[i], &info)) {
+        if (backtrace_helpers::symbolizeFrame(buffer[i], symbol)) {
             // Buffer points to 1 instruction ahead
-            long addr = reinterpret_cast<char*>(buffer[i]) - reinterpret_cast<char*>(info.dli_fbase) - 4;
-            if (info.dli_sname) {
-                int status;
-                const char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
-                if (status) {
-                    demangled = info.dli_sname;
-                }
-                debug("        #%02i  pc %016lx  %s (%s)", i, addr, info.dli_fname, demangled);
-                if (!status) {
-                    free(const_cast<char*>(demangled));
-                }
+            long addr = symbol.offset - 4;
+            if (!symbol.symbol.empty()) {
+                debug("        #%02i  pc %016lx  %s (%s)", i, addr, symbol.library, symbol.symbol.c_str());
             } else {
-                debug("        #%02i  pc %016lx  %s", i, addr, info.dli_fname);
+                debug("        #%02i  pc %016lx  %s", i, addr, symbol.library);
             }
         }
     }
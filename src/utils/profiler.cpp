@@ -0,0 +1,427 @@
+#include "../../shared/utils/profiler.hpp"
+#include "../../shared/utils/logging.hpp"
+#include "../../shared/utils/utils-functions.h"
+#include "../../shared/config/config-utils.hpp"
+#include "modloader/shared/modloader.hpp"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    // One sample in the ring. The ring is a bounded MPSC queue (Vyukov style): a producer owns a slot once it has moved
+    // enqueuePos past it, and publishes it by setting sequence to its position + 1. The consumer frees it by setting sequence to
+    // its position + ring size. Everything the signal handler touches is preallocated and lock-free.
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        pid_t tid;
+        uint16_t depth;
+    };
+
+    struct StackHash {
+        std::size_t operator()(std::vector<uintptr_t> const& stack) const noexcept {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (auto value : stack) {
+                hash = (hash ^ value) * 0x100000001b3ull;
+            }
+            return hash;
+        }
+    };
+
+    struct Session {
+        SamplingProfilerOptions options;
+        std::string outputPath;
+        uint64_t mask;
+        std::unique_ptr<Slot[]> slots;
+        std::unique_ptr<uintptr_t[]> frames;
+        std::atomic<uint64_t> enqueuePos = 0;
+        uint64_t dequeuePos = 0;
+        std::atomic<uint64_t> samples = 0;
+        std::atomic<uint64_t> dropped = 0;
+
+        timer_t timer;
+        struct sigaction previous;
+
+        std::thread aggregator;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+        // Keyed by the tid, followed by the frames from the innermost outwards.
+        std::unordered_map<std::vector<uintptr_t>, uint64_t, StackHash> stacks;
+        std::unordered_map<pid_t, std::string> threadNames;
+    };
+
+    // Stack bounds of the threads registered through SamplingProfiler::RegisterThread, looked up by the signal handler.
+    // Open addressing by tid, entries are never removed: a tid reused by a new thread is rejected unless its stack pointer is within the bounds.
+    constexpr std::size_t threadStackSlots = 1024;
+    struct ThreadStack {
+        std::atomic<pid_t> tid = 0;
+        std::atomic<uintptr_t> low = 0;
+        std::atomic<uintptr_t> high = 0;
+    };
+    ThreadStack threadStacks[threadStackSlots];
+    // Without registered bounds, only the rest of the page holding the stack pointer is known to be mapped.
+    constexpr uintptr_t unregisteredWalkAlign = 4096;
+
+    // Returns the end of the stack sp is on, or 0 if the thread is not registered (or sp is not within its registered stack).
+    uintptr_t stackEnd(pid_t tid, uintptr_t sp) {
+        auto idx = static_cast<std::size_t>(tid) % threadStackSlots;
+        for (std::size_t i = 0; i < threadStackSlots; i++) {
+            auto& entry = threadStacks[(idx + i) % threadStackSlots];
+            auto entryTid = entry.tid.load(std::memory_order_acquire);
+            if (entryTid == 0) {
+                return 0;
+            }
+            if (entryTid == tid) {
+                auto low = entry.low.load(std::memory_order_acquire);
+                auto high = entry.high.load(std::memory_order_acquire);
+                return sp >= low && sp < high ? high : 0;
+            }
+        }
+        return 0;
+    }
+
+    std::mutex controlMutex;
+    std::unique_ptr<Session> session;
+    SamplingProfilerStats lastStats{};
+    // What the signal handler samples into, and how many handlers are using it, so that Stop can wait for them before freeing it.
+    std::atomic<Session*> active = nullptr;
+    std::atomic<int> handlersRunning = 0;
+
+    LoggerContextObject& getLogger() {
+        static auto logger = Logger::get().WithContext("SamplingProfiler");
+        return logger;
+    }
+
+    void record(Session& s, uintptr_t pc, uintptr_t fp, uintptr_t sp) {
+        uint64_t pos = s.enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &s.slots[pos & s.mask];
+            auto diff = static_cast<int64_t>(slot->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (s.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                s.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = s.enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        uintptr_t* frames = &s.frames[(pos & s.mask) * s.options.maxDepth];
+        uint16_t depth = 0;
+        frames[depth++] = pc;
+        auto tid = gettid();
+        // Frame records are {previous fp, return address}, and live higher up the stack with every caller.
+        // Code built without frame pointers leaves anything in x29/rbp, so a record is only read if it is within the thread's stack.
+        uintptr_t end = stackEnd(tid, sp);
+        if (!end) {
+            end = (sp | (unregisteredWalkAlign - 1)) + 1;
+        }
+        uintptr_t limit = std::min<uintptr_t>(end, sp + s.options.maxStackBytes);
+        while (depth < s.options.maxDepth && fp >= sp && fp + 2 * sizeof(uintptr_t) <= limit && (fp & (sizeof(uintptr_t) - 1)) == 0) {
+            auto* record = reinterpret_cast<uintptr_t*>(fp);
+            uintptr_t next = record[0];
+            uintptr_t ret = record[1];
+#ifdef __aarch64__
+            // Strip pointer authentication bits from signed return addresses.
+            ret &= 0x0000ffffffffffffull;
+#endif
+            if (ret == 0) {
+                break;
+            }
+            frames[depth++] = ret;
+            // Callers are strictly higher up the stack, anything else is not a frame record.
+            if (next <= fp) {
+                break;
+            }
+            fp = next;
+        }
+        slot->tid = tid;
+        slot->depth = depth;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        s.samples.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onSample(int, siginfo_t*, void* context) {
+        handlersRunning.fetch_add(1);
+        auto* s = active.load();
+        if (s) {
+            int savedErrno = errno;
+            auto& mcontext = static_cast<ucontext_t*>(context)->uc_mcontext;
+#if defined(__aarch64__)
+            record(*s, mcontext.pc, mcontext.regs[29], mcontext.sp);
+#elif defined(__x86_64__)
+            record(*s, mcontext.gregs[REG_RIP], mcontext.gregs[REG_RBP], mcontext.gregs[REG_RSP]);
+#endif
+            errno = savedErrno;
+        }
+        handlersRunning.fetch_sub(1);
+    }
+
+    std::string threadName(pid_t tid) {
+        std::ifstream comm(string_format("/proc/self/task/%d/comm", tid));
+        std::string name;
+        if (!std::getline(comm, name) || name.empty()) {
+            name = string_format("thread-%d", tid);
+        }
+        return name;
+    }
+
+    // Moves everything published in the ring into the aggregated stacks. Called with the session mutex held.
+    void drain(Session& s) {
+        std::vector<uintptr_t> key;
+        while (true) {
+            auto& slot = s.slots[s.dequeuePos & s.mask];
+            if (slot.sequence.load(std::memory_order_acquire) != s.dequeuePos + 1) {
+                return;
+            }
+            uintptr_t* frames = &s.frames[(s.dequeuePos & s.mask) * s.options.maxDepth];
+            key.assign(1, static_cast<uintptr_t>(slot.tid));
+            key.insert(key.end(), frames, frames + slot.depth);
+            s.stacks[key]++;
+            // Threads can exit before the session is written, so their names are read the first time they are seen.
+            if (s.options.threadNames && !s.threadNames.contains(slot.tid)) {
+                s.threadNames.emplace(slot.tid, threadName(slot.tid));
+            }
+            slot.sequence.store(s.dequeuePos + s.mask + 1, std::memory_order_release);
+            s.dequeuePos++;
+        }
+    }
+
+    void aggregate(Session* s) {
+        std::unique_lock lock(s->mutex);
+        while (!s->stopping) {
+            s->wake.wait_for(lock, std::chrono::milliseconds(50));
+            drain(*s);
+        }
+        drain(*s);
+    }
+
+    std::string describeFrame(uintptr_t pc) {
+        auto frame = backtrace_helpers::describeFrame(reinterpret_cast<void*>(pc));
+        // ';' separates frames in the folded format.
+        std::replace(frame.begin(), frame.end(), ';', ':');
+        return frame;
+    }
+
+    // Symbolizes and writes the aggregated stacks. Called with the session mutex held.
+    bool write(Session& s) {
+        std::unordered_map<uintptr_t, std::string> frameNames;
+        auto frameName = [&](uintptr_t pc) -> std::string const& {
+            auto itr = frameNames.find(pc);
+            if (itr == frameNames.end()) {
+                itr = frameNames.emplace(pc, describeFrame(pc)).first;
+            }
+            return itr->second;
+        };
+        // Different addresses (and threads of the same name) can fold into the same line.
+        std::map<std::string, uint64_t> lines;
+        std::string line;
+        for (auto const& [stack, count] : s.stacks) {
+            line.clear();
+            if (s.options.threadNames) {
+                auto itr = s.threadNames.find(static_cast<pid_t>(stack[0]));
+                line = itr != s.threadNames.end() ? itr->second : "?";
+            }
+            // Return addresses point after the call, so step back into it to symbolize the caller. stack[1] is the interrupted pc itself.
+            for (std::size_t i = stack.size() - 1; i >= 1; i--) {
+                if (!line.empty()) {
+                    line += ';';
+                }
+                line += frameName(i == 1 ? stack[i] : stack[i] - 1);
+            }
+            lines[line] += count;
+        }
+        std::ofstream out(s.outputPath, std::ios::trunc);
+        if (!out) {
+            getLogger().error("Could not open %s for writing!", s.outputPath.c_str());
+            return false;
+        }
+        for (auto const& [stack, count] : lines) {
+            out << stack << ' ' << count << '\n';
+        }
+        out.close();
+        getLogger().info("Wrote %zu stacks from %lu samples (%lu dropped) to %s", lines.size(),
+            static_cast<unsigned long>(s.samples.load()), static_cast<unsigned long>(s.dropped.load()), s.outputPath.c_str());
+        return !out.fail();
+    }
+
+    SamplingProfilerStats statsOf(Session& s) {
+        std::lock_guard lock(s.mutex);
+        return {s.samples.load(), s.dropped.load(), s.stacks.size()};
+    }
+}
+
+bool SamplingProfiler::Start(std::string_view outputPath, SamplingProfilerOptions options) noexcept {
+    std::lock_guard control(controlMutex);
+    if (session) {
+        getLogger().warning("Already profiling to %s!", session->outputPath.c_str());
+        return false;
+    }
+    if (options.frequency == 0 || options.maxDepth == 0) {
+        getLogger().error("Invalid options: frequency and maxDepth must be non-zero!");
+        return false;
+    }
+    uint64_t ringSize = 1;
+    while (ringSize < options.ringSize) {
+        ringSize <<= 1;
+    }
+    auto s = std::make_unique<Session>();
+    s->options = options;
+    s->outputPath = outputPath;
+    s->mask = ringSize - 1;
+    s->slots = std::make_unique<Slot[]>(ringSize);
+    s->frames = std::make_unique<uintptr_t[]>(ringSize * options.maxDepth);
+    for (uint64_t i = 0; i < ringSize; i++) {
+        s->slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    struct sigaction action = {};
+    action.sa_sigaction = onSample;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, &s->previous) != 0) {
+        getLogger().error("Could not install the SIGPROF handler: %s", strerror(errno));
+        return false;
+    }
+    sigevent event = {};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &s->timer) != 0) {
+        getLogger().error("Could not create the profiling timer: %s", strerror(errno));
+        sigaction(SIGPROF, &s->previous, nullptr);
+        return false;
+    }
+    active = s.get();
+    itimerspec interval = {};
+    // At least 1ns, a zero interval would disarm the timer.
+    auto period = std::max<uint64_t>(1000000000ull / options.frequency, 1);
+    interval.it_interval.tv_sec = static_cast<time_t>(period / 1000000000ull);
+    interval.it_interval.tv_nsec = static_cast<long>(period % 1000000000ull);
+    interval.it_value = interval.it_interval;
+    if (timer_settime(s->timer, 0, &interval, nullptr) != 0) {
+        getLogger().error("Could not arm the profiling timer: %s", strerror(errno));
+        timer_delete(s->timer);
+        if (s->previous.sa_handler == SIG_DFL) {
+            s->previous.sa_handler = SIG_IGN;
+        }
+        sigaction(SIGPROF, &s->previous, nullptr);
+        active = nullptr;
+        while (handlersRunning.load() != 0) {
+            std::this_thread::yield();
+        }
+        return false;
+    }
+    // Samples taken before the aggregator starts wait in the ring.
+    s->aggregator = std::thread(aggregate, s.get());
+    // The thread that starts profiling is usually one worth walking.
+    SamplingProfiler::RegisterThread();
+    getLogger().info("Profiling at %u Hz to %s", options.frequency, s->outputPath.c_str());
+    session = std::move(s);
+    return true;
+}
+
+bool SamplingProfiler::RegisterThread() noexcept {
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+        return false;
+    }
+    void* base;
+    size_t size;
+    bool found = pthread_attr_getstack(&attr, &base, &size) == 0;
+    pthread_attr_destroy(&attr);
+    if (!found) {
+        return false;
+    }
+    auto tid = gettid();
+    auto idx = static_cast<std::size_t>(tid) % threadStackSlots;
+    for (std::size_t i = 0; i < threadStackSlots; i++) {
+        auto& entry = threadStacks[(idx + i) % threadStackSlots];
+        auto entryTid = entry.tid.load(std::memory_order_acquire);
+        if (entryTid != tid && (entryTid != 0 || !entry.tid.compare_exchange_strong(entryTid, tid, std::memory_order_acq_rel))) {
+            continue;
+        }
+        // Narrowed to nothing first, so that the handler never sees the old low with the new high.
+        entry.high.store(0, std::memory_order_release);
+        entry.low.store(reinterpret_cast<uintptr_t>(base), std::memory_order_release);
+        entry.high.store(reinterpret_cast<uintptr_t>(base) + size, std::memory_order_release);
+        return true;
+    }
+    getLogger().warning("Too many threads registered, thread %d is not", tid);
+    return false;
+}
+
+bool SamplingProfiler::Start(const ModInfo& info, SamplingProfilerOptions options) noexcept {
+    return Start(getDataFilePath(info, "profile", "folded"), options);
+}
+
+std::string SamplingProfiler::Stop() noexcept {
+    std::lock_guard control(controlMutex);
+    if (!session) {
+        return {};
+    }
+    timer_delete(session->timer);
+    // A SIGPROF can still be pending on some thread. Rather than let the default action terminate the process, ignore it.
+    if (session->previous.sa_handler == SIG_DFL) {
+        session->previous.sa_handler = SIG_IGN;
+    }
+    sigaction(SIGPROF, &session->previous, nullptr);
+    active = nullptr;
+    while (handlersRunning.load() != 0) {
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard lock(session->mutex);
+        session->stopping = true;
+    }
+    session->wake.notify_one();
+    session->aggregator.join();
+
+    std::string path;
+    {
+        std::lock_guard lock(session->mutex);
+        if (write(*session)) {
+            path = session->outputPath;
+        }
+    }
+    lastStats = statsOf(*session);
+    session.reset();
+    return path;
+}
+
+bool SamplingProfiler::Flush() noexcept {
+    std::lock_guard control(controlMutex);
+    if (!session) {
+        return false;
+    }
+    std::lock_guard lock(session->mutex);
+    drain(*session);
+    return write(*session);
+}
+
+bool SamplingProfiler::IsRunning() noexcept {
+    std::lock_guard control(controlMutex);
+    return session != nullptr;
+}
+
+SamplingProfilerStats SamplingProfiler::GetStats() noexcept {
+    std::lock_guard control(controlMutex);
+    return session ? statsOf(*session) : lastStats;
+}
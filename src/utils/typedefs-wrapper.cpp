@@ -4,10 +4,103 @@
 #include "../../shared/utils/typedefs.h"
 #include <locale>
 #include <string.h>
+#include <algorithm>
+#include <utility>
 
 std::unordered_map<void*, size_t> Counter::addrRefCount;
 std::shared_mutex Counter::mutex;
 
+GCHandleGroup::GCHandleGroup(std::size_t capacity) {
+    reserve(capacity);
+}
+
+GCHandleGroup::GCHandleGroup(std::initializer_list<Il2CppObject*> objects) {
+    add(objects.begin(), objects.size());
+}
+
+GCHandleGroup::GCHandleGroup(GCHandleGroup&& other) noexcept : root(other.root), handle(other.handle), count(other.count) {
+    other.root = nullptr;
+    other.handle = 0;
+    other.count = 0;
+}
+
+GCHandleGroup& GCHandleGroup::operator=(GCHandleGroup&& other) noexcept {
+    if (this != &other) {
+        release();
+        root = std::exchange(other.root, nullptr);
+        handle = std::exchange(other.handle, 0);
+        count = std::exchange(other.count, 0);
+    }
+    return *this;
+}
+
+GCHandleGroup::~GCHandleGroup() {
+    release();
+}
+
+std::size_t GCHandleGroup::capacity() const noexcept {
+    return root ? root->max_length : 0;
+}
+
+void GCHandleGroup::reserve(std::size_t newCapacity) {
+    if (newCapacity <= capacity()) {
+        return;
+    }
+    il2cpp_functions::Init();
+    // Grow geometrically so that many single adds only reroot a logarithmic number of times.
+    newCapacity = std::max(newCapacity, std::max<std::size_t>(capacity() * 2, 16));
+    auto* newRoot = CRASH_UNLESS(il2cpp_functions::array_new(il2cpp_functions::defaults->object_class, newCapacity));
+    auto* dst = reinterpret_cast<Il2CppArraySize*>(newRoot)->vector;
+    if (root) {
+        auto* src = reinterpret_cast<Il2CppArraySize*>(root)->vector;
+        for (std::size_t i = 0; i < count; i++) {
+            il2cpp_functions::gc_wbarrier_set_field(newRoot, &dst[i], src[i]);
+        }
+    }
+    // Root the new array before dropping the old handle, so that held objects are never unreferenced.
+    auto newHandle = il2cpp_functions::gchandle_new(newRoot, false);
+    if (handle) {
+        il2cpp_functions::gchandle_free(handle);
+    }
+    root = newRoot;
+    handle = newHandle;
+}
+
+std::size_t GCHandleGroup::add(Il2CppObject* obj) {
+    return add(&obj, 1);
+}
+
+std::size_t GCHandleGroup::add(Il2CppObject* const* objects, std::size_t num) {
+    auto start = count;
+    reserve(count + num);
+    if (num == 0) {
+        return start;
+    }
+    auto* dst = reinterpret_cast<Il2CppArraySize*>(root)->vector;
+    for (std::size_t i = 0; i < num; i++) {
+        il2cpp_functions::gc_wbarrier_set_field(root, &dst[start + i], objects[i]);
+    }
+    count += num;
+    return start;
+}
+
+Il2CppObject* GCHandleGroup::get(std::size_t idx) const noexcept {
+    return reinterpret_cast<Il2CppObject*>(reinterpret_cast<Il2CppArraySize*>(root)->vector[idx]);
+}
+
+void GCHandleGroup::set(std::size_t idx, Il2CppObject* obj) noexcept {
+    il2cpp_functions::gc_wbarrier_set_field(root, &reinterpret_cast<Il2CppArraySize*>(root)->vector[idx], obj);
+}
+
+void GCHandleGroup::release() noexcept {
+    if (handle) {
+        il2cpp_functions::gchandle_free(handle);
+    }
+    root = nullptr;
+    handle = 0;
+    count = 0;
+}
+
 namespace il2cpp_utils {
 namespace detail {
     template<class Facet>
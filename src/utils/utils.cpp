@@ -4,16 +4,23 @@
 #include <sys/stat.h>
 
 #include <unistd.h>
+#include <fcntl.h>
 #include <dlfcn.h>
+#include <cerrno>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <unordered_set>
+#include <atomic>
 #include "il2cpp-object-internals.h"
 #include "modloader/shared/modloader.hpp"
 #include "shared/utils/gc-alloc.hpp"
 
 namespace backtrace_helpers {
+    static std::atomic<ManagedFrameSymbolizer> managedSymbolizer = nullptr;
+    // Set by safeAbort, the backtrace it logs must not build anything that could take an il2cpp lock the aborting thread holds
+    static thread_local bool aborting = false;
+
     _Unwind_Reason_Code unwindCallback(struct _Unwind_Context *context, void *arg) {
         BacktraceState *state = static_cast<BacktraceState *>(arg);
         uintptr_t pc = _Unwind_GetIP(context);
@@ -36,6 +43,45 @@ namespace backtrace_helpers {
 
         return state.current - buffer;
     }
+    bool symbolizeFrame(const void* pc, FrameSymbol& out) {
+        Dl_info info;
+        if (!dladdr(pc, &info)) {
+            return false;
+        }
+        out.library = info.dli_fname;
+        out.offset = reinterpret_cast<uintptr_t>(pc) - reinterpret_cast<uintptr_t>(info.dli_fbase);
+        out.symbol.clear();
+        if (info.dli_sname) {
+            int status;
+            char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            if (status) {
+                out.symbol = info.dli_sname;
+            } else {
+                out.symbol = demangled;
+                free(demangled);
+            }
+        } else if (auto symbolizer = managedSymbolizer.load(std::memory_order_acquire)) {
+            symbolizer(pc, !aborting, out.symbol);
+        }
+        return true;
+    }
+    std::string describeFrame(const void* pc) {
+        FrameSymbol symbol;
+        if (!symbolizeFrame(pc, symbol)) {
+            return string_format("0x%lx", static_cast<unsigned long>(reinterpret_cast<uintptr_t>(pc)));
+        }
+        std::string_view library = symbol.library ? symbol.library : "?";
+        if (auto slash = library.find_last_of('/'); slash != std::string_view::npos) {
+            library.remove_prefix(slash + 1);
+        }
+        if (symbol.symbol.empty()) {
+            return string_format("%.*s+0x%lx", static_cast<int>(library.size()), library.data(), static_cast<unsigned long>(symbol.offset));
+        }
+        return std::string(library) + "!" + symbol.symbol;
+    }
+    void setManagedFrameSymbolizer(ManagedFrameSymbolizer symbolizer) {
+        managedSymbolizer.store(symbolizer, std::memory_order_release);
+    }
 }
 
 void safeAbort(const char* func, const char* file, int line, uint16_t frameCount) {
@@ -46,6 +92,7 @@ void safeAbort(const char* func, const char* file, int line, uint16_t frameCount
         // TODO: Make this eventually have a passed in context
         logger.critical("Aborting in %s at %s:%i", func, file, line);
     }
+    backtrace_helpers::aborting = true;
     logger.Backtrace(frameCount);
     Logger::closeAll();
     usleep(100000L);  // 0.1s
@@ -64,6 +111,7 @@ __attribute__((format(printf, 4, 5))) void safeAbortMsg(const char* func, const
         logger.log_v(Logging::CRITICAL, fmt, lst);
         va_end(lst);
     }
+    backtrace_helpers::aborting = true;
     logger.Backtrace(512);
     Logger::closeAll();
     usleep(100000L);  // 0.1s
@@ -241,7 +289,35 @@ uintptr_t getRealOffset(const void* offset) // calculate dump.cs address + lib.s
 }
 
 int mkpath(std::string_view file_path) {
-    return system((std::string("mkdir -p -m +rw ") + file_path.data()).c_str());
+    // Walk the path one component at a time with mkdirat/openat instead of spawning a shell.
+    std::string path(file_path);
+    int dirFd = open(path.starts_with('/') ? "/" : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        return -1;
+    }
+    std::size_t start = 0;
+    while (start < path.size()) {
+        auto end = path.find('/', start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        if (end > start) {
+            auto component = path.substr(start, end - start);
+            if (mkdirat(dirFd, component.c_str(), 0777) != 0 && errno != EEXIST) {
+                close(dirFd);
+                return -1;
+            }
+            int next = openat(dirFd, component.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            close(dirFd);
+            if (next < 0) {
+                return -1;
+            }
+            dirFd = next;
+        }
+        start = end + 1;
+    }
+    close(dirFd);
+    return 0;
 }
 
 uintptr_t findPattern(uintptr_t dwAddress, const char* pattern, uintptr_t dwSearchRangeLen) {
@@ -409,31 +485,105 @@ bool direxists(std::string_view dirname) {
     return false;
 }
 
+// Reads the rest of fd into out, which is sized to the file up front when the size is known.
+// Files that report no size (ex: procfs) are read in chunks until EOF instead.
+template<class Container>
+static bool readAll(int fd, Container& out) {
+    struct stat st;
+    std::size_t expected = (fstat(fd, &st) == 0 && st.st_size > 0) ? static_cast<std::size_t>(st.st_size) : 0;
+    out.resize(expected > 0 ? expected : 4096);
+    std::size_t total = 0;
+    while (true) {
+        if (total == out.size()) {
+            if (expected > 0 && total == expected) {
+                // Probe for growth since the fstat, without reallocating in the common case.
+                char probe;
+                auto count = read(fd, &probe, 1);
+                if (count == 0) {
+                    break;
+                }
+                if (count < 0 && errno != EINTR) {
+                    return false;
+                }
+                if (count > 0) {
+                    out.resize(out.size() * 2);
+                    out[total++] = probe;
+                }
+                continue;
+            }
+            out.resize(out.size() * 2);
+        }
+        auto count = read(fd, out.data() + total, out.size() - total);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        total += count;
+    }
+    out.resize(total);
+    return true;
+}
+
 std::string readfile(std::string_view filename) {
-    std::ifstream t(filename.data());
-    if (!t.is_open()) {
+    int fd = open(filename.data(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
         return "";
     }
-    std::stringstream buffer;
-    buffer << t.rdbuf();
-    return buffer.str();
+    std::string buffer;
+    if (!readAll(fd, buffer)) {
+        buffer.clear();
+    }
+    close(fd);
+    return buffer;
 }
 
 std::vector<char> readbytes(std::string_view filename) {
-    std::ifstream infile(filename.data(), std::ios_base::binary);
-    if (!infile.is_open()) {
+    int fd = open(filename.data(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
         return std::vector<char>();
     }
-    return std::vector<char>(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+    std::vector<char> buffer;
+    if (!readAll(fd, buffer)) {
+        buffer.clear();
+    }
+    close(fd);
+    return buffer;
 }
 
-bool writefile(std::string_view filename, std::string_view text) {
-    std::ofstream t(filename.data());
-    if (t.is_open()) {
-        t << text;
-        return true;
+static bool writeAll(std::string_view filename, std::string_view text, bool sync) {
+    int fd = open(filename.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return false;
     }
-    return false;
+    auto* ptr = text.data();
+    auto remaining = text.size();
+    while (remaining > 0) {
+        auto count = write(fd, ptr, remaining);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            close(fd);
+            return false;
+        }
+        ptr += count;
+        remaining -= count;
+    }
+    bool ok = !sync || fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+}
+
+bool writefile(std::string_view filename, std::string_view text) {
+    return writeAll(filename, text, false);
+}
+
+bool writefileSync(std::string_view filename, std::string_view text) {
+    return writeAll(filename, text, true);
 }
 
 bool deletefile(std::string_view filename) {